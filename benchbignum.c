@@ -0,0 +1,994 @@
+/*
+ * Benchmarks for the bignum library.
+ *
+ * Each operation is timed at operand sizes from one word up to
+ * BIGNUM_MAX_WORDS.  A case is calibrated to a batch size which runs
+ * for at least --sample-ms, warmed up with one more batch, and then
+ * timed over --samples batches.  The median and percentiles of the
+ * per-operation times are reported as text, CSV or JSON.
+ *
+ * All that has to fit in --budget-ms, so slow cases take fewer
+ * samples, and once a single call of an operation overruns the
+ * budget its larger sizes are skipped.
+ *
+ * --trials repeats the whole run, pooling each case's samples.  The
+ * trials of a case are a run apart, so the spread of their medians
+ * shows how much the machine drifts, which is usually more than the
+ * spread within one trial.
+ *
+ * --save keeps a run's results, samples and all, and --compare
+ * checks a later run against them.  A case has regressed when its
+ * samples are significantly slower than the baseline's (by a one
+ * sided Mann-Whitney U test), and its median is slower by more than
+ * --threshold plus twice the noise.  The noise of each side is the
+ * larger of the relative spread of its samples (scaled median
+ * absolute deviation) and of its trial medians (standard deviation),
+ * so unsteady cases need bigger slowdowns to count.  The exit status
+ * is then 1 if anything regressed.
+ *
+ * The default build is -O0, which is fine for relative comparisons
+ * but says little about real throughput.  Build with optimisation
+ * for that:
+ *
+ *   make clean && make bench CFLAGS='-O2 -std=gnu99'
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "bignum.h"
+#include "bignum-str.h"
+#include "handy.h"
+
+/* --- Operands --- */
+
+typedef struct
+{
+  size_t words;
+
+  /* a, b and e have words words, with the top bit set.  m is the
+   * same size and odd, and a, b < m.  wide has twice the words. */
+  bignum a, b, e, m, wide;
+
+  /* Results. */
+  bignum r, q;
+
+  /* a, formatted for the parse benchmarks. */
+  char *text;
+  size_t text_len;
+
+  /* Formatting output. */
+  char *buf;
+  size_t buf_len;
+} operands;
+
+static uint64_t rng_state = 0x9e3779b97f4a7c15ull;
+
+/* xorshift64*: fixed seed, so every run times the same values. */
+static uint32_t rng(void)
+{
+  rng_state ^= rng_state >> 12;
+  rng_state ^= rng_state << 25;
+  rng_state ^= rng_state >> 27;
+  return (uint32_t) ((rng_state * 0x2545f4914f6cdd1dull) >> 32);
+}
+
+static error random_words(bignum *b, size_t words)
+{
+  ER(bignum_cleartop(b, words));
+  for (size_t i = 0; i < words; i++)
+    b->v[i] = rng();
+  b->v[words - 1] |= 0x80000000;
+  bignum_canon(b);
+  return OK;
+}
+
+static error operands_init(operands *o, size_t words)
+{
+  memset(o, 0, sizeof *o);
+  o->words = words;
+
+  bignum *all[] = { &o->a, &o->b, &o->e, &o->m, &o->wide, &o->r, &o->q };
+  for (size_t i = 0; i < ARRAYCOUNT(all); i++)
+    ER(bignum_init_growable(all[i], 2 * words + 2, NULL));
+
+  ER(random_words(&o->a, words));
+  ER(random_words(&o->b, words));
+  ER(random_words(&o->e, words));
+  ER(random_words(&o->m, words));
+  ER(random_words(&o->wide, 2 * words));
+
+  /* m has all the top bits a and b might, so a, b < m. */
+  o->m.v[0] |= 1;
+  o->m.v[words - 1] = 0xffffffff;
+  o->a.v[words - 1] &= 0xfffffffe;
+  o->b.v[words - 1] &= 0xfffffffe;
+
+  /* Decimal needs fewer than ten digits per word. */
+  o->buf_len = words * 10 + 8;
+  o->buf = malloc(o->buf_len);
+  o->text = malloc(o->buf_len);
+  if (!o->buf || !o->text)
+    return error_bignum_sz;
+
+  return OK;
+}
+
+static void operands_clear(operands *o)
+{
+  bignum *all[] = { &o->a, &o->b, &o->e, &o->m, &o->wide, &o->r, &o->q };
+  for (size_t i = 0; i < ARRAYCOUNT(all); i++)
+    if (all[i]->v)
+      bignum_clear(all[i]);
+  free(o->buf);
+  free(o->text);
+}
+
+/* --- Operations --- */
+
+static error setup_none(operands *o)
+{
+  return OK;
+}
+
+static error setup_modinv(operands *o)
+{
+  /* Nudge a until it has an inverse. */
+  while (bignum_modinv(&o->r, &o->a, &o->m) == error_no_inverse)
+    ER(bignum_add(&o->a, &o->a, &bignum_1));
+  return OK;
+}
+
+static error setup_hex(operands *o)
+{
+  ER(bignum_fmt_hex(&o->a, o->text, o->buf_len));
+  o->text_len = strlen(o->text);
+  return OK;
+}
+
+static error setup_dec(operands *o)
+{
+  ER(bignum_fmt_dec(&o->a, o->text, o->buf_len));
+  o->text_len = strlen(o->text);
+  return OK;
+}
+
+static error run_add(operands *o) { return bignum_add(&o->r, &o->a, &o->b); }
+static error run_sub(operands *o) { return bignum_sub(&o->r, &o->a, &o->b); }
+static error run_mul(operands *o) { return bignum_mul(&o->r, &o->a, &o->b); }
+static error run_sqr(operands *o) { return bignum_sqr(&o->r, &o->a); }
+static error run_divmod(operands *o) { return bignum_divmod(&o->q, &o->r, &o->wide, &o->b); }
+static error run_mod(operands *o) { return bignum_mod(&o->r, &o->wide, &o->b); }
+static error run_modmul(operands *o) { return bignum_modmul(&o->r, &o->a, &o->b, &o->m); }
+static error run_modexp(operands *o) { return bignum_modexp(&o->r, &o->a, &o->e, &o->m); }
+static error run_gcd(operands *o) { return bignum_gcd(&o->r, &o->a, &o->b); }
+static error run_modinv(operands *o) { return bignum_modinv(&o->r, &o->a, &o->m); }
+static error run_fmt_hex(operands *o) { return bignum_fmt_hex(&o->a, o->buf, o->buf_len); }
+static error run_fmt_dec(operands *o) { return bignum_fmt_dec(&o->a, o->buf, o->buf_len); }
+static error run_parse_hex(operands *o) { return bignum_parse_strl(&o->r, o->text, o->text_len); }
+static error run_parse_dec(operands *o) { return bignum_parse_strl(&o->r, o->text, o->text_len); }
+
+/* The shifts are in place, so these include the copy a caller
+ * keeping its operand would make. */
+static error run_shl(operands *o)
+{
+  ER(bignum_dup(&o->r, &o->a));
+  return bignum_shl(&o->r, 33);
+}
+
+static error run_shr(operands *o)
+{
+  ER(bignum_dup(&o->r, &o->a));
+  return bignum_shr(&o->r, 33);
+}
+
+typedef struct
+{
+  const char *name;
+  const char *desc;
+  error (*setup)(operands *o);
+  error (*run)(operands *o);
+} bench_op;
+
+static const bench_op ops[] = {
+  { "add", "r = a + b", setup_none, run_add },
+  { "sub", "r = a - b", setup_none, run_sub },
+  { "mul", "r = a * b", setup_none, run_mul },
+  { "sqr", "r = a^2", setup_none, run_sqr },
+  { "divmod", "q, r = divmod(a, b), with a of twice the words", setup_none, run_divmod },
+  { "mod", "r = a mod b, with a of twice the words", setup_none, run_mod },
+  { "shl", "r = a << 33", setup_none, run_shl },
+  { "shr", "r = a >> 33", setup_none, run_shr },
+  { "modmul", "r = a * b mod m, m odd", setup_none, run_modmul },
+  { "modexp", "r = a^e mod m, m odd", setup_none, run_modexp },
+  { "gcd", "r = gcd(a, b)", setup_none, run_gcd },
+  { "modinv", "r = a^-1 mod m, m odd", setup_modinv, run_modinv },
+  { "fmt_hex", "format a in hex", setup_none, run_fmt_hex },
+  { "parse_hex", "parse a from hex", setup_hex, run_parse_hex },
+  { "fmt_dec", "format a in decimal", setup_none, run_fmt_dec },
+  { "parse_dec", "parse a from decimal", setup_dec, run_parse_dec },
+};
+
+/* --- Timing --- */
+
+typedef struct
+{
+  const char *op;
+  size_t words;
+  size_t iterations;
+  size_t count;
+  double *samples;
+  double min, p10, median, p90, max;
+
+  /* The median of each trial. */
+  size_t trials;
+  double *trial_medians;
+} result;
+
+typedef struct
+{
+  result *r;
+  size_t n, cap;
+} result_list;
+
+static struct
+{
+  unsigned samples;
+  unsigned trials;
+  double sample_ns;
+  double budget_ns;
+  double threshold;
+  double alpha;
+} config = { 11, 1, 5e6, 2e9, 0.05, 0.01 };
+
+static double now_ns(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/* Sets *ns to the time for iterations calls of op. */
+static error time_batch(const bench_op *op, operands *o, size_t iterations, double *ns)
+{
+  double start = now_ns();
+  for (size_t i = 0; i < iterations; i++)
+    ER(op->run(o));
+  *ns = now_ns() - start;
+  return OK;
+}
+
+static void *xrealloc(void *ptr, size_t bytes)
+{
+  ptr = realloc(ptr, bytes);
+  if (!ptr)
+    abort();
+  return ptr;
+}
+
+static int cmp_double(const void *a, const void *b)
+{
+  double x = *(const double *) a, y = *(const double *) b;
+  return (x > y) - (x < y);
+}
+
+/* The pth percentile of sorted[:n], interpolating between
+ * neighbours. */
+static double percentile(const double *sorted, size_t n, double p)
+{
+  double pos = p / 100 * (n - 1);
+  size_t lo = (size_t) pos;
+  if (lo + 1 >= n)
+    return sorted[n - 1];
+  return sorted[lo] + (pos - lo) * (sorted[lo + 1] - sorted[lo]);
+}
+
+/* Fills in res's statistics from its samples. */
+static void summarise(result *res)
+{
+  size_t n = res->count;
+  double *sorted = xrealloc(NULL, n * sizeof *sorted);
+  memcpy(sorted, res->samples, n * sizeof *sorted);
+  qsort(sorted, n, sizeof *sorted, cmp_double);
+
+  res->min = sorted[0];
+  res->p10 = percentile(sorted, n, 10);
+  res->median = percentile(sorted, n, 50);
+  res->p90 = percentile(sorted, n, 90);
+  res->max = sorted[n - 1];
+  free(sorted);
+}
+
+/* Runs one trial of op, adding its samples to res.  Calibrating
+ * and settling count against the budget, and a case which uses it
+ * all up takes its last calibration batch as its only sample. */
+static error measure(const bench_op *op, operands *o, result *res)
+{
+  double start = now_ns();
+
+  /* Calibrate, which also warms up caches and growable storage. */
+  size_t iterations = 1;
+  double t;
+  for (;;)
+  {
+    ER(time_batch(op, o, iterations, &t));
+    if (t >= config.sample_ns || iterations >= (1u << 30) ||
+        now_ns() - start >= config.budget_ns)
+      break;
+    iterations *= 2;
+  }
+
+  /* One more to settle, then as many samples as the rest of the
+   * budget allows, but at least one. */
+  size_t count = 1;
+  unsigned spent = now_ns() - start + t > config.budget_ns;
+  if (!spent)
+  {
+    ER(time_batch(op, o, iterations, &t));
+    double left = config.budget_ns - (now_ns() - start);
+    count = config.samples;
+    if (t * count > left)
+      count = MAX((size_t) (left / t), (size_t) 1);
+  }
+
+  res->samples = xrealloc(res->samples, (res->count + count) * sizeof *res->samples);
+  double *trial = res->samples + res->count;
+  for (size_t i = 0; i < count; i++)
+  {
+    if (!spent)
+      ER(time_batch(op, o, iterations, &t));
+    trial[i] = t / iterations;
+  }
+
+  /* The trial's median, before it's pooled. */
+  result one = { .count = count, .samples = trial };
+  summarise(&one);
+  res->trial_medians = xrealloc(res->trial_medians, (res->trials + 1) * sizeof *res->trial_medians);
+  res->trial_medians[res->trials++] = one.median;
+
+  res->op = op->name;
+  res->words = o->words;
+  res->iterations = iterations;
+  res->count += count;
+  summarise(res);
+  return OK;
+}
+
+/* Runs a trial of op at words words. */
+static error run_case(const bench_op *op, size_t words, result *res)
+{
+  operands o;
+  error err = operands_init(&o, words);
+  if (!err)
+    err = op->setup(&o);
+  if (!err)
+    err = measure(op, &o, res);
+  operands_clear(&o);
+  return err;
+}
+
+static result *find_result(const result_list *l, const char *op, size_t words)
+{
+  for (size_t i = 0; i < l->n; i++)
+    if (!strcmp(l->r[i].op, op) && l->r[i].words == words)
+      return &l->r[i];
+  return NULL;
+}
+
+/* Appends r to l, which takes over its samples. */
+static void add_result(result_list *l, const result *r)
+{
+  if (l->n == l->cap)
+  {
+    l->cap = l->cap ? 2 * l->cap : 64;
+    l->r = xrealloc(l->r, l->cap * sizeof *l->r);
+  }
+  l->r[l->n++] = *r;
+}
+
+static void free_results(result_list *l)
+{
+  for (size_t i = 0; i < l->n; i++)
+  {
+    free(l->r[i].samples);
+    free(l->r[i].trial_medians);
+  }
+  free(l->r);
+}
+
+/* --- Output --- */
+
+typedef enum { FORMAT_TEXT, FORMAT_CSV, FORMAT_JSON } format;
+
+static void emit_header(FILE *f, format fmt)
+{
+  switch (fmt)
+  {
+    case FORMAT_TEXT:
+      fprintf(f, "%-10s %6s %6s %10s %7s %14s %14s %14s %14s\n",
+              "op", "words", "bits", "iters", "samples",
+              "p10 ns/op", "median ns/op", "p90 ns/op", "ops/sec");
+      break;
+    case FORMAT_CSV:
+      fprintf(f, "op,words,bits,iterations,samples,min_ns,p10_ns,median_ns,p90_ns,max_ns,ops_per_sec\n");
+      break;
+    case FORMAT_JSON:
+      fprintf(f, "{\n  \"word_bits\": %d,\n  \"max_words\": %d,\n  \"results\": [",
+              BIGNUM_BITS, BIGNUM_MAX_WORDS);
+      break;
+  }
+}
+
+/* JSON results are one to a line, which is what load_results
+ * expects. */
+static void emit_result(FILE *f, format fmt, const result *r, unsigned first)
+{
+  double ops_per_sec = 1e9 / r->median;
+
+  switch (fmt)
+  {
+    case FORMAT_TEXT:
+      fprintf(f, "%-10s %6zu %6zu %10zu %7zu %14.1f %14.1f %14.1f %14.4g\n",
+              r->op, r->words, r->words * BIGNUM_BITS, r->iterations, r->count,
+              r->p10, r->median, r->p90, ops_per_sec);
+      break;
+    case FORMAT_CSV:
+      fprintf(f, "%s,%zu,%zu,%zu,%zu,%.1f,%.1f,%.1f,%.1f,%.1f,%.1f\n",
+              r->op, r->words, r->words * BIGNUM_BITS, r->iterations, r->count,
+              r->min, r->p10, r->median, r->p90, r->max, ops_per_sec);
+      break;
+    case FORMAT_JSON:
+      fprintf(f, "%s\n    {\"op\": \"%s\", \"words\": %zu, \"bits\": %zu, "
+              "\"iterations\": %zu, \"min_ns\": %.1f, \"p10_ns\": %.1f, "
+              "\"median_ns\": %.1f, \"p90_ns\": %.1f, \"max_ns\": %.1f, "
+              "\"ops_per_sec\": %.1f, \"samples_ns\": [",
+              first ? "" : ",",
+              r->op, r->words, r->words * BIGNUM_BITS, r->iterations,
+              r->min, r->p10, r->median, r->p90, r->max, ops_per_sec);
+      for (size_t i = 0; i < r->count; i++)
+        fprintf(f, "%s%.1f", i ? ", " : "", r->samples[i]);
+      fprintf(f, "], \"trial_medians_ns\": [");
+      for (size_t i = 0; i < r->trials; i++)
+        fprintf(f, "%s%.1f", i ? ", " : "", r->trial_medians[i]);
+      fprintf(f, "]}");
+      break;
+  }
+  fflush(f);
+}
+
+static void emit_footer(FILE *f, format fmt)
+{
+  if (fmt == FORMAT_JSON)
+    fprintf(f, "\n  ]\n}\n");
+}
+
+static int save_results(const char *path, const result_list *l)
+{
+  FILE *f = fopen(path, "w");
+  if (!f)
+  {
+    perror(path);
+    return -1;
+  }
+
+  emit_header(f, FORMAT_JSON);
+  for (size_t i = 0; i < l->n; i++)
+    emit_result(f, FORMAT_JSON, &l->r[i], i == 0);
+  emit_footer(f, FORMAT_JSON);
+
+  if (fclose(f))
+  {
+    perror(path);
+    return -1;
+  }
+  return 0;
+}
+
+/* Reads the numbers in the JSON array following key in line into
+ * *v, returning how many there were. */
+static size_t load_array(const char *line, const char *key, double **v)
+{
+  const char *p = strstr(line, key);
+  size_t n = 0;
+
+  if (!p)
+    return 0;
+
+  p += strlen(key);
+  while (*p != ']')
+  {
+    char *end;
+    double x = strtod(p, &end);
+    if (end == p)
+      break;
+    *v = xrealloc(*v, (n + 1) * sizeof **v);
+    (*v)[n++] = x;
+    p = end + strspn(end, ", ");
+  }
+  return n;
+}
+
+/* Reads results written by save_results.  Only the op, words,
+ * iterations and samples are read: the statistics are worked out
+ * again. */
+static int load_results(const char *path, result_list *l)
+{
+  FILE *f = fopen(path, "r");
+  if (!f)
+  {
+    perror(path);
+    return -1;
+  }
+
+  char *line = NULL;
+  size_t line_sz = 0;
+  while (getline(&line, &line_sz, f) != -1)
+  {
+    char name[32];
+    result r = { 0 };
+    int used = 0;
+
+    if (sscanf(line, " {\"op\": \"%31[^\"]\", \"words\": %zu, \"bits\": %*u, \"iterations\": %zu, %n",
+               name, &r.words, &r.iterations, &used) != 3 || !used)
+      continue;
+
+    for (size_t j = 0; j < ARRAYCOUNT(ops); j++)
+      if (!strcmp(ops[j].name, name))
+        r.op = ops[j].name;
+    if (!r.op)
+    {
+      fprintf(stderr, "%s: skipping unknown operation '%s'\n", path, name);
+      continue;
+    }
+
+    r.count = load_array(line + used, "\"samples_ns\": [", &r.samples);
+    r.trials = load_array(line + used, "\"trial_medians_ns\": [", &r.trial_medians);
+    if (!r.count)
+    {
+      free(r.samples);
+      free(r.trial_medians);
+      continue;
+    }
+
+    summarise(&r);
+    add_result(l, &r);
+  }
+
+  free(line);
+  fclose(f);
+
+  if (!l->n)
+  {
+    fprintf(stderr, "%s: no results found\n", path);
+    return -1;
+  }
+  return 0;
+}
+
+/* --- Comparison --- */
+
+/* Relative spread of r's samples: the median absolute deviation,
+ * scaled to estimate a standard deviation for normal noise, over the
+ * median. */
+static double spread(const result *r)
+{
+  double *dev = xrealloc(NULL, r->count * sizeof *dev);
+  for (size_t i = 0; i < r->count; i++)
+    dev[i] = fabs(r->samples[i] - r->median);
+  qsort(dev, r->count, sizeof *dev, cmp_double);
+  double mad = percentile(dev, r->count, 50);
+  free(dev);
+  return 1.4826 * mad / r->median;
+}
+
+/* The noise of r, as described at the top. */
+static double noise(const result *r)
+{
+  double n = spread(r);
+
+  if (r->trials >= 2)
+  {
+    double mean = 0, var = 0;
+    for (size_t i = 0; i < r->trials; i++)
+      mean += r->trial_medians[i];
+    mean /= r->trials;
+    for (size_t i = 0; i < r->trials; i++)
+      var += (r->trial_medians[i] - mean) * (r->trial_medians[i] - mean);
+    var /= r->trials - 1;
+    n = MAX(n, sqrt(var) / mean);
+  }
+
+  return n;
+}
+
+/* One sided Mann-Whitney U test: the probability of y's samples
+ * ranking at least this far above x's if both came from the same
+ * distribution.  This uses the normal approximation, corrected for
+ * ties. */
+static double mann_whitney_p(const result *x, const result *y)
+{
+  size_t nx = x->count, ny = y->count, n = nx + ny;
+  double u = 0;
+
+  for (size_t i = 0; i < nx; i++)
+    for (size_t j = 0; j < ny; j++)
+      u += y->samples[j] > x->samples[i] ? 1 :
+           y->samples[j] == x->samples[i] ? 0.5 : 0;
+
+  double *all = xrealloc(NULL, n * sizeof *all);
+  memcpy(all, x->samples, nx * sizeof *all);
+  memcpy(all + nx, y->samples, ny * sizeof *all);
+  qsort(all, n, sizeof *all, cmp_double);
+  double ties = 0;
+  for (size_t i = 0, j; i < n; i = j)
+  {
+    for (j = i + 1; j < n && all[j] == all[i]; j++)
+      ;
+    double t = j - i;
+    ties += t * t * t - t;
+  }
+  free(all);
+
+  double mean = nx * ny / 2.0;
+  double var = nx * ny / 12.0 * ((n + 1) - ties / (n * (n - 1.0)));
+  if (var <= 0)
+    return 1;
+
+  double z = (u - mean - 0.5) / sqrt(var);
+  return 0.5 * erfc(z / sqrt(2));
+}
+
+/* Prints how cur compares to base, and returns the number of cases
+ * which regressed. */
+static size_t compare_results(const result_list *base, const result_list *cur)
+{
+  size_t regressed = 0;
+
+  printf("%-10s %6s %14s %14s %8s %7s %9s  %s\n",
+         "op", "words", "base ns/op", "new ns/op", "change", "noise", "p", "");
+
+  for (size_t i = 0; i < cur->n; i++)
+  {
+    const result *c = &cur->r[i];
+    const result *b = find_result(base, c->op, c->words);
+    if (!b)
+    {
+      printf("%-10s %6zu %14s %14.1f %8s %7s %9s  new\n",
+             c->op, c->words, "-", c->median, "", "", "");
+      continue;
+    }
+
+    double change = c->median / b->median - 1;
+    double nb = noise(b), nc = noise(c);
+    double both = sqrt(nb * nb + nc * nc);
+    double p = mann_whitney_p(b, c);
+    double p_faster = mann_whitney_p(c, b);
+    double band = config.threshold + 2 * both;
+    const char *verdict = "";
+
+    if (p < config.alpha && change > band)
+    {
+      verdict = "REGRESSED";
+      regressed++;
+    } else if (p < config.alpha && change > 2 * both) {
+      verdict = "slower";
+    } else if (p_faster < config.alpha && -change > 2 * both) {
+      verdict = "faster";
+    }
+
+    printf("%-10s %6zu %14.1f %14.1f %+7.1f%% %6.1f%% %9.2g  %s\n",
+           c->op, c->words, b->median, c->median,
+           change * 100, both * 100, p, verdict);
+  }
+
+  for (size_t i = 0; i < base->n; i++)
+    if (!find_result(cur, base->r[i].op, base->r[i].words))
+      printf("%-10s %6zu %14.1f %14s %8s %7s %9s  missing\n",
+             base->r[i].op, base->r[i].words, base->r[i].median, "-", "", "", "");
+
+  /* Per operation, the geometric mean of the changes. */
+  printf("\n%-10s %8s\n", "op", "change");
+  for (size_t j = 0; j < ARRAYCOUNT(ops); j++)
+  {
+    double logs = 0;
+    size_t n = 0;
+    for (size_t i = 0; i < cur->n; i++)
+    {
+      const result *c = &cur->r[i];
+      const result *b = find_result(base, c->op, c->words);
+      if (c->op == ops[j].name && b)
+      {
+        logs += log(c->median / b->median);
+        n++;
+      }
+    }
+    if (n)
+      printf("%-10s %+7.1f%%\n", ops[j].name, (exp(logs / n) - 1) * 100);
+  }
+
+  printf("\n%zu regressed (threshold %.1f%% plus twice the noise, p < %g)\n",
+         regressed, config.threshold * 100, config.alpha);
+  return regressed;
+}
+
+/* --- Driver --- */
+
+static void usage(FILE *out)
+{
+  fprintf(out,
+          "usage: benchbignum [options]\n"
+          "\n"
+          "  --format text|csv|json  output format (text)\n"
+          "  --ops LIST              comma separated operations (all)\n"
+          "  --words LIST            comma separated operand sizes, in words\n"
+          "                          (powers of two up to %d)\n"
+          "  --samples N             timed batches per trial (%u)\n"
+          "  --trials N              times to repeat the run, pooling the\n"
+          "                          samples (%u)\n"
+          "  --sample-ms MS          least duration of a batch (%.0f)\n"
+          "  --budget-ms MS          time for each case, after which it\n"
+          "                          takes fewer samples, down to one, and\n"
+          "                          larger sizes of the operation are\n"
+          "                          skipped once one call takes longer (%.0f)\n"
+          "  --save FILE             also write the results to FILE\n"
+          "  --compare FILE          compare against results saved in FILE,\n"
+          "                          exiting with 1 if any regressed\n"
+          "  --load FILE             use results saved in FILE instead of\n"
+          "                          running\n"
+          "  --threshold PCT         slowdown beyond the noise which counts\n"
+          "                          as a regression (%.0f)\n"
+          "  --alpha P               significance level (%g)\n"
+          "  --list                  list the operations\n"
+          "\n",
+          BIGNUM_MAX_WORDS, config.samples, config.trials,
+          config.sample_ns / 1e6, config.budget_ns / 1e6,
+          config.threshold * 100, config.alpha);
+}
+
+/* Returns 1 if name is in the comma separated list, or list is
+ * NULL. */
+static unsigned in_list(const char *list, const char *name)
+{
+  if (!list)
+    return 1;
+
+  size_t len = strlen(name);
+  for (const char *p = list; p; p = strchr(p, ','))
+  {
+    if (*p == ',')
+      p++;
+    if (strncmp(p, name, len) == 0 && (p[len] == ',' || p[len] == 0))
+      return 1;
+  }
+  return 0;
+}
+
+static size_t parse_sizes(const char *list, size_t *sizes, size_t max)
+{
+  size_t n = 0;
+
+  if (!list)
+  {
+    for (size_t w = 1; w <= BIGNUM_MAX_WORDS && n < max; w *= 2)
+      sizes[n++] = w;
+    return n;
+  }
+
+  for (const char *p = list; *p && n < max; )
+  {
+    char *end;
+    unsigned long w = strtoul(p, &end, 10);
+    if (end == p || w == 0 || w > BIGNUM_MAX_WORDS || (*end && *end != ','))
+    {
+      fprintf(stderr, "bad operand size in '%s' (1 to %d words)\n", list, BIGNUM_MAX_WORDS);
+      exit(2);
+    }
+    sizes[n++] = w;
+    p = *end ? end + 1 : end;
+  }
+  return n;
+}
+
+static double parse_number(const char *opt, const char *arg)
+{
+  char *end;
+  double v = arg ? strtod(arg, &end) : 0;
+  if (!arg || *end || v <= 0)
+  {
+    fprintf(stderr, "%s needs a positive number\n", opt);
+    exit(2);
+  }
+  return v;
+}
+
+int main(int argc, char **argv)
+{
+  format fmt = FORMAT_TEXT;
+  const char *op_list = NULL, *size_list = NULL;
+  const char *save_path = NULL, *compare_path = NULL, *load_path = NULL;
+
+  for (int i = 1; i < argc; i++)
+  {
+    const char *opt = argv[i], *arg = i + 1 < argc ? argv[i + 1] : NULL;
+
+    if (!strcmp(opt, "--format") && arg)
+    {
+      if (!strcmp(arg, "text"))
+        fmt = FORMAT_TEXT;
+      else if (!strcmp(arg, "csv"))
+        fmt = FORMAT_CSV;
+      else if (!strcmp(arg, "json"))
+        fmt = FORMAT_JSON;
+      else
+      {
+        usage(stderr);
+        return 2;
+      }
+      i++;
+    } else if (!strcmp(opt, "--ops") && arg) {
+      op_list = arg;
+      i++;
+    } else if (!strcmp(opt, "--words") && arg) {
+      size_list = arg;
+      i++;
+    } else if (!strcmp(opt, "--samples")) {
+      config.samples = (unsigned) parse_number(opt, arg);
+      i++;
+    } else if (!strcmp(opt, "--trials")) {
+      config.trials = (unsigned) parse_number(opt, arg);
+      i++;
+    } else if (!strcmp(opt, "--sample-ms")) {
+      config.sample_ns = parse_number(opt, arg) * 1e6;
+      i++;
+    } else if (!strcmp(opt, "--budget-ms")) {
+      config.budget_ns = parse_number(opt, arg) * 1e6;
+      i++;
+    } else if (!strcmp(opt, "--threshold")) {
+      config.threshold = parse_number(opt, arg) / 100;
+      i++;
+    } else if (!strcmp(opt, "--alpha")) {
+      config.alpha = parse_number(opt, arg);
+      i++;
+    } else if (!strcmp(opt, "--save") && arg) {
+      save_path = arg;
+      i++;
+    } else if (!strcmp(opt, "--compare") && arg) {
+      compare_path = arg;
+      i++;
+    } else if (!strcmp(opt, "--load") && arg) {
+      load_path = arg;
+      i++;
+    } else if (!strcmp(opt, "--list")) {
+      for (size_t j = 0; j < ARRAYCOUNT(ops); j++)
+        printf("%-10s %s\n", ops[j].name, ops[j].desc);
+      return 0;
+    } else if (!strcmp(opt, "--help") || !strcmp(opt, "-h")) {
+      usage(stdout);
+      return 0;
+    } else {
+      usage(stderr);
+      return 2;
+    }
+  }
+
+  for (const char *p = op_list; p; p = strchr(p + 1, ','))
+  {
+    const char *name = *p == ',' ? p + 1 : p;
+    size_t len = strcspn(name, ",");
+    unsigned known = 0;
+    for (size_t j = 0; j < ARRAYCOUNT(ops); j++)
+      known |= strlen(ops[j].name) == len && !strncmp(ops[j].name, name, len);
+    if (!known)
+    {
+      fprintf(stderr, "unknown operation '%.*s' (see --list)\n", (int) len, name);
+      return 2;
+    }
+  }
+
+  size_t sizes[BIGNUM_MAX_WORDS];
+  size_t nsizes = parse_sizes(size_list, sizes, ARRAYCOUNT(sizes));
+
+  result_list base = { 0 }, cur = { 0 };
+  if (compare_path && load_results(compare_path, &base))
+    return 2;
+
+  /* Comparisons print their own report instead of the results. */
+  unsigned show = !compare_path;
+
+  if (load_path)
+  {
+    if (load_results(load_path, &cur))
+      return 2;
+    if (show)
+    {
+      emit_header(stdout, fmt);
+      for (size_t i = 0; i < cur.n; i++)
+        emit_result(stdout, fmt, &cur.r[i], i == 0);
+      emit_footer(stdout, fmt);
+    }
+  } else {
+    if (show)
+      emit_header(stdout, fmt);
+
+    /* Results are complete, and shown, in the last trial.  Sizes
+     * above one whose single call overran the budget in the first
+     * trial are skipped. */
+    size_t shown = 0;
+    size_t over[ARRAYCOUNT(ops)];
+    for (size_t j = 0; j < ARRAYCOUNT(ops); j++)
+      over[j] = SIZE_MAX;
+
+    for (unsigned t = 0; t < config.trials; t++)
+    {
+      unsigned last = t + 1 == config.trials;
+
+      for (size_t j = 0; j < ARRAYCOUNT(ops); j++)
+      {
+        if (!in_list(op_list, ops[j].name))
+          continue;
+
+        for (size_t s = 0; s < nsizes; s++)
+        {
+          if (sizes[s] > over[j])
+          {
+            if (t == 0)
+              fprintf(stderr, "%s at %zu words: over budget at %zu words, skipped\n",
+                      ops[j].name, sizes[s], over[j]);
+            continue;
+          }
+
+          result *res = find_result(&cur, ops[j].name, sizes[s]);
+          result fresh = { 0 };
+          error err = run_case(&ops[j], sizes[s], res ? res : &fresh);
+
+          /* Large cases can exhaust the thread's scratch arena. */
+          if (err == error_bignum_sz)
+          {
+            if (t == 0)
+              fprintf(stderr, "%s at %zu words: too big for this build, skipped\n",
+                      ops[j].name, sizes[s]);
+            free(fresh.samples);
+            free(fresh.trial_medians);
+            continue;
+          }
+          if (err)
+          {
+            fprintf(stderr, "%s at %zu words failed: error %d\n", ops[j].name, sizes[s], err);
+            return 2;
+          }
+
+          if (!res)
+          {
+            add_result(&cur, &fresh);
+            res = &cur.r[cur.n - 1];
+          }
+
+          if (t == 0 && res->iterations == 1 && res->median > config.budget_ns)
+            over[j] = MIN(over[j], sizes[s]);
+
+          if (show && last)
+            emit_result(stdout, fmt, res, shown++ == 0);
+        }
+      }
+    }
+
+    if (show)
+      emit_footer(stdout, fmt);
+  }
+
+  if (save_path && save_results(save_path, &cur))
+    return 2;
+
+  int rc = 0;
+  if (compare_path && compare_results(&base, &cur))
+    rc = 1;
+
+  free_results(&base);
+  free_results(&cur);
+  return rc;
+}
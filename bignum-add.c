@@ -49,6 +49,10 @@ error bignum_add_unsigned(bignum *r, const bignum *a, const bignum *b)
 {
   assert(!bignum_check_mutable(r));
 
+  /* r->vtop is reset below, so remember how much of r was used. */
+  r->dirty = MAX(r->dirty, bignum_len_words(r));
+  ER(bignum_grow(r, MAX(bignum_len_words(a), bignum_len_words(b)) + 1));
+
   uint32_t *atop = a->vtop;
   uint32_t *btop = b->vtop;
 
@@ -62,7 +66,7 @@ error bignum_add_unsigned(bignum *r, const bignum *a, const bignum *b)
     if (!have_a && !have_b && !carry)
       break;
 
-    if (rv - r->v >= r->words)
+    if ((size_t) (rv - r->v) >= r->words)
       return error_bignum_sz;
 
     uint32_t rw = carry;
@@ -0,0 +1,91 @@
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bignum.h"
+#include "handy.h"
+
+static void *malloc_alloc(void *ctx, size_t bytes)
+{
+  return malloc(bytes);
+}
+
+static void malloc_free(void *ctx, void *ptr, size_t bytes)
+{
+  free(ptr);
+}
+
+const bignum_allocator bignum_malloc_allocator = { malloc_alloc, malloc_free, NULL };
+
+/* The most words we'll ask for, so sizes in bytes don't overflow. */
+#define GROWABLE_MAX_WORDS (SIZE_MAX / BIGNUM_BYTES / 2)
+
+error bignum_init_growable(bignum *b, size_t words, const bignum_allocator *a)
+{
+  assert(b != NULL);
+
+  if (!a)
+    a = &bignum_malloc_allocator;
+
+  words = MAX(words, (size_t) 1);
+  if (words > GROWABLE_MAX_WORDS)
+    return error_bignum_sz;
+
+  uint32_t *v = a->alloc(a->ctx, words * BIGNUM_BYTES);
+  if (!v)
+    return error_bignum_sz;
+
+  *v = 0;
+  *b = (bignum) { v, v, words, BIGNUM_F_GROWABLE, 1, a };
+  return OK;
+}
+
+/* Moves b to new storage of at least words words.  The old storage
+ * is wiped, since it may have held secrets. */
+static error regrow(bignum *b, size_t words)
+{
+  const bignum_allocator *a = b->allocator;
+
+  if (words > GROWABLE_MAX_WORDS)
+    return error_bignum_sz;
+
+  /* Doubling keeps repeated growth linear. */
+  size_t new_words = MAX(words, MIN(2 * b->words, (size_t) GROWABLE_MAX_WORDS));
+  uint32_t *v = a->alloc(a->ctx, new_words * BIGNUM_BYTES);
+  if (!v)
+    return error_bignum_sz;
+
+  size_t used = MAX(b->dirty, bignum_len_words(b));
+  memcpy(v, b->v, used * BIGNUM_BYTES);
+  mem_clean(b->v, used * BIGNUM_BYTES);
+  a->free(a->ctx, b->v, b->words * BIGNUM_BYTES);
+
+  b->vtop = v + (b->vtop - b->v);
+  b->v = v;
+  b->words = new_words;
+  b->dirty = used;
+  return OK;
+}
+
+error bignum_reserve(bignum *b, size_t words)
+{
+  assert(!bignum_check_storage(b));
+  assert(!(b->flags & BIGNUM_F_IMMUTABLE));
+
+  if (words <= b->words)
+    return OK;
+  if (!(b->flags & BIGNUM_F_GROWABLE))
+    return error_bignum_sz;
+  return regrow(b, words);
+}
+
+error bignum_grow(bignum *b, size_t words)
+{
+  assert(!bignum_check_storage(b));
+  assert(!(b->flags & BIGNUM_F_IMMUTABLE));
+
+  if (words <= b->words || !(b->flags & BIGNUM_F_GROWABLE))
+    return OK;
+  return regrow(b, words);
+}
@@ -0,0 +1,105 @@
+#include <assert.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bignum.h"
+#include "handy.h"
+
+static __thread bignum_arena thread_arena;
+static __thread bignum_arena *thread_current;
+
+static pthread_once_t key_once = PTHREAD_ONCE_INIT;
+static pthread_key_t key;
+
+static void make_key(void)
+{
+  pthread_key_create(&key, free);
+}
+
+void bignum_arena_init(bignum_arena *a, uint32_t *words, size_t n)
+{
+  a->base = a->top = words;
+  a->end = words + n;
+}
+
+bignum_arena *bignum_arena_thread(void)
+{
+  if (thread_current)
+    return thread_current;
+
+  if (!thread_arena.base)
+  {
+    /* nb. if this fails, the arena stays empty and we try again
+     * next time. */
+    uint32_t *words = malloc(BIGNUM_ARENA_WORDS * sizeof *words);
+    if (!words)
+      return &thread_arena;
+
+    pthread_once(&key_once, make_key);
+    pthread_setspecific(key, words);
+    bignum_arena_init(&thread_arena, words, BIGNUM_ARENA_WORDS);
+  }
+
+  thread_current = &thread_arena;
+  return thread_current;
+}
+
+bignum_arena *bignum_arena_use(bignum_arena *a)
+{
+  bignum_arena *prev = thread_current;
+  thread_current = a;
+  return prev;
+}
+
+error bignum_arena_alloc(bignum_arena *a, bignum *b, size_t words)
+{
+  words = MAX(words, (size_t) 1);
+
+  if ((size_t) (a->end - a->top) < words)
+    return error_bignum_sz;
+
+#ifndef NDEBUG
+  /* Catch anyone reading words they didn't write. */
+  memset(a->top, 0xa5, words * BIGNUM_BYTES);
+#endif
+
+  *b = (bignum) { a->top, a->top, words, 0, 0, NULL };
+  *b->v = 0;
+  a->top += words;
+  return OK;
+}
+
+error bignum_scratch_alloc(bignum_arena *a, bignum *b, size_t words,
+                           const bignum *operand)
+{
+  if ((operand->flags & BIGNUM_F_GROWABLE) &&
+      (size_t) (a->end - a->top) / 4 < words)
+    return bignum_init_growable(b, words, operand->allocator);
+
+  return bignum_arena_alloc(a, b, words);
+}
+
+void bignum_scratch_release(bignum *b)
+{
+  if (b->flags & BIGNUM_F_GROWABLE)
+    bignum_clear(b);
+}
+
+bignum_arena_mark bignum_arena_save(bignum_arena *a)
+{
+  return (bignum_arena_mark) { a, a->top };
+}
+
+void bignum_arena_restore(bignum_arena_mark *m)
+{
+  assert(m->top <= m->arena->top);
+  m->arena->top = m->top;
+}
+
+void bignum_arena_restore_clean(bignum_arena_mark *m)
+{
+  assert(m->top <= m->arena->top);
+  mem_clean(m->top, (m->arena->top - m->top) * BIGNUM_BYTES);
+  m->arena->top = m->top;
+}
@@ -0,0 +1,136 @@
+#include <assert.h>
+#include <string.h>
+
+#include "bignum.h"
+#include "handy.h"
+
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+# define HOST_LITTLE_ENDIAN 1
+#endif
+
+/* Whole words are moved with a single (possibly byte swapped)
+ * load or store; the compiler turns these into mov/bswap or movbe. */
+static uint32_t load32(const uint8_t *p, bignum_endian order)
+{
+  uint32_t w;
+  memcpy(&w, p, sizeof w);
+
+#ifdef HOST_LITTLE_ENDIAN
+  return order == bignum_big_endian ? __builtin_bswap32(w) : w;
+#else
+  return order == bignum_little_endian ? __builtin_bswap32(w) : w;
+#endif
+}
+
+static void store32(uint8_t *p, uint32_t w, bignum_endian order)
+{
+#ifdef HOST_LITTLE_ENDIAN
+  if (order == bignum_big_endian)
+    w = __builtin_bswap32(w);
+#else
+  if (order == bignum_little_endian)
+    w = __builtin_bswap32(w);
+#endif
+
+  memcpy(p, &w, sizeof w);
+}
+
+/* Returns the index of the nth least significant of len bytes. */
+static size_t byte_index(size_t n, size_t len, bignum_endian order)
+{
+  return order == bignum_big_endian ? len - 1 - n : n;
+}
+
+error bignum_from_bytes(bignum *r, const uint8_t *buf, size_t len,
+                        bignum_endian order)
+{
+  assert(!bignum_check_mutable(r));
+  assert(buf || len == 0);
+
+  /* Drop leading zeroes. */
+  if (order == bignum_big_endian)
+  {
+    while (len && *buf == 0)
+      buf++, len--;
+  } else {
+    while (len && buf[len - 1] == 0)
+      len--;
+  }
+
+  size_t words = (len + BIGNUM_BYTES - 1) / BIGNUM_BYTES;
+  ER(bignum_reserve(r, MAX(words, (size_t) 1)));
+
+  bignum_setu(r, 0);
+  if (words == 0)
+    return OK;
+
+  ER(bignum_cleartop(r, words));
+
+  size_t whole = len / BIGNUM_BYTES;
+  for (size_t i = 0; i < whole; i++)
+  {
+    size_t at = order == bignum_big_endian ? len - BIGNUM_BYTES * (i + 1)
+                                           : BIGNUM_BYTES * i;
+    r->v[i] = load32(buf + at, order);
+  }
+
+  /* The top word may be short. */
+  uint32_t top = 0;
+  for (size_t n = len; n > whole * BIGNUM_BYTES; n--)
+    top = (top << 8) | buf[byte_index(n - 1, len, order)];
+  if (whole < words)
+    r->v[whole] = top;
+
+  bignum_canon(r);
+  return OK;
+}
+
+error bignum_to_bytes(const bignum *b, uint8_t *buf, size_t len,
+                      bignum_endian order)
+{
+  assert(!bignum_check(b));
+  assert(buf || len == 0);
+
+  if (bignum_len_bytes(b) > len)
+    return error_buffer_sz;
+
+  size_t words = bignum_len_words(b);
+  size_t whole = MIN(words, len / BIGNUM_BYTES);
+
+  for (size_t i = 0; i < whole; i++)
+  {
+    size_t at = order == bignum_big_endian ? len - BIGNUM_BYTES * (i + 1)
+                                           : BIGNUM_BYTES * i;
+    store32(buf + at, b->v[i], order);
+  }
+
+  /* Then the bytes of any short top word, and the padding. */
+  uint32_t top = whole < words ? b->v[whole] : 0;
+  for (size_t n = whole * BIGNUM_BYTES; n < len; n++)
+  {
+    buf[byte_index(n, len, order)] = top & 0xff;
+    top >>= 8;
+  }
+
+  return OK;
+}
+
+error bignum_view_bytes_le(bignum *r, const uint8_t *buf, size_t len)
+{
+#ifdef HOST_LITTLE_ENDIAN
+  if (len == 0 ||
+      len % BIGNUM_BYTES ||
+      (uintptr_t) buf % sizeof (uint32_t))
+    return error_invalid_bignum;
+
+  uint32_t *v = (uint32_t *) buf;
+  uint32_t *vtop = v + len / BIGNUM_BYTES - 1;
+  while (vtop != v && *vtop == 0)
+    vtop--;
+
+  *r = (bignum) { v, vtop, len / BIGNUM_BYTES, BIGNUM_F_IMMUTABLE, 0, NULL };
+  return OK;
+#else
+  return error_invalid_bignum;
+#endif
+}
@@ -3,6 +3,10 @@
 
 #include "bignum.h"
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 //#define BIGNUM_DEBUG_ENABLED
 
 #ifdef BIGNUM_DEBUG_ENABLED
@@ -11,4 +15,8 @@ void bignum_dump(const char *label, const bignum *b);
 # define bignum_dump(lbl, b) do {} while (0)
 #endif
 
+#ifdef __cplusplus
+}
+#endif
+
 #endif
@@ -0,0 +1,187 @@
+#include <assert.h>
+#include <string.h>
+
+#include "bignum.h"
+#include "bignum-der.h"
+#include "dstr.h"
+#include "handy.h"
+
+#define DER_INTEGER 0x02
+
+/* Returns 1 if the magnitude of b is a power of two. */
+static unsigned is_pow2(const bignum *b)
+{
+  for (const uint32_t *v = b->v; v != b->vtop; v++)
+  {
+    if (*v)
+      return 0;
+  }
+
+  return (*b->vtop & (*b->vtop - 1)) == 0;
+}
+
+/* Returns the length of the minimal two's complement
+ * encoding of b. */
+static size_t contents_len(const bignum *b)
+{
+  size_t bits = bignum_len_bits(b);
+
+  /* Positive numbers need a clear sign bit; negative ones a set
+   * sign bit, which is free for -2^k. */
+  if (bignum_is_negative(b) && is_pow2(b))
+    return (bits + 7) / 8;
+  else
+    return bits / 8 + 1;
+}
+
+/* Returns the number of bytes needed for the DER length n. */
+static size_t length_len(size_t n)
+{
+  size_t len = 1;
+
+  if (n >= 0x80)
+  {
+    for (; n; n >>= 8)
+      len++;
+  }
+
+  return len;
+}
+
+size_t bignum_der_integer_len(const bignum *b)
+{
+  assert(!bignum_check(b));
+
+  size_t n = contents_len(b);
+  return 1 + length_len(n) + n;
+}
+
+/* Writes the DER encoding of b, which is exactly
+ * bignum_der_integer_len(b) bytes, at out. */
+static void encode(const bignum *b, uint8_t *out)
+{
+  size_t n = contents_len(b);
+  size_t lenlen = length_len(n);
+
+  *out++ = DER_INTEGER;
+
+  if (lenlen == 1)
+  {
+    *out++ = n;
+  } else {
+    *out++ = 0x80 | (lenlen - 1);
+    for (size_t i = lenlen - 1; i > 0; i--)
+      *out++ = n >> (8 * (i - 1));
+  }
+
+  error err = bignum_to_bytes(b, out, n, bignum_big_endian);
+  assert(err == OK);
+  (void) err;
+
+  /* Negate in two's complement: invert, then add one. */
+  if (bignum_is_negative(b))
+  {
+    unsigned carry = 1;
+    for (size_t i = n; i > 0; i--)
+    {
+      unsigned byte = (uint8_t) ~out[i - 1] + carry;
+      out[i - 1] = byte;
+      carry = byte >> 8;
+    }
+  }
+}
+
+error bignum_der_encode_integer(const bignum *b, uint8_t *buf, size_t len,
+                                size_t *used)
+{
+  size_t need = bignum_der_integer_len(b);
+  if (need > len)
+    return error_buffer_sz;
+
+  encode(b, buf);
+
+  if (used)
+    *used = need;
+  return OK;
+}
+
+error bignum_der_encode_integer_dstr(const bignum *b, dstr *d)
+{
+  size_t need = bignum_der_integer_len(b);
+  if (dstr_expand(d, need))
+    return error_buffer_sz;
+
+  encode(b, (uint8_t *) d->wr);
+  d->wr += need;
+  return OK;
+}
+
+error bignum_der_decode_integer(bignum *r, const uint8_t *buf, size_t len,
+                                size_t *used)
+{
+  assert(!bignum_check_mutable(r));
+  assert(buf || len == 0);
+
+  if (len < 2 || buf[0] != DER_INTEGER)
+    return error_invalid_string;
+
+  size_t n, header;
+
+  if (buf[1] < 0x80)
+  {
+    n = buf[1];
+    header = 2;
+  } else {
+    /* Long form: no indefinite length, no leading zeroes, and
+     * only for lengths which need it. */
+    size_t lenlen = buf[1] & 0x7f;
+    if (lenlen == 0 ||
+        lenlen > sizeof n ||
+        len - 2 < lenlen ||
+        buf[2] == 0)
+      return error_invalid_string;
+
+    n = 0;
+    for (size_t i = 0; i < lenlen; i++)
+      n = (n << 8) | buf[2 + i];
+
+    if (n < 0x80)
+      return error_invalid_string;
+
+    header = 2 + lenlen;
+  }
+
+  if (n == 0 || len - header < n)
+    return error_invalid_string;
+
+  /* The first nine bits must not be all the same. */
+  const uint8_t *c = buf + header;
+  if (n > 1 &&
+      ((c[0] == 0x00 && !(c[1] & 0x80)) ||
+       (c[0] == 0xff && (c[1] & 0x80))))
+    return error_invalid_string;
+
+  ER(bignum_from_bytes(r, c, n, bignum_big_endian));
+
+  /* Negative: r = c - 256^n.  Take the magnitude by negating the
+   * n byte two's complement value: invert, then add one. */
+  if (c[0] & 0x80)
+  {
+    size_t words = (n + BIGNUM_BYTES - 1) / BIGNUM_BYTES;
+    ER(bignum_cleartop(r, words));
+
+    for (size_t i = 0; i < words; i++)
+      r->v[i] = ~r->v[i];
+
+    if (n % BIGNUM_BYTES)
+      r->v[words - 1] &= (1u << (8 * (n % BIGNUM_BYTES))) - 1;
+
+    bignum_canon(r);
+    ER(bignum_addl(r, &bignum_1));
+    bignum_setsign(r, -1);
+  }
+
+  if (used)
+    *used = header + n;
+  return OK;
+}
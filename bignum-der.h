@@ -0,0 +1,54 @@
+#ifndef BIGNUM_DER_H
+#define BIGNUM_DER_H
+
+/*
+ * Bignum library ASN.1 DER INTEGER encoding and decoding.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include "bignum.h"
+#include "dstr.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Decodes the DER INTEGER (tag, length and contents) at the start
+ * of buf[:len] into r.  If used is not NULL, *used is set to the
+ * number of bytes it occupied.
+ *
+ * error_invalid_string is returned if the encoding is truncated,
+ * has the wrong tag, or is not minimal (in its length or contents).
+ * error_bignum_sz is returned if r is too small.
+ */
+error bignum_der_decode_integer(bignum *r, const uint8_t *buf, size_t len,
+                                size_t *used);
+
+/**
+ * Returns the number of bytes bignum_der_encode_integer writes for b.
+ */
+size_t bignum_der_integer_len(const bignum *b);
+
+/**
+ * Encodes b as a DER INTEGER into buf[:len].  If used is not NULL,
+ * *used is set to the number of bytes written.
+ *
+ * error_buffer_sz is returned if buf isn't big enough.
+ */
+error bignum_der_encode_integer(const bignum *b, uint8_t *buf, size_t len,
+                                size_t *used);
+
+/**
+ * Appends the DER INTEGER encoding of b to d.
+ *
+ * error_buffer_sz is returned if d cannot be grown.
+ */
+error bignum_der_encode_integer_dstr(const bignum *b, dstr *d);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
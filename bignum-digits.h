@@ -0,0 +1,40 @@
+#ifndef BIGNUM_DIGITS_H
+#define BIGNUM_DIGITS_H
+
+/*
+ * Digits, shared by the string and streaming converters.
+ */
+
+#include <stddef.h>
+
+#include "bignum.h"
+
+/* Decimal is converted in chunks of as many digits as fit in a
+ * word. */
+#define DEC_CHUNK_DIGITS 9u
+#define DEC_CHUNK 1000000000
+
+/* Larger numbers are split, or built, at cached powers of ten:
+ * the kth has DEC_POWER_DIGITS(k) zeroes, for k < DEC_POWERS. */
+#define DEC_POWER_DIGITS(k) ((size_t) DEC_CHUNK_DIGITS << (k))
+#define DEC_POWERS 48
+
+/* Sets *p to 10 ^ DEC_POWER_DIGITS(k).  The powers are made on
+ * first use, and kept for the life of the process. */
+error bignum_dec_power(const bignum **p, size_t k);
+
+/* Returns the value of digit c in any base up to 36, or
+ * 0xff if c isn't a digit.  Both cases are accepted. */
+static inline unsigned digit_value(char c)
+{
+  if (c >= '0' && c <= '9')
+    return c - '0';
+
+  c |= 0x20;
+  if (c >= 'a' && c <= 'z')
+    return c - 'a' + 10;
+
+  return 0xff;
+}
+
+#endif
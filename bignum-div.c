@@ -11,30 +11,25 @@
 
 error bignum_mod(bignum *r, const bignum *a, const bignum *b)
 {
-  BIGNUM_TMP(q_tmp);
+  BIGNUM_SCRATCH_FOR(q_tmp, bignum_len_words(a) + 1, a);
   return bignum_divmod(&q_tmp, r, a, b);
 }
 
 error bignum_div(bignum *q, const bignum *a, const bignum *b)
 {
-  BIGNUM_TMP(r_tmp);
+  BIGNUM_SCRATCH_FOR(r_tmp, bignum_len_words(a) + 2, a);
   return bignum_divmod(q, &r_tmp, a, b);
 }
 
+/* Returns min(x / y, 2 ** 32 - 1): a quotient word never
+ * exceeds that, and truncating a larger estimate would make
+ * it an underestimate. */
 static uint32_t div64_32(uint32_t xhi, uint32_t xlo, uint32_t yhi, uint32_t ylo)
 {
   uint64_t x = ((uint64_t) xhi) << 32 | xlo;
   uint64_t y = ((uint64_t) yhi) << 32 | ylo;
-  return x / y;
-}
-
-/* Sets *res = -1 if candidate * y <= w,
- *      *res = 1 if candidate * y > w. */
-static error check_k(bignum *tmp, const bignum *w, const bignum *y, uint32_t candidate, int *res)
-{
-  ER(bignum_mulw(tmp, y, candidate));
-  *res = bignum_mag_lte(tmp, w) ? -1 : 1;
-  return OK;
+  uint64_t q = x / y;
+  return q > 0xffffffff ? 0xffffffff : q;
 }
 
 static uint32_t div_top(const bignum *x, const bignum *y)
@@ -61,18 +56,17 @@ static uint32_t div_top(const bignum *x, const bignum *y)
 
 static error find_k(uint32_t *k_out, bignum *tmp, const bignum *w, const bignum *y)
 {
-  assert(bignum_mag_lte(y, w));
+  assert(bignum_mag_cmp(y, w) <= 0);
 
   /* Make an initial guess by dividing the top of w by y.
-   * This might be an overestimate. */
+   * This is never an underestimate, but might be an overestimate,
+   * so walk it down until guess * y <= w. */
   uint32_t guess = div_top(w, y);
 
   while (1)
   {
-    int ltw, gtw;
-    ER(check_k(tmp, w, y, guess, &ltw));
-    ER(check_k(tmp, w, y, guess + 1, &gtw));
-    if (ltw == -1 && gtw == 1)
+    ER(bignum_mulw(tmp, y, guess));
+    if (bignum_mag_cmp(tmp, w) <= 0)
     {
       *k_out = guess;
       return OK;
@@ -80,34 +74,6 @@ static error find_k(uint32_t *k_out, bignum *tmp, const bignum *w, const bignum
 
     guess--;
   }
-
-#if 0
-  DELETEME
-  /* Fall-back to dumb-as-shit binary search. */
-  uint32_t kmin = 1, kmax = 0xffffffff;
-  uint32_t up = 0x7fffffff, down = up;
-
-  while (1)
-  {
-    if (kmin + 1 == kmax)
-    {
-      *k_out = kmin;
-      return OK;
-    }
-
-    /* Move kmin up? */
-    ER(bignum_mulw(tmp, y, kmin + up));
-    if (bignum_mag_lte(tmp, w))
-      kmin += up;
-    up = (up + 1) / 2;
-
-    /* Move kmax down? */
-    ER(bignum_mulw(tmp, y, kmax - down));
-    if (bignum_mag_lt(w, tmp))
-      kmax -= down;
-    down = (down + 1) / 2;
-  }
-#endif
 }
 
 /* This is basic schoolboy long division:
@@ -126,15 +92,32 @@ static error find_k(uint32_t *k_out, bignum *tmp, const bignum *w, const bignum
  *   3. r <- r - kyB^t
  */
 
+/* Returns the first growable of a, b, c and d, else a. */
+static const bignum *growable_of(const bignum *a, const bignum *b,
+                                 const bignum *c, const bignum *d)
+{
+  const bignum *all[] = { a, b, c, d };
+  for (size_t i = 0; i < ARRAYCOUNT(all); i++)
+  {
+    if (all[i]->flags & BIGNUM_F_GROWABLE)
+      return all[i];
+  }
+  return a;
+}
+
 error bignum_divmod(bignum *q, bignum *r, const bignum *x, const bignum *y)
 {
-  BIGNUM_TMP(tmp);
-  BIGNUM_TMP(yn);
+  /* yn is y normalised, which may gain a word; tmp is a multiple
+   * of yn by a word, shifted up as far as x normalised.  Either
+   * may be taken from a growable argument's allocator. */
+  const bignum *src = growable_of(x, y, q, r);
+  BIGNUM_SCRATCH_FOR(tmp, bignum_len_words(x) + 2, src);
+  BIGNUM_SCRATCH_FOR(yn, bignum_len_words(y) + 1, src);
 
   if (bignum_is_zero(y))
     return error_div_zero;
   
-  if (bignum_mag_lt(x, y))
+  if (bignum_mag_cmp(x, y) < 0)
   {
     /* x < y, so x / y := 0, x mod y := a. */
     bignum_setu(q, 0);
@@ -168,13 +151,17 @@ error bignum_divmod(bignum *q, bignum *r, const bignum *x, const bignum *y)
   {
     size_t t = n - i;
 
+    /* If r has already shrunk below B^t, we can't divide here. */
+    if (r->vtop < r->v + t)
+      continue;
+
     /* Make our window: which is the top i+1 words of x. */
     bignum window = *r;
     window.v += t;
     bignum_abs(&window);
     
     /* If window < yn, we can't divide here: expand window downwards. */
-    if (bignum_mag_lt(&window, &yn))
+    if (bignum_mag_cmp(&window, &yn) < 0)
       continue;
    
     /* Calculate the t'th word of q, k such that:
@@ -197,3 +184,39 @@ error bignum_divmod(bignum *q, bignum *r, const bignum *x, const bignum *y)
 
   return OK;
 }
+
+error bignum_divmodw(bignum *q, uint32_t *rem, const bignum *a, uint32_t w)
+{
+  assert(!bignum_check_mutable(q));
+  assert(!bignum_check(a));
+
+  if (w == 0)
+    return error_div_zero;
+
+  size_t words = bignum_len_words(a);
+  int sign = bignum_getsign(a);
+
+  if (q != a)
+  {
+    bignum_setu(q, 0);
+    ER(bignum_cleartop(q, words));
+  }
+
+  /* Schoolboy division by a single word, from the top down.
+   * nb. a->v[i] is read before q->v[i] is written, so q
+   * can alias a. */
+  uint64_t r = 0;
+  for (size_t i = words; i > 0; i--)
+  {
+    uint64_t t = (r << 32) | a->v[i - 1];
+    q->v[i - 1] = (uint32_t) (t / w);
+    r = t % w;
+  }
+
+  if (rem)
+    *rem = (uint32_t) r;
+
+  bignum_setsign(q, sign);
+  bignum_canon(q);
+  return OK;
+}
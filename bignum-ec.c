@@ -0,0 +1,936 @@
+#include <assert.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "bignum.h"
+#include "bignum-ec.h"
+#include "bignum-monty.h"
+#include "bignum-reduce.h"
+#include "handy.h"
+
+/* Everything allocated from the thread's arena after this is
+ * released, and zeroed, at the end of the enclosing scope. */
+#define ARENA_SCOPE(mark) \
+  bignum_arena_mark mark __attribute__((cleanup(bignum_arena_restore_clean))) = \
+    bignum_arena_save(bignum_arena_thread())
+
+/* --- Field arithmetic --- */
+
+typedef struct
+{
+  const bignum *p;
+  const reduce_ctx *red;
+
+  /* Words for an element, with room for the results of
+   * bignum_monty_modmul_normalised. */
+  size_t words;
+} field;
+
+static field field_of(const bignum *p, const reduce_ctx *red)
+{
+  field f = { p, red, bignum_len_words(p) + 2 };
+  return f;
+}
+
+/* r = ab, in the field's domain.  Arguments may alias. */
+static error fe_mul(bignum *r, const bignum *a, const bignum *b, const field *f)
+{
+  if (f->red->kind != REDUCE_MONTY)
+    return bignum_reduce_modmul(r, a, b, f->p, f->red);
+
+  BIGNUM_SCRATCH(tmp, f->words);
+  ER(bignum_monty_modmul_normalised(&tmp, a, b, f->p, &f->red->monty));
+  return bignum_dup(r, &tmp);
+}
+
+static error fe_sqr(bignum *r, const bignum *a, const field *f)
+{
+  return fe_mul(r, a, a, f);
+}
+
+static error fe_add(bignum *r, const bignum *a, const bignum *b, const field *f)
+{
+  ER(bignum_add(r, a, b));
+  if (bignum_gte(r, f->p))
+    ER(bignum_subl(r, f->p));
+  return OK;
+}
+
+static error fe_sub(bignum *r, const bignum *a, const bignum *b, const field *f)
+{
+  ER(bignum_sub(r, a, b));
+  if (bignum_is_negative(r))
+    ER(bignum_addl(r, f->p));
+  return OK;
+}
+
+/* r = x mod p, into the field's domain. */
+static error fe_in(bignum *r, const bignum *x, const field *f)
+{
+  if (f->red->kind != REDUCE_MONTY)
+    return bignum_reduce(r, x, f->p, f->red);
+
+  /* bignum_mod works in its result, so this must be as big as xR. */
+  BIGNUM_SCRATCH(tmp, bignum_len_words(x) + f->words + 2);
+  ER(bignum_monty_normalise(&tmp, x, f->p, &f->red->monty));
+  return bignum_dup(r, &tmp);
+}
+
+/* r = x, out of the field's domain. */
+static error fe_out(bignum *r, const bignum *x, const field *f)
+{
+  if (f->red->kind != REDUCE_MONTY)
+    return bignum_dup(r, x);
+
+  return fe_mul(r, x, &bignum_1, f);
+}
+
+/* r = 1/x, in the field's domain.  x must not be zero. */
+static error fe_inv(bignum *r, const bignum *x, const field *f)
+{
+  BIGNUM_SCRATCH(tmp, f->words);
+  ER(fe_out(&tmp, x, f));
+  ER(bignum_modinv(&tmp, &tmp, f->p));
+  return fe_in(r, &tmp, f);
+}
+
+/* --- Points --- */
+
+/* A point in Jacobian coordinates: (x/z^2, y/z^3), or infinity if
+ * z is zero. */
+typedef struct
+{
+  bignum x, y, z;
+} jpoint;
+
+/* What's needed for point arithmetic on a curve. */
+typedef struct
+{
+  const ec_curve *c;
+  field f;
+
+  /* a and 1 in the field's domain. */
+  bignum a, one;
+} ec_ctx;
+
+static error jpoint_alloc(jpoint *p, bignum_arena *arena, const ec_ctx *e)
+{
+  ER(bignum_arena_alloc(arena, &p->x, e->f.words));
+  ER(bignum_arena_alloc(arena, &p->y, e->f.words));
+  return bignum_arena_alloc(arena, &p->z, e->f.words);
+}
+
+static error ec_ctx_init(ec_ctx *e, bignum_arena *arena, const ec_curve *c)
+{
+  e->c = c;
+  e->f = field_of(c->p, &c->field);
+  ER(bignum_arena_alloc(arena, &e->a, e->f.words));
+  ER(bignum_arena_alloc(arena, &e->one, e->f.words));
+  ER(fe_in(&e->a, c->a, &e->f));
+  return fe_in(&e->one, &bignum_1, &e->f);
+}
+
+static unsigned jpoint_is_infinity(const jpoint *p)
+{
+  return bignum_is_zero(&p->z);
+}
+
+static error jpoint_set_infinity(jpoint *r, const ec_ctx *e)
+{
+  ER(bignum_dup(&r->x, &e->one));
+  ER(bignum_dup(&r->y, &e->one));
+  bignum_setu(&r->z, 0);
+  return OK;
+}
+
+static error jpoint_from_affine(jpoint *r, const bignum *x, const bignum *y, const ec_ctx *e)
+{
+  ER(fe_in(&r->x, x, &e->f));
+  ER(fe_in(&r->y, y, &e->f));
+  return bignum_dup(&r->z, &e->one);
+}
+
+/* Flags for jpoint_add's second operand. */
+#define Q_AFFINE 1  /* z is one, whatever it holds. */
+#define Q_NEGATE 2  /* Use -q. */
+
+/* r = q, with the flags applied. */
+static error jpoint_copy(jpoint *r, const jpoint *q, unsigned flags, const ec_ctx *e)
+{
+  ER(bignum_dup(&r->x, &q->x));
+  ER(bignum_dup(&r->z, flags & Q_AFFINE ? &e->one : &q->z));
+  if (flags & Q_NEGATE)
+    return fe_sub(&r->y, &bignum_0, &q->y, &e->f);
+  return bignum_dup(&r->y, &q->y);
+}
+
+/* r = 2p, by dbl-2007-bl, or dbl-2001-b when a = -3.  r may alias p. */
+static error jpoint_double(jpoint *r, const jpoint *p, const ec_ctx *e)
+{
+  const field *f = &e->f;
+
+  if (jpoint_is_infinity(p) || bignum_is_zero(&p->y))
+    return jpoint_set_infinity(r, e);
+
+  BIGNUM_SCRATCH(xx, f->words);
+  BIGNUM_SCRATCH(yy, f->words);
+  BIGNUM_SCRATCH(yyyy, f->words);
+  BIGNUM_SCRATCH(zz, f->words);
+  BIGNUM_SCRATCH(s, f->words);
+  BIGNUM_SCRATCH(m, f->words);
+  BIGNUM_SCRATCH(t, f->words);
+
+  ER(fe_sqr(&xx, &p->x, f));
+  ER(fe_sqr(&yy, &p->y, f));
+  ER(fe_sqr(&yyyy, &yy, f));
+  ER(fe_sqr(&zz, &p->z, f));
+
+  /* S = 2((X + YY)^2 - XX - YYYY) = 4XYY */
+  ER(fe_add(&s, &p->x, &yy, f));
+  ER(fe_sqr(&s, &s, f));
+  ER(fe_sub(&s, &s, &xx, f));
+  ER(fe_sub(&s, &s, &yyyy, f));
+  ER(fe_add(&s, &s, &s, f));
+
+  /* M = 3XX + aZZ^2 */
+  if (e->c->a_minus3)
+  {
+    /* = 3(X - ZZ)(X + ZZ) */
+    ER(fe_sub(&m, &p->x, &zz, f));
+    ER(fe_add(&t, &p->x, &zz, f));
+    ER(fe_mul(&m, &m, &t, f));
+    ER(fe_add(&t, &m, &m, f));
+    ER(fe_add(&m, &m, &t, f));
+  } else {
+    ER(fe_add(&m, &xx, &xx, f));
+    ER(fe_add(&m, &m, &xx, f));
+    if (!e->c->a_zero)
+    {
+      ER(fe_sqr(&t, &zz, f));
+      ER(fe_mul(&t, &t, &e->a, f));
+      ER(fe_add(&m, &m, &t, f));
+    }
+  }
+
+  /* Z3 = (Y + Z)^2 - YY - ZZ = 2YZ.  That's the last use of p. */
+  ER(fe_add(&r->z, &p->y, &p->z, f));
+  ER(fe_sqr(&r->z, &r->z, f));
+  ER(fe_sub(&r->z, &r->z, &yy, f));
+  ER(fe_sub(&r->z, &r->z, &zz, f));
+
+  /* X3 = T = M^2 - 2S */
+  ER(fe_sqr(&t, &m, f));
+  ER(fe_sub(&t, &t, &s, f));
+  ER(fe_sub(&t, &t, &s, f));
+  ER(bignum_dup(&r->x, &t));
+
+  /* Y3 = M(S - T) - 8YYYY */
+  ER(fe_sub(&s, &s, &t, f));
+  ER(fe_mul(&s, &s, &m, f));
+  ER(fe_add(&yyyy, &yyyy, &yyyy, f));
+  ER(fe_add(&yyyy, &yyyy, &yyyy, f));
+  ER(fe_add(&yyyy, &yyyy, &yyyy, f));
+  return fe_sub(&r->y, &s, &yyyy, f);
+}
+
+/* r = p + q, by add-2007-bl, with q modified by flags.  r may alias
+ * p or q. */
+static error jpoint_add(jpoint *r, const jpoint *p, const jpoint *q, unsigned flags,
+                        const ec_ctx *e)
+{
+  const field *f = &e->f;
+
+  if (!(flags & Q_AFFINE) && jpoint_is_infinity(q))
+    return r == p ? OK : jpoint_copy(r, p, 0, e);
+  if (jpoint_is_infinity(p))
+    return jpoint_copy(r, q, flags, e);
+
+  BIGNUM_SCRATCH(z1z1, f->words);
+  BIGNUM_SCRATCH(u1, f->words);
+  BIGNUM_SCRATCH(u2, f->words);
+  BIGNUM_SCRATCH(s1, f->words);
+  BIGNUM_SCRATCH(s2, f->words);
+  BIGNUM_SCRATCH(h, f->words);
+  BIGNUM_SCRATCH(i, f->words);
+  BIGNUM_SCRATCH(z3, f->words);
+
+  /* U2 = X2 Z1^2, S2 = Y2 Z1^3 */
+  ER(fe_sqr(&z1z1, &p->z, f));
+  ER(fe_mul(&u2, &q->x, &z1z1, f));
+  ER(fe_mul(&s2, &q->y, &p->z, f));
+  ER(fe_mul(&s2, &s2, &z1z1, f));
+  if (flags & Q_NEGATE)
+    ER(fe_sub(&s2, &bignum_0, &s2, f));
+
+  /* U1 = X1 Z2^2, S1 = Y1 Z2^3 */
+  if (flags & Q_AFFINE)
+  {
+    ER(bignum_dup(&u1, &p->x));
+    ER(bignum_dup(&s1, &p->y));
+  } else {
+    ER(fe_sqr(&i, &q->z, f));
+    ER(fe_mul(&u1, &p->x, &i, f));
+    ER(fe_mul(&s1, &p->y, &q->z, f));
+    ER(fe_mul(&s1, &s1, &i, f));
+  }
+
+  /* H = U2 - U1, r = 2(S2 - S1) */
+  ER(fe_sub(&h, &u2, &u1, f));
+  ER(fe_sub(&s2, &s2, &s1, f));
+  if (bignum_is_zero(&h))
+  {
+    if (bignum_is_zero(&s2))
+      return jpoint_double(r, p, e);
+    return jpoint_set_infinity(r, e);
+  }
+  ER(fe_add(&s2, &s2, &s2, f));
+
+  /* Z3 = 2 Z1 Z2 H */
+  ER(fe_mul(&z3, &p->z, &h, f));
+  if (!(flags & Q_AFFINE))
+    ER(fe_mul(&z3, &z3, &q->z, f));
+  ER(fe_add(&z3, &z3, &z3, f));
+
+  /* I = (2H)^2, J = HI, V = U1 I */
+  ER(fe_add(&i, &h, &h, f));
+  ER(fe_sqr(&i, &i, f));
+  ER(fe_mul(&h, &h, &i, f));
+  ER(fe_mul(&u1, &u1, &i, f));
+
+  /* X3 = r^2 - J - 2V */
+  ER(fe_sqr(&u2, &s2, f));
+  ER(fe_sub(&u2, &u2, &h, f));
+  ER(fe_sub(&u2, &u2, &u1, f));
+  ER(fe_sub(&u2, &u2, &u1, f));
+
+  /* Y3 = r(V - X3) - 2 S1 J */
+  ER(fe_sub(&u1, &u1, &u2, f));
+  ER(fe_mul(&u1, &u1, &s2, f));
+  ER(fe_mul(&s1, &s1, &h, f));
+  ER(fe_add(&s1, &s1, &s1, f));
+
+  ER(fe_sub(&r->y, &u1, &s1, f));
+  ER(bignum_dup(&r->x, &u2));
+  return bignum_dup(&r->z, &z3);
+}
+
+/* (x, y) = p, still in the field's domain. */
+static error jpoint_normalise(bignum *x, bignum *y, const jpoint *p, const ec_ctx *e)
+{
+  const field *f = &e->f;
+
+  if (jpoint_is_infinity(p))
+    return error_infinity;
+
+  BIGNUM_SCRATCH(zi, f->words);
+  BIGNUM_SCRATCH(zi2, f->words);
+
+  ER(fe_inv(&zi, &p->z, f));
+  ER(fe_sqr(&zi2, &zi, f));
+  ER(fe_mul(&zi, &zi, &zi2, f));
+  ER(fe_mul(x, &p->x, &zi2, f));
+  return fe_mul(y, &p->y, &zi, f);
+}
+
+/* (x, y) = p.  This is the one inversion. */
+static error jpoint_to_affine(bignum *x, bignum *y, const jpoint *p, const ec_ctx *e)
+{
+  BIGNUM_SCRATCH(ax, e->f.words);
+  BIGNUM_SCRATCH(ay, e->f.words);
+  ER(jpoint_normalise(&ax, &ay, p, e));
+  ER(fe_out(x, &ax, &e->f));
+  return fe_out(y, &ay, &e->f);
+}
+
+/* --- Curves --- */
+
+error bignum_ec_setup(ec_curve *c, const bignum *p, const bignum *a, const bignum *b,
+                      const bignum *gx, const bignum *gy, const bignum *n)
+{
+  assert(!bignum_check(p));
+  assert(!bignum_check(a));
+  assert(!bignum_check(b));
+  assert(!bignum_check(gx));
+  assert(!bignum_check(gy));
+  assert(!bignum_check(n));
+
+  if (!bignum_is_odd(p) || bignum_len_bits(p) < 3 ||
+      bignum_is_negative(a) || bignum_gte(a, p) ||
+      bignum_is_negative(b) || bignum_gte(b, p) ||
+      bignum_is_negative(n) || bignum_is_zero(n))
+    return error_invalid_bignum;
+
+  c->p = p;
+  c->a = a;
+  c->b = b;
+  c->gx = gx;
+  c->gy = gy;
+  c->n = n;
+  ER(bignum_reduce_setup(p, &c->field));
+
+  BIGNUM_SCRATCH(t, bignum_len_words(p) + 1);
+  ER(bignum_add(&t, a, &bignum_1));
+  ER(bignum_addl(&t, &bignum_1));
+  ER(bignum_addl(&t, &bignum_1));
+  c->a_minus3 = bignum_eq(&t, p);
+  c->a_zero = bignum_is_zero(a);
+  return OK;
+}
+
+#define CONST_BIGNUM(w) { w, w + ARRAYCOUNT(w) - 1, ARRAYCOUNT(w), BIGNUM_F_IMMUTABLE, 0, NULL }
+
+/* NIST P-256, P-384 and SEC secp256k1, least significant word
+ * first. */
+static uint32_t p256_p[] = {
+  0xffffffff, 0xffffffff, 0xffffffff, 0x00000000,
+  0x00000000, 0x00000000, 0x00000001, 0xffffffff
+};
+
+static uint32_t p256_a[] = {
+  0xfffffffc, 0xffffffff, 0xffffffff, 0x00000000,
+  0x00000000, 0x00000000, 0x00000001, 0xffffffff
+};
+
+static uint32_t p256_b[] = {
+  0x27d2604b, 0x3bce3c3e, 0xcc53b0f6, 0x651d06b0,
+  0x769886bc, 0xb3ebbd55, 0xaa3a93e7, 0x5ac635d8
+};
+
+static uint32_t p256_gx[] = {
+  0xd898c296, 0xf4a13945, 0x2deb33a0, 0x77037d81,
+  0x63a440f2, 0xf8bce6e5, 0xe12c4247, 0x6b17d1f2
+};
+
+static uint32_t p256_gy[] = {
+  0x37bf51f5, 0xcbb64068, 0x6b315ece, 0x2bce3357,
+  0x7c0f9e16, 0x8ee7eb4a, 0xfe1a7f9b, 0x4fe342e2
+};
+
+static uint32_t p256_n[] = {
+  0xfc632551, 0xf3b9cac2, 0xa7179e84, 0xbce6faad,
+  0xffffffff, 0xffffffff, 0x00000000, 0xffffffff
+};
+
+static uint32_t p384_p[] = {
+  0xffffffff, 0x00000000, 0x00000000, 0xffffffff,
+  0xfffffffe, 0xffffffff, 0xffffffff, 0xffffffff,
+  0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff
+};
+
+static uint32_t p384_a[] = {
+  0xfffffffc, 0x00000000, 0x00000000, 0xffffffff,
+  0xfffffffe, 0xffffffff, 0xffffffff, 0xffffffff,
+  0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff
+};
+
+static uint32_t p384_b[] = {
+  0xd3ec2aef, 0x2a85c8ed, 0x8a2ed19d, 0xc656398d,
+  0x5013875a, 0x0314088f, 0xfe814112, 0x181d9c6e,
+  0xe3f82d19, 0x988e056b, 0xe23ee7e4, 0xb3312fa7
+};
+
+static uint32_t p384_gx[] = {
+  0x72760ab7, 0x3a545e38, 0xbf55296c, 0x5502f25d,
+  0x82542a38, 0x59f741e0, 0x8ba79b98, 0x6e1d3b62,
+  0xf320ad74, 0x8eb1c71e, 0xbe8b0537, 0xaa87ca22
+};
+
+static uint32_t p384_gy[] = {
+  0x90ea0e5f, 0x7a431d7c, 0x1d7e819d, 0x0a60b1ce,
+  0xb5f0b8c0, 0xe9da3113, 0x289a147c, 0xf8f41dbd,
+  0x9292dc29, 0x5d9e98bf, 0x96262c6f, 0x3617de4a
+};
+
+static uint32_t p384_n[] = {
+  0xccc52973, 0xecec196a, 0x48b0a77a, 0x581a0db2,
+  0xf4372ddf, 0xc7634d81, 0xffffffff, 0xffffffff,
+  0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff
+};
+
+static uint32_t k1_p[] = {
+  0xfffffc2f, 0xfffffffe, 0xffffffff, 0xffffffff,
+  0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff
+};
+
+static uint32_t k1_gx[] = {
+  0x16f81798, 0x59f2815b, 0x2dce28d9, 0x029bfcdb,
+  0xce870b07, 0x55a06295, 0xf9dcbbac, 0x79be667e
+};
+
+static uint32_t k1_gy[] = {
+  0xfb10d4b8, 0x9c47d08f, 0xa6855419, 0xfd17b448,
+  0x0e1108a8, 0x5da4fbfc, 0x26a3c465, 0x483ada77
+};
+
+static uint32_t k1_n[] = {
+  0xd0364141, 0xbfd25e8c, 0xaf48a03b, 0xbaaedce6,
+  0xfffffffe, 0xffffffff, 0xffffffff, 0xffffffff
+};
+
+error bignum_ec_p256(ec_curve *c)
+{
+  static bignum p = CONST_BIGNUM(p256_p), a = CONST_BIGNUM(p256_a), b = CONST_BIGNUM(p256_b),
+                gx = CONST_BIGNUM(p256_gx), gy = CONST_BIGNUM(p256_gy), n = CONST_BIGNUM(p256_n);
+  return bignum_ec_setup(c, &p, &a, &b, &gx, &gy, &n);
+}
+
+error bignum_ec_p384(ec_curve *c)
+{
+  static bignum p = CONST_BIGNUM(p384_p), a = CONST_BIGNUM(p384_a), b = CONST_BIGNUM(p384_b),
+                gx = CONST_BIGNUM(p384_gx), gy = CONST_BIGNUM(p384_gy), n = CONST_BIGNUM(p384_n);
+  return bignum_ec_setup(c, &p, &a, &b, &gx, &gy, &n);
+}
+
+error bignum_ec_secp256k1(ec_curve *c)
+{
+  static uint32_t seven[] = { 7 };
+  static bignum p = CONST_BIGNUM(k1_p), b = CONST_BIGNUM(seven),
+                gx = CONST_BIGNUM(k1_gx), gy = CONST_BIGNUM(k1_gy), n = CONST_BIGNUM(k1_n);
+  return bignum_ec_setup(c, &p, &bignum_0, &b, &gx, &gy, &n);
+}
+
+error bignum_ec_check(const bignum *x, const bignum *y, const ec_curve *c)
+{
+  assert(!bignum_check(x));
+  assert(!bignum_check(y));
+
+  if (bignum_is_negative(x) || bignum_gte(x, c->p) ||
+      bignum_is_negative(y) || bignum_gte(y, c->p))
+    return error_invalid_bignum;
+
+  size_t words = bignum_len_words(c->p) + 2;
+  BIGNUM_SCRATCH(lhs, words);
+  BIGNUM_SCRATCH(rhs, words);
+
+  /* y^2 = (x^2 + a)x + b */
+  ER(bignum_reduce_modmul(&lhs, y, y, c->p, &c->field));
+  ER(bignum_reduce_modmul(&rhs, x, x, c->p, &c->field));
+  ER(bignum_addl(&rhs, c->a));
+  ER(bignum_reduce_modmul(&rhs, &rhs, x, c->p, &c->field));
+  ER(bignum_addl(&rhs, c->b));
+  ER(bignum_reduce(&rhs, &rhs, c->p, &c->field));
+
+  return bignum_eq(&lhs, &rhs) ? OK : error_invalid_bignum;
+}
+
+error bignum_ec_add(bignum *rx, bignum *ry,
+                    const bignum *px, const bignum *py,
+                    const bignum *qx, const bignum *qy,
+                    const ec_curve *c)
+{
+  ARENA_SCOPE(mark);
+  ec_ctx e;
+  jpoint p, q;
+  ER(ec_ctx_init(&e, mark.arena, c));
+  ER(jpoint_alloc(&p, mark.arena, &e));
+  ER(jpoint_alloc(&q, mark.arena, &e));
+
+  ER(jpoint_from_affine(&p, px, py, &e));
+  ER(jpoint_from_affine(&q, qx, qy, &e));
+  ER(jpoint_add(&p, &p, &q, Q_AFFINE, &e));
+  return jpoint_to_affine(rx, ry, &p, &e);
+}
+
+/* --- wNAF and Straus --- */
+
+#define WNAF_WIDTH 5
+
+/* Odd multiples P, 3P, ..., (2^(w-1) - 1)P. */
+#define WNAF_POINTS (1 << (WNAF_WIDTH - 2))
+
+/* Writes the width WNAF_WIDTH NAF of k >= 0 to naf, least significant
+ * digit first, and its length to *len.  naf needs room for
+ * len_bits(k) + 1 digits. */
+static error wnaf(int8_t *naf, size_t *len, const bignum *k)
+{
+  BIGNUM_SCRATCH_SECRET(d, bignum_len_words(k) + 1);
+  BIGNUM_SCRATCH_SECRET(w, 1);
+  ER(bignum_dup(&d, k));
+
+  size_t i = 0;
+  while (!bignum_is_zero(&d))
+  {
+    int digit = 0;
+    if (bignum_is_odd(&d))
+    {
+      /* The signed residue of d mod 2^w, so the next w - 1 digits
+       * are zero. */
+      digit = (int) bignum_get_bits(&d, 0, WNAF_WIDTH);
+      if (digit >= 1 << (WNAF_WIDTH - 1))
+        digit -= 1 << WNAF_WIDTH;
+
+      bignum_setu(&w, digit < 0 ? -digit : digit);
+      if (digit < 0)
+        ER(bignum_addl(&d, &w));
+      else
+        ER(bignum_subl(&d, &w));
+    }
+
+    naf[i++] = (int8_t) digit;
+    ER(bignum_shr(&d, 1));
+  }
+
+  *len = i;
+  return OK;
+}
+
+/* r = sum of k[i] p[i], for count <= 2 points, by interleaving their
+ * NAFs.  r must not alias the points. */
+static error straus(jpoint *r, const bignum *k, const jpoint *p, size_t count,
+                    const ec_ctx *e)
+{
+  assert(count <= 2);
+
+  ARENA_SCOPE(mark);
+  jpoint table[2][WNAF_POINTS];
+  size_t len[2], digits = 0;
+  int8_t naf[2][bignum_len_bits(e->c->n) + 1];
+
+  for (size_t i = 0; i < count; i++)
+  {
+    assert(bignum_len_bits(&k[i]) < sizeof naf[i]);
+    ER(wnaf(naf[i], &len[i], &k[i]));
+    digits = MAX(digits, len[i]);
+
+    /* table[i][j] = (2j + 1) p[i], using r for 2 p[i]. */
+    for (size_t j = 0; j < WNAF_POINTS; j++)
+      ER(jpoint_alloc(&table[i][j], mark.arena, e));
+
+    ER(jpoint_copy(&table[i][0], &p[i], 0, e));
+    ER(jpoint_double(r, &p[i], e));
+    for (size_t j = 1; j < WNAF_POINTS; j++)
+      ER(jpoint_add(&table[i][j], &table[i][j - 1], r, 0, e));
+  }
+
+  ER(jpoint_set_infinity(r, e));
+  for (size_t d = digits; d != 0; d--)
+  {
+    ER(jpoint_double(r, r, e));
+
+    for (size_t i = 0; i < count; i++)
+    {
+      int digit = d - 1 < len[i] ? naf[i][d - 1] : 0;
+      if (digit > 0)
+        ER(jpoint_add(r, r, &table[i][digit / 2], 0, e));
+      else if (digit < 0)
+        ER(jpoint_add(r, r, &table[i][-digit / 2], Q_NEGATE, e));
+    }
+  }
+
+  return OK;
+}
+
+/* (rx, ry) = sum of k[i] P[i]. */
+static error ec_mul_points(bignum *rx, bignum *ry, size_t count, const bignum *const *k,
+                           const bignum *const *px, const bignum *const *py,
+                           const ec_curve *c)
+{
+  ARENA_SCOPE(mark);
+  ec_ctx e;
+  ER(ec_ctx_init(&e, mark.arena, c));
+
+  bignum kn[2];
+  jpoint p[2], r;
+  for (size_t i = 0; i < count; i++)
+  {
+    assert(!bignum_check(k[i]));
+    if (bignum_is_negative(k[i]))
+      return error_invalid_bignum;
+
+    /* nb. bignum_mod works in its result. */
+    ER(bignum_arena_alloc(mark.arena, &kn[i],
+                          MAX(bignum_len_words(k[i]), bignum_len_words(c->n)) + 1));
+    ER(bignum_mod(&kn[i], k[i], c->n));
+
+    ER(jpoint_alloc(&p[i], mark.arena, &e));
+    ER(jpoint_from_affine(&p[i], px[i], py[i], &e));
+  }
+
+  ER(jpoint_alloc(&r, mark.arena, &e));
+  ER(straus(&r, kn, p, count, &e));
+  return jpoint_to_affine(rx, ry, &r, &e);
+}
+
+error bignum_ec_mul(bignum *rx, bignum *ry, const bignum *k,
+                    const bignum *px, const bignum *py,
+                    const ec_curve *c)
+{
+  return ec_mul_points(rx, ry, 1, &k, &px, &py, c);
+}
+
+error bignum_ec_mul2(bignum *rx, bignum *ry,
+                     const bignum *k1, const bignum *p1x, const bignum *p1y,
+                     const bignum *k2, const bignum *p2x, const bignum *p2y,
+                     const ec_curve *c)
+{
+  const bignum *k[] = { k1, k2 }, *px[] = { p1x, p2x }, *py[] = { p1y, p2y };
+  return ec_mul_points(rx, ry, 2, k, px, py, c);
+}
+
+/* --- Fixed base comb --- */
+
+#define COMB_POINTS ((1u << BIGNUM_EC_COMB_TEETH) - 1)
+
+static size_t comb_table_bytes(const ec_comb *comb)
+{
+  return COMB_POINTS * 2 * comb->words * BIGNUM_BYTES;
+}
+
+/* The x coordinate of table entry j, for j in [1, COMB_POINTS].
+ * y follows it. */
+static uint32_t *comb_entry(const ec_comb *comb, size_t j)
+{
+  return comb->table + (j - 1) * 2 * comb->words;
+}
+
+static void comb_store(uint32_t *words, const bignum *x, size_t n)
+{
+  memset(words, 0, n * BIGNUM_BYTES);
+  memcpy(words, x->v, bignum_len_words(x) * BIGNUM_BYTES);
+}
+
+/* An immutable bignum of the n words at words. */
+static bignum comb_view(const uint32_t *words, size_t n)
+{
+  const uint32_t *top = words + n - 1;
+  while (top != words && *top == 0)
+    top--;
+
+  bignum b = { (uint32_t *) words, (uint32_t *) top, n, BIGNUM_F_IMMUTABLE, 0, NULL };
+  return b;
+}
+
+/* Entry j is the sum, for each bit i set in j, of
+ * 2^(i spacing) G. */
+static error comb_fill(ec_comb *comb)
+{
+  const ec_curve *c = comb->curve;
+
+  ARENA_SCOPE(mark);
+  ec_ctx e;
+  ER(ec_ctx_init(&e, mark.arena, c));
+
+  jpoint t[COMB_POINTS];
+  for (size_t j = 0; j < COMB_POINTS; j++)
+    ER(jpoint_alloc(&t[j], mark.arena, &e));
+
+  ER(jpoint_from_affine(&t[0], c->gx, c->gy, &e));
+  for (size_t i = 1; i < BIGNUM_EC_COMB_TEETH; i++)
+  {
+    jpoint *tooth = &t[(1u << i) - 1];
+    ER(jpoint_copy(tooth, &t[(1u << (i - 1)) - 1], 0, &e));
+    for (size_t s = 0; s < comb->spacing; s++)
+      ER(jpoint_double(tooth, tooth, &e));
+  }
+
+  for (size_t j = 1; j <= COMB_POINTS; j++)
+  {
+    size_t high = 1u << (BIGNUM_BITS - 1 - __builtin_clz(j));
+    if (j != high)
+      ER(jpoint_add(&t[j - 1], &t[j - high - 1], &t[high - 1], 0, &e));
+  }
+
+  BIGNUM_SCRATCH(x, e.f.words);
+  BIGNUM_SCRATCH(y, e.f.words);
+  for (size_t j = 1; j <= COMB_POINTS; j++)
+  {
+    ER(jpoint_normalise(&x, &y, &t[j - 1], &e));
+    comb_store(comb_entry(comb, j), &x, comb->words);
+    comb_store(comb_entry(comb, j) + comb->words, &y, comb->words);
+  }
+
+  return OK;
+}
+
+error bignum_ec_comb_setup(ec_comb *comb, const ec_curve *c, const bignum_allocator *allocator)
+{
+  if (!allocator)
+    allocator = &bignum_malloc_allocator;
+
+  comb->curve = c;
+  comb->spacing = (bignum_len_bits(c->n) + BIGNUM_EC_COMB_TEETH - 1) / BIGNUM_EC_COMB_TEETH;
+  comb->words = bignum_len_words(c->p);
+  comb->allocator = allocator;
+  comb->table = allocator->alloc(allocator->ctx, comb_table_bytes(comb));
+  if (!comb->table)
+    return error_bignum_sz;
+
+  error err = comb_fill(comb);
+  if (err)
+    bignum_ec_comb_clear(comb);
+  return err;
+}
+
+void bignum_ec_comb_clear(ec_comb *comb)
+{
+  if (comb->table)
+    comb->allocator->free(comb->allocator->ctx, comb->table, comb_table_bytes(comb));
+  comb->table = NULL;
+}
+
+error bignum_ec_mul_base(bignum *rx, bignum *ry, const bignum *k, const ec_comb *comb)
+{
+  assert(!bignum_check(k));
+  assert(comb->table);
+
+  const ec_curve *c = comb->curve;
+  if (bignum_is_negative(k))
+    return error_invalid_bignum;
+
+  ARENA_SCOPE(mark);
+  ec_ctx e;
+  jpoint r, q;
+  bignum kn;
+  ER(ec_ctx_init(&e, mark.arena, c));
+  ER(jpoint_alloc(&r, mark.arena, &e));
+  ER(bignum_arena_alloc(mark.arena, &kn,
+                        MAX(bignum_len_words(k), bignum_len_words(c->n)) + 1));
+  ER(bignum_mod(&kn, k, c->n));
+
+  /* Column i of k, read with teeth spacing bits apart, picks the
+   * table entry to add after i doublings from the top. */
+  ER(jpoint_set_infinity(&r, &e));
+  for (size_t col = comb->spacing; col != 0; col--)
+  {
+    ER(jpoint_double(&r, &r, &e));
+
+    size_t j = 0;
+    for (size_t i = 0; i < BIGNUM_EC_COMB_TEETH; i++)
+      j |= (size_t) bignum_get_bit(&kn, i * comb->spacing + col - 1) << i;
+
+    if (j)
+    {
+      q.x = comb_view(comb_entry(comb, j), comb->words);
+      q.y = comb_view(comb_entry(comb, j) + comb->words, comb->words);
+      q.z = e.one;
+      ER(jpoint_add(&r, &r, &q, Q_AFFINE, &e));
+    }
+  }
+
+  return jpoint_to_affine(rx, ry, &r, &e);
+}
+
+/* --- Montgomery curves --- */
+
+error bignum_ec_ladder(bignum *r, const bignum *k, size_t bits, const bignum *u,
+                       const bignum *a24, const bignum *p, const reduce_ctx *red)
+{
+  assert(!bignum_check_mutable(r));
+  assert(!bignum_check(k));
+  assert(!bignum_check(u));
+  assert(!bignum_check(a24));
+  assert(!bignum_check(p));
+
+  if (red->kind == REDUCE_GENERIC || bignum_is_negative(u))
+    return error_invalid_bignum;
+
+  field f = field_of(p, red);
+  BIGNUM_SCRATCH_SECRET(x1, f.words);
+  BIGNUM_SCRATCH_SECRET(x2, f.words);
+  BIGNUM_SCRATCH_SECRET(z2, f.words);
+  BIGNUM_SCRATCH_SECRET(x3, f.words);
+  BIGNUM_SCRATCH_SECRET(z3, f.words);
+  BIGNUM_SCRATCH_SECRET(a, f.words);
+  BIGNUM_SCRATCH_SECRET(aa, f.words);
+  BIGNUM_SCRATCH_SECRET(b, f.words);
+  BIGNUM_SCRATCH_SECRET(bb, f.words);
+  BIGNUM_SCRATCH_SECRET(c, f.words);
+  BIGNUM_SCRATCH_SECRET(d, f.words);
+  BIGNUM_SCRATCH(a24d, f.words);
+
+  ER(fe_in(&x1, u, &f));
+  ER(fe_in(&a24d, a24, &f));
+  ER(fe_in(&x2, &bignum_1, &f));
+  bignum_setu(&z2, 0);
+  ER(bignum_dup(&x3, &x1));
+  ER(bignum_dup(&z3, &x2));
+
+  /* RFC 7748, section 5.  (x2 : z2) = mP and (x3 : z3) = (m + 1)P,
+   * where m is the bits of k so far. */
+  unsigned swap = 0;
+  for (size_t t = bits; t != 0; t--)
+  {
+    unsigned bit = bignum_get_bit(k, t - 1);
+    if (swap ^ bit)
+    {
+      SWAP(x2, x3);
+      SWAP(z2, z3);
+    }
+    swap = bit;
+
+    ER(fe_add(&a, &x2, &z2, &f));
+    ER(fe_sqr(&aa, &a, &f));
+    ER(fe_sub(&b, &x2, &z2, &f));
+    ER(fe_sqr(&bb, &b, &f));
+    ER(fe_add(&c, &x3, &z3, &f));
+    ER(fe_sub(&d, &x3, &z3, &f));
+
+    /* DA and CB */
+    ER(fe_mul(&d, &d, &a, &f));
+    ER(fe_mul(&c, &c, &b, &f));
+
+    /* x3 = (DA + CB)^2, z3 = x1 (DA - CB)^2 */
+    ER(fe_add(&x3, &d, &c, &f));
+    ER(fe_sqr(&x3, &x3, &f));
+    ER(fe_sub(&z3, &d, &c, &f));
+    ER(fe_sqr(&z3, &z3, &f));
+    ER(fe_mul(&z3, &z3, &x1, &f));
+
+    /* x2 = AA BB, z2 = E (AA + a24 E), with E = AA - BB */
+    ER(fe_mul(&x2, &aa, &bb, &f));
+    ER(fe_sub(&b, &aa, &bb, &f));
+    ER(fe_mul(&z2, &b, &a24d, &f));
+    ER(fe_add(&z2, &z2, &aa, &f));
+    ER(fe_mul(&z2, &z2, &b, &f));
+  }
+
+  if (swap)
+  {
+    SWAP(x2, x3);
+    SWAP(z2, z3);
+  }
+
+  if (bignum_is_zero(&z2))
+  {
+    bignum_setu(r, 0);
+    return OK;
+  }
+
+  ER(fe_inv(&z2, &z2, &f));
+  ER(fe_mul(&x2, &x2, &z2, &f));
+  return fe_out(r, &x2, &f);
+}
+
+error bignum_ec_x25519(uint8_t out[32], const uint8_t scalar[32], const uint8_t u[32])
+{
+  static uint32_t p_words[] = {
+    0xffffffed, 0xffffffff, 0xffffffff, 0xffffffff,
+    0xffffffff, 0xffffffff, 0xffffffff, 0x7fffffff
+  };
+  static uint32_t a24_words[] = { 121665 };
+  static bignum p = CONST_BIGNUM(p_words), a24 = CONST_BIGNUM(a24_words);
+
+  reduce_ctx red;
+  ER(bignum_reduce_setup(&p, &red));
+
+  /* Clamp the scalar, and ignore the top bit of u. */
+  uint8_t buf[32];
+  BIGNUM_SCRATCH_SECRET(k, 8);
+  BIGNUM_SCRATCH(x, 8);
+  BIGNUM_SCRATCH(r, 8);
+
+  memcpy(buf, scalar, sizeof buf);
+  buf[0] &= 0xf8;
+  buf[31] &= 0x7f;
+  buf[31] |= 0x40;
+  error err = bignum_from_bytes(&k, buf, sizeof buf, bignum_little_endian);
+  mem_clean(buf, sizeof buf);
+  ER(err);
+
+  memcpy(buf, u, sizeof buf);
+  buf[31] &= 0x7f;
+  ER(bignum_from_bytes(&x, buf, sizeof buf, bignum_little_endian));
+
+  ER(bignum_ec_ladder(&r, &k, 255, &x, &a24, &p, &red));
+  return bignum_to_bytes(&r, out, 32, bignum_little_endian);
+}
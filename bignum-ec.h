@@ -0,0 +1,135 @@
+#ifndef BIGNUM_EC_H
+#define BIGNUM_EC_H
+
+/*
+ * Bignum library elliptic curve arithmetic.
+ *
+ * Points on short Weierstrass curves are kept in Jacobian
+ * coordinates while they're worked on, so a scalar multiplication
+ * needs just one inversion, at the end.  Field elements are in the
+ * Montgomery domain, or plain residues when the prime has a special
+ * reduction (see bignum-reduce.h).
+ *
+ * Points passed in and out are affine, and must be on the curve.
+ * The point at infinity has no affine form: functions which would
+ * return it fail with error_infinity.
+ *
+ * None of this is constant time, because the arithmetic below it
+ * isn't.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include "bignum.h"
+#include "bignum-reduce.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** A short Weierstrass curve y^2 = x^3 + ax + b over GF(p), with a
+ *  base point G of prime order n.
+ *
+ *  The curve refers to its parameters, which must outlive it. */
+typedef struct
+{
+  const bignum *p, *a, *b;
+  const bignum *gx, *gy, *n;
+
+  reduce_ctx field;
+
+  /* a is -3 or 0, which have cheaper doublings. */
+  unsigned a_minus3, a_zero;
+} ec_curve;
+
+/** Sets up c.  p must be a prime over 3, 0 <= a, b < p and n > 0.
+ *  error_invalid_bignum is returned if p is even or under 5, or the
+ *  others are out of range.  The base point is not checked: see
+ *  bignum_ec_check. */
+error bignum_ec_setup(ec_curve *c, const bignum *p, const bignum *a, const bignum *b,
+                      const bignum *gx, const bignum *gy, const bignum *n);
+
+/** Sets up c as NIST P-256, P-384 or SEC secp256k1. */
+error bignum_ec_p256(ec_curve *c);
+error bignum_ec_p384(ec_curve *c);
+error bignum_ec_secp256k1(ec_curve *c);
+
+/** Returns OK if (x, y) is on c, otherwise error_invalid_bignum. */
+error bignum_ec_check(const bignum *x, const bignum *y, const ec_curve *c);
+
+/** Sets (rx, ry) = P + Q. */
+error bignum_ec_add(bignum *rx, bignum *ry,
+                    const bignum *px, const bignum *py,
+                    const bignum *qx, const bignum *qy,
+                    const ec_curve *c);
+
+/** Sets (rx, ry) = kP, using a width 5 NAF of k mod n.  k must not
+ *  be negative, otherwise error_invalid_bignum is returned.
+ *
+ *  Arguments may alias in any combination. */
+error bignum_ec_mul(bignum *rx, bignum *ry, const bignum *k,
+                    const bignum *px, const bignum *py,
+                    const ec_curve *c);
+
+/** Sets (rx, ry) = k1 P1 + k2 P2, sharing the doublings between the
+ *  two (Straus' method).  This is what ECDSA verification needs.
+ *  k1 and k2 must not be negative.
+ *
+ *  Arguments may alias in any combination. */
+error bignum_ec_mul2(bignum *rx, bignum *ry,
+                     const bignum *k1, const bignum *p1x, const bignum *p1y,
+                     const bignum *k2, const bignum *p2x, const bignum *p2y,
+                     const ec_curve *c);
+
+/** Number of teeth of an ec_comb.  The table has 2^teeth - 1
+ *  points. */
+#define BIGNUM_EC_COMB_TEETH 6
+
+/** Precomputed multiples of a curve's base point G, for
+ *  bignum_ec_mul_base.  This takes len(n) / teeth doublings, and as
+ *  many additions. */
+typedef struct
+{
+  const ec_curve *curve;
+
+  /* Distance between teeth, in bits. */
+  size_t spacing;
+
+  /* Words per coordinate. */
+  size_t words;
+
+  /* Affine points, x then y, in the field's domain. */
+  uint32_t *table;
+  const bignum_allocator *allocator;
+} ec_comb;
+
+/** Builds the table for c's base point, with storage from allocator
+ *  (or malloc if it is NULL).  Release it with bignum_ec_comb_clear. */
+error bignum_ec_comb_setup(ec_comb *comb, const ec_curve *c, const bignum_allocator *allocator);
+
+/** Frees comb's table. */
+void bignum_ec_comb_clear(ec_comb *comb);
+
+/** Sets (rx, ry) = kG.  k must not be negative.
+ *
+ *  Arguments may alias in any combination. */
+error bignum_ec_mul_base(bignum *rx, bignum *ry, const bignum *k, const ec_comb *comb);
+
+/** Montgomery ladder on the curve By^2 = x^3 + Ax^2 + x over GF(p),
+ *  where a24 = (A - 2) / 4 and red is set up for p.  Sets
+ *  r = the x coordinate of kP, given u = the x coordinate of P, using
+ *  the low bits bits of k.  A result at infinity gives zero.
+ *
+ *  Arguments may alias in any combination. */
+error bignum_ec_ladder(bignum *r, const bignum *k, size_t bits, const bignum *u,
+                       const bignum *a24, const bignum *p, const reduce_ctx *red);
+
+/** X25519 from RFC 7748: out = scalar * u, with all three encoded as
+ *  32 little endian bytes. */
+error bignum_ec_x25519(uint8_t out[32], const uint8_t scalar[32], const uint8_t u[32]);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
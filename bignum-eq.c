@@ -5,77 +5,75 @@
 
 #include "bignum.h"
 
-unsigned bignum_lt(const bignum *a, const bignum *b)
+int bignum_cmp(const bignum *a, const bignum *b)
 {
-  assert(!bignum_check(a));
-  assert(!bignum_check(b));
+  int sa = bignum_getsign(a), sb = bignum_getsign(b);
+  if (sa != sb)
+    return sa < sb ? -1 : 1;
 
-  /* Check sign */
-  if (bignum_getsign(a) < bignum_getsign(b))
-    return 1;
-  else if (bignum_getsign(a) > bignum_getsign(b))
-    return 0;
-
-  return bignum_mag_lt(a, b);
+  /* Same sign: for negatives, the bigger magnitude is smaller. */
+  int c = bignum_mag_cmp(a, b);
+  return sa < 0 ? -c : c;
 }
 
-unsigned bignum_mag_lt(const bignum *a, const bignum *b)
+int bignum_mag_cmp(const bignum *a, const bignum *b)
 {
   assert(!bignum_check(a));
   assert(!bignum_check(b));
 
-  /* Check sizes */
-  size_t sza = bignum_len_bits(a);
-  size_t szb = bignum_len_bits(b);
+  /* Both are canonical, so the longer one is bigger. */
+  size_t wa = bignum_len_words(a), wb = bignum_len_words(b);
+  if (wa != wb)
+    return wa < wb ? -1 : 1;
 
-  if (sza < szb)
-    return 1;
-  else if (sza > szb)
-    return 0;
-  
-  /* Now run through word values. */
-  for (uint32_t *va = a->vtop, *vb = b->vtop;
-       va >= a->v && vb >= b->v;
-       va--, vb--)
+  for (size_t i = wa; i != 0; i--)
   {
-    uint32_t wa = *va, wb = *vb;
-    if (wa < wb)
-      return 1;
-    else if (wa > wb)
-      return 0;
+    uint32_t x = a->v[i - 1], y = b->v[i - 1];
+    if (x != y)
+      return x < y ? -1 : 1;
   }
 
   return 0;
 }
 
+unsigned bignum_lt(const bignum *a, const bignum *b)
+{
+  return bignum_cmp(a, b) < 0;
+}
+
 unsigned bignum_lte(const bignum *a, const bignum *b)
 {
-  return bignum_lt(a, b) || bignum_eq(a, b);
+  return bignum_cmp(a, b) <= 0;
 }
 
 unsigned bignum_gt(const bignum *a, const bignum *b)
 {
-  return !bignum_lte(a, b);
+  return bignum_cmp(a, b) > 0;
 }
 
 unsigned bignum_gte(const bignum *a, const bignum *b)
 {
-  return !bignum_lt(a, b);
+  return bignum_cmp(a, b) >= 0;
+}
+
+unsigned bignum_mag_lt(const bignum *a, const bignum *b)
+{
+  return bignum_mag_cmp(a, b) < 0;
 }
 
 unsigned bignum_mag_lte(const bignum *a, const bignum *b)
 {
-  return bignum_mag_lt(a, b) || bignum_mag_eq(a, b);
+  return bignum_mag_cmp(a, b) <= 0;
 }
 
 unsigned bignum_mag_gt(const bignum *a, const bignum *b)
 {
-  return !bignum_mag_lte(a, b);
+  return bignum_mag_cmp(a, b) > 0;
 }
 
 unsigned bignum_mag_gte(const bignum *a, const bignum *b)
 {
-  return !bignum_mag_lt(a, b);
+  return bignum_mag_cmp(a, b) >= 0;
 }
 
 
@@ -90,24 +88,13 @@ unsigned bignum_eq(const bignum *a, const bignum *b)
 
 unsigned bignum_mag_eq(const bignum *a, const bignum *b)
 {
-  if (bignum_len_bits(a) != bignum_len_bits(b))
-    return 0;
-
-  for (uint32_t *va = a->vtop, *vb = b->vtop;
-       va >= a->v && vb >= b->v;
-       va--, vb--)
-  {
-    if (*va != *vb)
-      return 0;
-  }
-
-  return 1;
+  return bignum_mag_cmp(a, b) == 0;
 }
 
 unsigned bignum_const_eq(const bignum *a, const bignum *b)
 {
   uint32_t neq = (bignum_getsign(a) ^ bignum_getsign(b));
-  neq |= (bignum_len_bits(a) ^ bignum_len_bits(b));
+  neq |= (bignum_len_words(a) ^ bignum_len_words(b));
 
   for (uint32_t *va = a->vtop, *vb = b->vtop;
        va >= a->v && vb >= b->v;
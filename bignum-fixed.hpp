@@ -0,0 +1,481 @@
+#ifndef BIGNUM_FIXED_HPP
+#define BIGNUM_FIXED_HPP
+
+/*
+ * Fixed width unsigned bignums for C++.
+ *
+ * fixed_bignum<Bits> holds a value in [0, 2^Bits) in inline limbs.
+ * There is no length tracking or canonicalisation: every operation
+ * works on every limb, so loop trip counts are compile time
+ * constants, and inner loops are unrolled completely.  The outer
+ * loops of multiplication are too, up to 384 bits.  This also
+ * means the time taken doesn't depend on the values.
+ *
+ * Everything except the conversions to and from C bignums is
+ * constexpr, so constants can be computed at compile time.
+ *
+ * This is header only; the C library is only needed for the
+ * conversions.
+ */
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <utility>
+
+#include "bignum.h"
+
+namespace bignum_cxx
+{
+
+namespace detail
+{
+  template <typename F, size_t... I>
+  constexpr void unroll(F &&f, std::index_sequence<I...>)
+  {
+    (f(std::integral_constant<size_t, I>{}), ...);
+  }
+
+  /* Calls f(i) for each i in [0, N), unrolled.  i is a
+   * std::integral_constant, so may be used as a constant. */
+  template <size_t N, typename F>
+  constexpr void unroll(F &&f)
+  {
+    unroll(f, std::make_index_sequence<N>{});
+  }
+
+  /* Unrolling a loop around an unrolled loop grows the code as the
+   * square of the limbs, so stop at this many. */
+  constexpr size_t unroll_limit = 12;
+
+  /* Calls f(i) for each i in [0, N): unrolled for N up to
+   * unroll_limit, and otherwise a loop with a size_t i. */
+  template <size_t N, typename F>
+  constexpr void unroll_small(F &&f)
+  {
+    if constexpr (N <= unroll_limit)
+      unroll<N>(f);
+    else
+      for (size_t i = 0; i < N; i++)
+        f(i);
+  }
+
+  /* Not constexpr: reaching this in a constant expression stops
+   * compilation. */
+  inline uint32_t bad_constant()
+  {
+    abort();
+  }
+
+  /* Returns all ones if x is non-zero, otherwise zero. */
+  constexpr uint32_t mask_if(uint32_t x)
+  {
+    return -((x | -x) >> 31);
+  }
+}
+
+template <size_t Bits>
+class fixed_bignum
+{
+  static_assert(Bits > 0 && Bits % BIGNUM_BITS == 0,
+                "Bits must be a positive multiple of BIGNUM_BITS");
+
+public:
+  static constexpr size_t bits = Bits;
+  static constexpr size_t limbs = Bits / BIGNUM_BITS;
+
+  /** Limbs, least significant first. */
+  uint32_t v[limbs] = {};
+
+  constexpr fixed_bignum() = default;
+
+  constexpr explicit fixed_bignum(uint64_t x)
+  {
+    v[0] = uint32_t(x);
+    if constexpr (limbs > 1)
+      v[1] = uint32_t(x >> 32);
+  }
+
+  /** Parses hex digits, with an optional 0x prefix.  This is for
+   *  constants: bad input fails to compile in a constant expression,
+   *  and aborts otherwise.  Convert other input with assign. */
+  static constexpr fixed_bignum from_hex(const char *s)
+  {
+    fixed_bignum r;
+
+    if (s[0] == '0' && (s[1] == 'x' || s[1] == 'X'))
+      s += 2;
+
+    size_t n = 0;
+    while (s[n])
+      n++;
+
+    if (n == 0 || n > limbs * 8)
+      detail::bad_constant();
+
+    for (size_t i = 0; i < n; i++)
+    {
+      char c = s[n - 1 - i];
+      uint32_t d = c >= '0' && c <= '9' ? uint32_t(c - '0')
+                 : c >= 'a' && c <= 'f' ? uint32_t(c - 'a' + 10)
+                 : c >= 'A' && c <= 'F' ? uint32_t(c - 'A' + 10)
+                 : detail::bad_constant();
+      r.v[i / 8] |= d << (4 * (i % 8));
+    }
+
+    return r;
+  }
+
+  constexpr bool is_zero() const
+  {
+    uint32_t acc = 0;
+    detail::unroll<limbs>([&](auto i) { acc |= v[i]; });
+    return acc == 0;
+  }
+
+  constexpr bool is_odd() const
+  {
+    return v[0] & 1;
+  }
+
+  /** Returns an immutable C bignum referring to these limbs.  It is
+   *  only valid as long as this is. */
+  bignum view() const
+  {
+    uint32_t *p = const_cast<uint32_t *>(v);
+    uint32_t *top = p + limbs - 1;
+    while (top != p && *top == 0)
+      top--;
+    return bignum { p, top, limbs, BIGNUM_F_IMMUTABLE, limbs, nullptr };
+  }
+
+  /** Sets this to the value of b.  Fails with error_invalid_bignum
+   *  if b is negative, or error_bignum_sz if b is too big. */
+  error assign(const bignum &b)
+  {
+    if (bignum_is_negative(&b))
+      return error_invalid_bignum;
+
+    size_t n = bignum_len_words(&b);
+    if (n > limbs)
+      return error_bignum_sz;
+
+    for (size_t i = 0; i < limbs; i++)
+      v[i] = i < n ? b.v[i] : 0;
+    return OK;
+  }
+
+  class c_out;
+
+  /** Returns a C bignum which writes to these limbs, for the result
+   *  of a C function:
+   *
+   *    bignum_modexp(r.out(), x, e, m);
+   *
+   *  It starts with this value, and tidies the limbs above the result
+   *  when the full expression ends.  The result must not be negative. */
+  c_out out()
+  {
+    return c_out(*this);
+  }
+};
+
+template <size_t Bits>
+class fixed_bignum<Bits>::c_out
+{
+public:
+  explicit c_out(fixed_bignum &f)
+    : f(f), b(f.view())
+  {
+    b.flags = 0;
+  }
+
+  c_out(const c_out &) = delete;
+  c_out &operator=(const c_out &) = delete;
+
+  ~c_out()
+  {
+    /* Words above vtop are undefined after a C function. */
+    for (uint32_t *p = b.vtop + 1; p < f.v + limbs; p++)
+      *p = 0;
+  }
+
+  operator bignum *()
+  {
+    return &b;
+  }
+
+private:
+  fixed_bignum &f;
+  bignum b;
+};
+
+/** r = a + b mod 2^Bits.  Returns the carry out. */
+template <size_t B>
+constexpr uint32_t add(fixed_bignum<B> &r, const fixed_bignum<B> &a, const fixed_bignum<B> &b)
+{
+  uint64_t carry = 0;
+  detail::unroll<fixed_bignum<B>::limbs>([&](auto i) {
+    uint64_t t = uint64_t(a.v[i]) + b.v[i] + carry;
+    r.v[i] = uint32_t(t);
+    carry = t >> 32;
+  });
+  return uint32_t(carry);
+}
+
+/** r = a - b mod 2^Bits.  Returns the borrow out. */
+template <size_t B>
+constexpr uint32_t sub(fixed_bignum<B> &r, const fixed_bignum<B> &a, const fixed_bignum<B> &b)
+{
+  uint32_t borrow = 0;
+  detail::unroll<fixed_bignum<B>::limbs>([&](auto i) {
+    uint64_t t = uint64_t(a.v[i]) - b.v[i] - borrow;
+    r.v[i] = uint32_t(t);
+    borrow = (t >> 32) & 1;
+  });
+  return borrow;
+}
+
+/** r = a if mask is all ones, or b if it is zero. */
+template <size_t B>
+constexpr void select(fixed_bignum<B> &r, uint32_t mask,
+                      const fixed_bignum<B> &a, const fixed_bignum<B> &b)
+{
+  detail::unroll<fixed_bignum<B>::limbs>([&](auto i) {
+    r.v[i] = (a.v[i] & mask) | (b.v[i] & ~mask);
+  });
+}
+
+/** r = a * b, in full. */
+template <size_t B>
+constexpr void mul(fixed_bignum<2 * B> &r, const fixed_bignum<B> &a, const fixed_bignum<B> &b)
+{
+  constexpr size_t n = fixed_bignum<B>::limbs;
+  r = fixed_bignum<2 * B>();
+
+  detail::unroll_small<n>([&](auto i) {
+    uint64_t carry = 0;
+    uint32_t ai = a.v[i];
+
+    detail::unroll<n>([&](auto j) {
+      uint64_t t = uint64_t(ai) * b.v[j] + r.v[i + j] + carry;
+      r.v[i + j] = uint32_t(t);
+      carry = t >> 32;
+    });
+
+    r.v[i + n] = uint32_t(carry);
+  });
+}
+
+/** r = a^2, in full.  Each cross product is computed once, then
+ *  doubled. */
+template <size_t B>
+constexpr void sqr(fixed_bignum<2 * B> &r, const fixed_bignum<B> &a)
+{
+  constexpr size_t n = fixed_bignum<B>::limbs;
+  r = fixed_bignum<2 * B>();
+
+  /* Cross products a[i] a[j] for i < j. */
+  detail::unroll_small<n - 1>([&](auto i) {
+    uint64_t carry = 0;
+    uint32_t ai = a.v[i];
+
+    detail::unroll<n>([&](auto j) {
+      if (j > i)
+      {
+        uint64_t t = uint64_t(ai) * a.v[j] + r.v[i + j] + carry;
+        r.v[i + j] = uint32_t(t);
+        carry = t >> 32;
+      }
+    });
+
+    r.v[i + n] = uint32_t(carry);
+  });
+
+  /* Double them, and add the squares a[i]^2. */
+  uint32_t top = 0;
+  detail::unroll<2 * n>([&](auto i) {
+    uint32_t w = r.v[i];
+    r.v[i] = (w << 1) | top;
+    top = w >> 31;
+  });
+
+  uint64_t carry = 0;
+  detail::unroll<n>([&](auto i) {
+    uint64_t sq = uint64_t(a.v[i]) * a.v[i];
+    uint64_t lo = uint64_t(r.v[2 * i]) + uint32_t(sq) + carry;
+    r.v[2 * i] = uint32_t(lo);
+    uint64_t hi = uint64_t(r.v[2 * i + 1]) + (sq >> 32) + (lo >> 32);
+    r.v[2 * i + 1] = uint32_t(hi);
+    carry = hi >> 32;
+  });
+}
+
+template <size_t B>
+constexpr fixed_bignum<B> operator+(const fixed_bignum<B> &a, const fixed_bignum<B> &b)
+{
+  fixed_bignum<B> r;
+  add(r, a, b);
+  return r;
+}
+
+template <size_t B>
+constexpr fixed_bignum<B> operator-(const fixed_bignum<B> &a, const fixed_bignum<B> &b)
+{
+  fixed_bignum<B> r;
+  sub(r, a, b);
+  return r;
+}
+
+template <size_t B>
+constexpr bool operator==(const fixed_bignum<B> &a, const fixed_bignum<B> &b)
+{
+  uint32_t diff = 0;
+  detail::unroll<fixed_bignum<B>::limbs>([&](auto i) { diff |= a.v[i] ^ b.v[i]; });
+  return diff == 0;
+}
+
+template <size_t B>
+constexpr bool operator!=(const fixed_bignum<B> &a, const fixed_bignum<B> &b)
+{
+  return !(a == b);
+}
+
+template <size_t B>
+constexpr bool operator<(const fixed_bignum<B> &a, const fixed_bignum<B> &b)
+{
+  fixed_bignum<B> t;
+  return sub(t, a, b);
+}
+
+/**
+ * Montgomery multiplication modulo an odd m < 2^Bits, with
+ * R = 2^Bits.
+ *
+ * Values in the Montgomery domain are xR mod m; to_mont and
+ * from_mont convert.  All inputs must be less than m.
+ */
+template <size_t Bits>
+class montgomery
+{
+public:
+  using value = fixed_bignum<Bits>;
+  static constexpr size_t limbs = value::limbs;
+
+  constexpr explicit montgomery(const value &modulus)
+    : m(modulus)
+  {
+    if (!m.is_odd())
+      detail::bad_constant();
+
+    /* n0 = -1/m mod 2^32, by Newton's method: each step doubles
+     * the number of correct bits. */
+    uint32_t inv = m.v[0];
+    for (int i = 0; i < 5; i++)
+      inv *= 2 - m.v[0] * inv;
+    n0 = -inv;
+
+    /* R mod m, then R^2 mod m, by doubling from 1. */
+    value x(1);
+    for (size_t i = 0; i < 2 * Bits; i++)
+    {
+      if (i == Bits)
+        one_ = x;
+
+      value twice, reduced;
+      uint32_t carry = add(twice, x, x);
+      uint32_t borrow = sub(reduced, twice, m);
+      select(x, detail::mask_if(carry | (borrow ^ 1)), reduced, twice);
+    }
+    r2 = x;
+  }
+
+  constexpr const value &modulus() const { return m; }
+
+  /** Returns R mod m, which is 1 in the Montgomery domain. */
+  constexpr const value &one() const { return one_; }
+
+  /** Returns a b R^-1 mod m. */
+  constexpr value mul(const value &a, const value &b) const
+  {
+    /* CIOS: interleave multiplying by a word of b with reducing
+     * by a multiple of m that clears the bottom word. */
+    uint32_t t[limbs + 2] = {};
+
+    detail::unroll_small<limbs>([&](auto i) {
+      uint64_t carry = 0;
+      uint32_t bi = b.v[i];
+
+      detail::unroll<limbs>([&](auto j) {
+        uint64_t s = uint64_t(a.v[j]) * bi + t[j] + carry;
+        t[j] = uint32_t(s);
+        carry = s >> 32;
+      });
+
+      uint64_t s = uint64_t(t[limbs]) + carry;
+      t[limbs] = uint32_t(s);
+      t[limbs + 1] = uint32_t(s >> 32);
+
+      uint32_t q = t[0] * n0;
+      carry = (uint64_t(q) * m.v[0] + t[0]) >> 32;
+
+      detail::unroll<limbs - 1>([&](auto j) {
+        uint64_t s = uint64_t(q) * m.v[j + 1] + t[j + 1] + carry;
+        t[j] = uint32_t(s);
+        carry = s >> 32;
+      });
+
+      s = uint64_t(t[limbs]) + carry;
+      t[limbs - 1] = uint32_t(s);
+      t[limbs] = t[limbs + 1] + uint32_t(s >> 32);
+    });
+
+    /* t < 2m, so one conditional subtraction finishes the job. */
+    value r, reduced;
+    detail::unroll<limbs>([&](auto j) { r.v[j] = t[j]; });
+    uint32_t borrow = sub(reduced, r, m);
+    select(r, detail::mask_if(t[limbs] | (borrow ^ 1)), reduced, r);
+    return r;
+  }
+
+  constexpr value sqr(const value &a) const
+  {
+    return mul(a, a);
+  }
+
+  constexpr value to_mont(const value &a) const
+  {
+    return mul(a, r2);
+  }
+
+  constexpr value from_mont(const value &aR) const
+  {
+    return mul(aR, value(1));
+  }
+
+  /** Returns x^e in the Montgomery domain, for xR in it.  This
+   *  always multiplies, so the time taken doesn't depend on e. */
+  template <size_t EB>
+  constexpr value pow(const value &xR, const fixed_bignum<EB> &e) const
+  {
+    value acc = one_;
+
+    for (size_t i = EB; i > 0; i--)
+    {
+      acc = sqr(acc);
+      value prod = mul(acc, xR);
+      uint32_t bit = (e.v[(i - 1) / BIGNUM_BITS] >> ((i - 1) % BIGNUM_BITS)) & 1;
+      select(acc, -bit, prod, acc);
+    }
+
+    return acc;
+  }
+
+private:
+  value m, one_, r2;
+  uint32_t n0 = 0;
+};
+
+}
+
+#endif
@@ -12,8 +12,8 @@ error bignum_gcd(bignum *v, const bignum *fx, const bignum *fy)
   assert(!bignum_check(fx));
   assert(!bignum_check(fy));
 
-  BIGNUM_TMP(x);
-  BIGNUM_TMP(y);
+  BIGNUM_SCRATCH_FOR(x, bignum_len_words(fx), fx);
+  BIGNUM_SCRATCH_FOR(y, bignum_len_words(fy), fy);
 
   ER(bignum_dup(&x, fx));
   ER(bignum_dup(&y, fy));
@@ -24,6 +24,11 @@ error bignum_gcd(bignum *v, const bignum *fx, const bignum *fy)
   if (bignum_lt(&x, &y))
     SWAP(x, y);
 
+  /* gcd(x, 0) = x.  The loop below needs y odd, so would never
+   * finish. */
+  if (bignum_is_zero(&y))
+    return bignum_dup(v, &x);
+
   /* This is HAC Algorithm 14.54.
    *
    * We don't store g, but instead count the number of
@@ -85,8 +90,8 @@ error bignum_extended_gcd(bignum *v, bignum *a, bignum *b,
   assert(!bignum_check(fx));
   assert(!bignum_check(fy));
 
-  BIGNUM_TMP(x);
-  BIGNUM_TMP(y);
+  BIGNUM_SCRATCH_FOR(x, bignum_len_words(fx), fx);
+  BIGNUM_SCRATCH_FOR(y, bignum_len_words(fy), fy);
 
   ER(bignum_dup(&x, fx));
   ER(bignum_dup(&y, fy));
@@ -120,9 +125,11 @@ error bignum_extended_gcd(bignum *v, bignum *a, bignum *b,
    *    C <- 0
    *    D <- 1
    */
-  BIGNUM_TMP(tmpu);
-  BIGNUM_TMP(tmpA);
-  BIGNUM_TMP(tmpB);
+  size_t words = MAX(bignum_len_words(&x), bignum_len_words(&y)) + 2;
+  const bignum *big = bignum_len_words(fx) > bignum_len_words(fy) ? fx : fy;
+  BIGNUM_SCRATCH_FOR(tmpu, words, big);
+  BIGNUM_SCRATCH_FOR(tmpA, words, big);
+  BIGNUM_SCRATCH_FOR(tmpB, words, big);
 
   bignum *A = &tmpA,
          *B = &tmpB,
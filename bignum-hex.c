@@ -0,0 +1,275 @@
+#include "bignum-hex.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+# define BIGNUM_HEX_X86 1
+# include <immintrin.h>
+#endif
+
+static const char hex_chars[] = "0123456789abcdef";
+
+static void encode_scalar(char *out, const uint32_t *v, size_t words)
+{
+  for (size_t i = words; i > 0; i--)
+  {
+    uint32_t w = v[i - 1];
+
+    for (unsigned j = 8; j > 0; j--)
+    {
+      out[j - 1] = hex_chars[w & 0xf];
+      w >>= 4;
+    }
+
+    out += 8;
+  }
+}
+
+static unsigned decode_scalar(uint32_t *v, const char *in, size_t words)
+{
+  for (size_t i = words; i > 0; i--)
+  {
+    uint32_t w = 0;
+
+    for (unsigned j = 0; j < 8; j++)
+    {
+      char c = *in++;
+      char l = c | 0x20;
+      uint32_t nibble;
+
+      if (c >= '0' && c <= '9')
+        nibble = c - '0';
+      else if (l >= 'a' && l <= 'f')
+        nibble = l - 'a' + 10;
+      else
+        return 1;
+
+      w = (w << 4) | nibble;
+    }
+
+    v[i - 1] = w;
+  }
+
+  return 0;
+}
+
+#ifdef BIGNUM_HEX_X86
+
+/* The vector versions work on blocks of words from v[0] up.
+ * Within a block, the bytes are reversed so the most significant
+ * comes first, then split into nibbles and looked up with pshufb.
+ *
+ * Decoding goes the other way, validating with compares: c is a
+ * hex digit iff c - '0' is in [0, 10) or (c | 0x20) - 'a' is in
+ * [0, 6).  Pairs of nibbles are joined with pmaddubsw. */
+
+__attribute__((target("ssse3")))
+static void encode_ssse3(char *out, const uint32_t *v, size_t words)
+{
+  const __m128i rev = _mm_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8,
+                                    7, 6, 5, 4, 3, 2, 1, 0);
+  const __m128i lut = _mm_loadu_si128((const __m128i *) hex_chars);
+  const __m128i mask = _mm_set1_epi8(0x0f);
+
+  size_t i = 0;
+  for (; i + 4 <= words; i += 4)
+  {
+    __m128i x = _mm_loadu_si128((const __m128i *) (v + i));
+    x = _mm_shuffle_epi8(x, rev);
+
+    __m128i hi = _mm_shuffle_epi8(lut, _mm_and_si128(_mm_srli_epi16(x, 4), mask));
+    __m128i lo = _mm_shuffle_epi8(lut, _mm_and_si128(x, mask));
+
+    char *dst = out + 8 * (words - i - 4);
+    _mm_storeu_si128((__m128i *) dst, _mm_unpacklo_epi8(hi, lo));
+    _mm_storeu_si128((__m128i *) (dst + 16), _mm_unpackhi_epi8(hi, lo));
+  }
+
+  encode_scalar(out, v + i, words - i);
+}
+
+/* Returns the nibble values of the characters in c, and clears
+ * *ok if any are not hex digits. */
+__attribute__((target("ssse3")))
+static __m128i nibbles_ssse3(__m128i c, unsigned *ok)
+{
+  __m128i d = _mm_sub_epi8(c, _mm_set1_epi8('0'));
+  __m128i l = _mm_sub_epi8(_mm_or_si128(c, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+
+  __m128i is_digit = _mm_and_si128(_mm_cmpgt_epi8(d, _mm_set1_epi8(-1)),
+                                   _mm_cmplt_epi8(d, _mm_set1_epi8(10)));
+  __m128i is_letter = _mm_and_si128(_mm_cmpgt_epi8(l, _mm_set1_epi8(-1)),
+                                    _mm_cmplt_epi8(l, _mm_set1_epi8(6)));
+
+  if (_mm_movemask_epi8(_mm_or_si128(is_digit, is_letter)) != 0xffff)
+    *ok = 0;
+
+  return _mm_or_si128(_mm_and_si128(is_digit, d),
+                      _mm_and_si128(is_letter, _mm_add_epi8(l, _mm_set1_epi8(10))));
+}
+
+__attribute__((target("ssse3")))
+static unsigned decode_ssse3(uint32_t *v, const char *in, size_t words)
+{
+  const __m128i rev = _mm_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8,
+                                    7, 6, 5, 4, 3, 2, 1, 0);
+  const __m128i join = _mm_set1_epi16(0x0110);
+  unsigned ok = 1;
+
+  size_t i = 0;
+  for (; i + 4 <= words; i += 4)
+  {
+    const char *src = in + 8 * (words - i - 4);
+    __m128i c0 = _mm_loadu_si128((const __m128i *) src);
+    __m128i c1 = _mm_loadu_si128((const __m128i *) (src + 16));
+
+    __m128i b0 = _mm_maddubs_epi16(nibbles_ssse3(c0, &ok), join);
+    __m128i b1 = _mm_maddubs_epi16(nibbles_ssse3(c1, &ok), join);
+
+    __m128i x = _mm_shuffle_epi8(_mm_packus_epi16(b0, b1), rev);
+    _mm_storeu_si128((__m128i *) (v + i), x);
+  }
+
+  if (!ok)
+    return 1;
+
+  return decode_scalar(v + i, in, words - i);
+}
+
+__attribute__((target("avx2")))
+static void encode_avx2(char *out, const uint32_t *v, size_t words)
+{
+  const __m256i rev = _mm256_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8,
+                                       7, 6, 5, 4, 3, 2, 1, 0,
+                                       15, 14, 13, 12, 11, 10, 9, 8,
+                                       7, 6, 5, 4, 3, 2, 1, 0);
+  const __m256i lut = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i *) hex_chars));
+  const __m256i mask = _mm256_set1_epi8(0x0f);
+
+  size_t i = 0;
+  for (; i + 8 <= words; i += 8)
+  {
+    __m256i x = _mm256_loadu_si256((const __m256i *) (v + i));
+    x = _mm256_permute4x64_epi64(_mm256_shuffle_epi8(x, rev), 0x4e);
+
+    __m256i hi = _mm256_shuffle_epi8(lut, _mm256_and_si256(_mm256_srli_epi16(x, 4), mask));
+    __m256i lo = _mm256_shuffle_epi8(lut, _mm256_and_si256(x, mask));
+
+    /* unpack works within lanes, so put the lanes back in order. */
+    __m256i a = _mm256_unpacklo_epi8(hi, lo);
+    __m256i b = _mm256_unpackhi_epi8(hi, lo);
+
+    char *dst = out + 8 * (words - i - 8);
+    _mm256_storeu_si256((__m256i *) dst, _mm256_permute2x128_si256(a, b, 0x20));
+    _mm256_storeu_si256((__m256i *) (dst + 32), _mm256_permute2x128_si256(a, b, 0x31));
+  }
+
+  encode_ssse3(out, v + i, words - i);
+}
+
+__attribute__((target("avx2")))
+static __m256i nibbles_avx2(__m256i c, unsigned *ok)
+{
+  __m256i d = _mm256_sub_epi8(c, _mm256_set1_epi8('0'));
+  __m256i l = _mm256_sub_epi8(_mm256_or_si256(c, _mm256_set1_epi8(0x20)),
+                              _mm256_set1_epi8('a'));
+
+  __m256i is_digit = _mm256_and_si256(_mm256_cmpgt_epi8(d, _mm256_set1_epi8(-1)),
+                                      _mm256_cmpgt_epi8(_mm256_set1_epi8(10), d));
+  __m256i is_letter = _mm256_and_si256(_mm256_cmpgt_epi8(l, _mm256_set1_epi8(-1)),
+                                       _mm256_cmpgt_epi8(_mm256_set1_epi8(6), l));
+
+  if (_mm256_movemask_epi8(_mm256_or_si256(is_digit, is_letter)) != -1)
+    *ok = 0;
+
+  return _mm256_or_si256(_mm256_and_si256(is_digit, d),
+                         _mm256_and_si256(is_letter,
+                                          _mm256_add_epi8(l, _mm256_set1_epi8(10))));
+}
+
+__attribute__((target("avx2")))
+static unsigned decode_avx2(uint32_t *v, const char *in, size_t words)
+{
+  const __m256i rev = _mm256_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8,
+                                       7, 6, 5, 4, 3, 2, 1, 0,
+                                       15, 14, 13, 12, 11, 10, 9, 8,
+                                       7, 6, 5, 4, 3, 2, 1, 0);
+  const __m256i join = _mm256_set1_epi16(0x0110);
+  unsigned ok = 1;
+
+  size_t i = 0;
+  for (; i + 8 <= words; i += 8)
+  {
+    const char *src = in + 8 * (words - i - 8);
+    __m256i c0 = _mm256_loadu_si256((const __m256i *) src);
+    __m256i c1 = _mm256_loadu_si256((const __m256i *) (src + 32));
+
+    __m256i b0 = _mm256_maddubs_epi16(nibbles_avx2(c0, &ok), join);
+    __m256i b1 = _mm256_maddubs_epi16(nibbles_avx2(c1, &ok), join);
+
+    /* packus works within lanes too; restore byte order, then
+     * reverse it. */
+    __m256i x = _mm256_permute4x64_epi64(_mm256_packus_epi16(b0, b1), 0xd8);
+    x = _mm256_permute4x64_epi64(_mm256_shuffle_epi8(x, rev), 0x4e);
+    _mm256_storeu_si256((__m256i *) (v + i), x);
+  }
+
+  if (!ok)
+    return 1;
+
+  return decode_ssse3(v + i, in, words - i);
+}
+
+#endif
+
+typedef void (*encode_fn)(char *out, const uint32_t *v, size_t words);
+typedef unsigned (*decode_fn)(uint32_t *v, const char *in, size_t words);
+
+static encode_fn encode_impl;
+static decode_fn decode_impl;
+
+/* Picks implementations on first use.  Racing threads pick the same
+ * ones, so there's no need for a lock. */
+static void select_impl(void)
+{
+  encode_fn enc = encode_scalar;
+  decode_fn dec = decode_scalar;
+
+#ifdef BIGNUM_HEX_X86
+  __builtin_cpu_init();
+
+  if (__builtin_cpu_supports("avx2"))
+  {
+    enc = encode_avx2;
+    dec = decode_avx2;
+  } else if (__builtin_cpu_supports("ssse3")) {
+    enc = encode_ssse3;
+    dec = decode_ssse3;
+  }
+#endif
+
+  __atomic_store_n(&decode_impl, dec, __ATOMIC_RELAXED);
+  __atomic_store_n(&encode_impl, enc, __ATOMIC_RELAXED);
+}
+
+void bignum_hex_encode_words(char *out, const uint32_t *v, size_t words)
+{
+  encode_fn enc = __atomic_load_n(&encode_impl, __ATOMIC_RELAXED);
+  if (!enc)
+  {
+    select_impl();
+    enc = __atomic_load_n(&encode_impl, __ATOMIC_RELAXED);
+  }
+
+  enc(out, v, words);
+}
+
+unsigned bignum_hex_decode_words(uint32_t *v, const char *in, size_t words)
+{
+  decode_fn dec = __atomic_load_n(&decode_impl, __ATOMIC_RELAXED);
+  if (!dec)
+  {
+    select_impl();
+    dec = __atomic_load_n(&decode_impl, __ATOMIC_RELAXED);
+  }
+
+  return dec(v, in, words);
+}
@@ -0,0 +1,25 @@
+#ifndef BIGNUM_HEX_H
+#define BIGNUM_HEX_H
+
+/*
+ * Bulk hex conversion of whole words.
+ *
+ * These have vectorised implementations, chosen at runtime
+ * according to what the CPU supports.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+/** Writes the 8 * words lower case hex characters for
+ *  v[words - 1] down to v[0] to out.  out is not terminated. */
+void bignum_hex_encode_words(char *out, const uint32_t *v, size_t words);
+
+/** Reads 8 * words hex characters from in, most significant
+ *  first, into v[words - 1] down to v[0].  Both cases are allowed.
+ *
+ *  Returns 1 if a character is not a hex digit, leaving v
+ *  meaningless; 0 otherwise. */
+unsigned bignum_hex_decode_words(uint32_t *v, const char *in, size_t words);
+
+#endif
@@ -0,0 +1,918 @@
+#ifndef BIGNUM_INTEGER_HPP
+#define BIGNUM_INTEGER_HPP
+
+/*
+ * Arbitrary sized integers for C++.
+ *
+ * integer owns its storage.  Values of up to inline_words words
+ * live inside the object; bigger ones are moved to growable storage
+ * from bignum_pool_allocator, which then grows as needed.  Moving an
+ * integer steals its heap storage, and leaves zero behind.
+ *
+ * Operators map onto the bignum_* functions, and take care of their
+ * aliasing rules: a *= a squares in place, and so on.
+ *
+ * Products, and sums and differences involving them, are lazy: they
+ * build a sum of terms which is evaluated straight into the integer
+ * it is assigned to.  So
+ *
+ *   r = a * b + c * d - e;
+ *
+ * multiplies a by b into r's storage, then accumulates c * d and e
+ * with bignum_muladd and bignum_sub, with no temporaries.  a * a
+ * squares, a * b % m is bignum_modmul, and a * b % modulus(m) uses
+ * Montgomery multiplication set up once for m.
+ *
+ * Expressions refer to their operands, and are meant to be used
+ * within the full expression that makes them: don't keep one in an
+ * auto variable.
+ *
+ * Errors from the C library are thrown as bignum_error.
+ */
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+#include "bignum.h"
+#include "bignum-monty.h"
+#include "bignum-reduce.h"
+#include "bignum-str.h"
+
+namespace bignum_cxx
+{
+
+/** An error returned by the C library. */
+class bignum_error : public std::runtime_error
+{
+public:
+  explicit bignum_error(error e)
+    : std::runtime_error(describe(e)), err(e)
+  {
+  }
+
+  error code() const noexcept
+  {
+    return err;
+  }
+
+private:
+  static const char *describe(error e)
+  {
+    switch (e)
+    {
+      case OK: return "OK";
+      case error_invalid_bignum: return "invalid bignum";
+      case error_buffer_sz: return "buffer too small";
+      case error_bignum_sz: return "bignum too small";
+      case error_invalid_string: return "invalid string";
+      case error_div_zero: return "division by zero";
+      case error_no_inverse: return "no inverse";
+      case error_no_sqrt: return "no square root";
+      case error_io: return "I/O error";
+      case error_infinity: return "point at infinity";
+    }
+    return "unknown error";
+  }
+
+  error err;
+};
+
+namespace detail
+{
+  inline void check(error e)
+  {
+    if (e != OK)
+      throw bignum_error(e);
+  }
+}
+
+class integer;
+class product;
+class modulus;
+template <size_t N> class sum;
+
+namespace detail
+{
+  /* x * y, or just x if y is null, added if sign is positive. */
+  struct term
+  {
+    const integer *x, *y;
+    int sign;
+  };
+
+  template <size_t N, size_t M>
+  sum<N + M> join(const sum<N> &a, const sum<M> &b, int sign);
+
+  sum<1> plain(const integer &x);
+}
+
+class integer
+{
+public:
+  /** Values of up to this many words are stored inline. */
+  static constexpr size_t inline_words = 4;
+
+  integer() noexcept
+  {
+    reset();
+  }
+
+  template <typename T, typename = std::enable_if_t<std::is_integral_v<T>>>
+  integer(T x)
+    : integer()
+  {
+    uint64_t mag = uint64_t(x);
+    if constexpr (std::is_signed_v<T>)
+    {
+      if (x < 0)
+        mag = -mag;
+    }
+
+    b.v[0] = uint32_t(mag);
+    b.v[1] = uint32_t(mag >> 32);
+    b.vtop = b.v + 1;
+    b.dirty = 2;
+
+    if constexpr (std::is_signed_v<T>)
+      bignum_setsign(&b, x < 0 ? -1 : 1);
+    bignum_canon(&b);
+  }
+
+  /** Parses s as bignum_parse_strl does: decimal, or hex with
+   *  a 0x prefix. */
+  explicit integer(std::string_view s)
+    : integer()
+  {
+    assign_from(s.size() / 8 + 1, [&](bignum *r) {
+      return bignum_parse_strl(r, s.data(), s.size());
+    });
+  }
+
+  /** Parses s in base, as bignum_parse_base does. */
+  static integer parse(std::string_view s, unsigned base)
+  {
+    integer r;
+    r.assign_from(s.size() / 8 + 1, [&](bignum *out) {
+      return bignum_parse_base(out, s.data(), s.size(), base);
+    });
+    return r;
+  }
+
+  integer(const integer &o)
+    : integer()
+  {
+    *this = o;
+  }
+
+  template <size_t N>
+  integer(const sum<N> &s)
+    : integer()
+  {
+    s.eval(*this);
+  }
+
+  integer(integer &&o) noexcept
+  {
+    steal(o);
+  }
+
+  ~integer()
+  {
+    if (!is_inline())
+      bignum_clear(&b);
+  }
+
+  integer &operator=(const integer &o)
+  {
+    if (this != &o)
+    {
+      reserve(o.words());
+      detail::check(bignum_dup(&b, &o.b));
+    }
+    return *this;
+  }
+
+  integer &operator=(integer &&o) noexcept
+  {
+    if (this != &o)
+    {
+      if (!is_inline())
+        bignum_clear(&b);
+      steal(o);
+    }
+    return *this;
+  }
+
+  /** Evaluates s into this integer's storage, unless this is one of
+   *  its operands. */
+  template <size_t N>
+  integer &operator=(const sum<N> &s)
+  {
+    if (s.uses(this))
+      return *this = integer(s);
+
+    s.eval(*this);
+    return *this;
+  }
+
+  /** Returns the C bignum holding this value.  It is only valid
+   *  until this integer is next changed. */
+  const bignum &view() const noexcept
+  {
+    return b;
+  }
+
+  /** Returns the C bignum holding this value, for the result of
+   *  a C function, with space for at least words words:
+   *
+   *    bignum_monty_modexp(r.out(m.words()), x, e, m, &ctx);
+   *
+   *  Once spilled from inline storage it is growable. */
+  bignum *out(size_t words = 0)
+  {
+    reserve(words);
+    return &b;
+  }
+
+  /** Ensures there is space for values of words words. */
+  void reserve(size_t words)
+  {
+    if (words <= b.words)
+      return;
+
+    if (is_inline())
+      spill(words);
+    else
+      detail::check(bignum_reserve(&b, words));
+  }
+
+  /** Returns true if the value is stored inside this object. */
+  bool is_inline() const noexcept
+  {
+    return b.v == small;
+  }
+
+  size_t words() const noexcept
+  {
+    return bignum_len_words(&b);
+  }
+
+  size_t bits() const noexcept
+  {
+    return bignum_len_bits(&b);
+  }
+
+  bool is_zero() const noexcept
+  {
+    return bignum_is_zero(&b);
+  }
+
+  bool is_odd() const noexcept
+  {
+    return bignum_is_odd(&b);
+  }
+
+  bool is_negative() const noexcept
+  {
+    return bignum_is_negative(&b);
+  }
+
+  /** Returns -1, 0 or 1. */
+  int sign() const noexcept
+  {
+    return is_zero() ? 0 : bignum_getsign(&b);
+  }
+
+  /** Formats in base, as bignum_fmt_base does.  Decimal and hex
+   *  use bignum_fmt_dec and bignum_fmt_hex; hex has a 0x prefix. */
+  std::string to_string(unsigned base = 10) const
+  {
+    /* Enough for base 2, with a sign, 0x and the nul. */
+    std::string s(bits() + 5, '\0');
+
+    error err;
+    if (base == 10)
+      err = bignum_fmt_dec(&b, &s[0], s.size());
+    else if (base == 16)
+      err = bignum_fmt_hex(&b, &s[0], s.size());
+    else
+      err = bignum_fmt_base(&b, base, &s[0], s.size());
+    detail::check(err);
+
+    s.resize(strlen(s.c_str()));
+    return s;
+  }
+
+  friend std::ostream &operator<<(std::ostream &os, const integer &x)
+  {
+    return os << x.to_string();
+  }
+
+  /* --- Arithmetic --- */
+
+  integer &operator+=(const integer &o)
+  {
+    reserve(std::max(words(), o.words()) + 1);
+    detail::check(bignum_add(&b, &b, &o.b));
+    return *this;
+  }
+
+  integer &operator-=(const integer &o)
+  {
+    reserve(std::max(words(), o.words()) + 1);
+    detail::check(bignum_sub(&b, &b, &o.b));
+    return *this;
+  }
+
+  /** Accumulates the terms of s, with bignum_muladd for products. */
+  template <size_t N>
+  integer &operator+=(const sum<N> &s)
+  {
+    if (s.uses(this))
+      return *this += integer(s);
+
+    s.accumulate(*this, 1);
+    return *this;
+  }
+
+  template <size_t N>
+  integer &operator-=(const sum<N> &s)
+  {
+    if (s.uses(this))
+      return *this -= integer(s);
+
+    s.accumulate(*this, -1);
+    return *this;
+  }
+
+  integer &operator*=(const integer &o);
+
+  integer &operator/=(const integer &o)
+  {
+    return *this = *this / o;
+  }
+
+  integer &operator%=(const integer &o)
+  {
+    return *this = *this % o;
+  }
+
+  integer &operator<<=(size_t n)
+  {
+    reserve(words() + n / BIGNUM_BITS + 1);
+    detail::check(bignum_shl(&b, n));
+    return *this;
+  }
+
+  integer &operator>>=(size_t n)
+  {
+    detail::check(bignum_shr(&b, n));
+    return *this;
+  }
+
+  integer operator-() const &
+  {
+    integer r = *this;
+    bignum_neg(&r.b);
+    return r;
+  }
+
+  integer operator-() &&
+  {
+    bignum_neg(&b);
+    return std::move(*this);
+  }
+
+  friend integer operator+(const integer &a, const integer &b)
+  {
+    integer r;
+    r.assign_from(std::max(a.words(), b.words()) + 1, [&](bignum *out) {
+      return bignum_add(out, &a.b, &b.b);
+    });
+    return r;
+  }
+
+  friend integer operator+(integer &&a, const integer &b)
+  {
+    a += b;
+    return std::move(a);
+  }
+
+  friend integer operator-(const integer &a, const integer &b)
+  {
+    integer r;
+    r.assign_from(std::max(a.words(), b.words()) + 1, [&](bignum *out) {
+      return bignum_sub(out, &a.b, &b.b);
+    });
+    return r;
+  }
+
+  friend integer operator-(integer &&a, const integer &b)
+  {
+    a -= b;
+    return std::move(a);
+  }
+
+  /** a * b, evaluated when assigned (see product). */
+  friend product operator*(const integer &a, const integer &b);
+
+  /** Quotient, as bignum_div. */
+  friend integer operator/(const integer &a, const integer &b)
+  {
+    integer r;
+    r.assign_from(a.words() + 1, [&](bignum *out) {
+      return bignum_div(out, &a.b, &b.b);
+    });
+    return r;
+  }
+
+  /** Remainder, as bignum_mod. */
+  friend integer operator%(const integer &a, const integer &b)
+  {
+    integer r;
+    r.assign_from(a.words() + 2, [&](bignum *out) {
+      return bignum_mod(out, &a.b, &b.b);
+    });
+    return r;
+  }
+
+  friend integer operator<<(integer a, size_t n)
+  {
+    return std::move(a <<= n);
+  }
+
+  friend integer operator>>(integer a, size_t n)
+  {
+    return std::move(a >>= n);
+  }
+
+  /** Returns the quotient and remainder, as bignum_divmod. */
+  friend std::pair<integer, integer> divmod(const integer &a, const integer &b)
+  {
+    std::pair<integer, integer> qr;
+    qr.first.reserve(a.words() + 1);
+    qr.second.reserve(a.words() + 2);
+    detail::check(bignum_divmod(&qr.first.b, &qr.second.b, &a.b, &b.b));
+    return qr;
+  }
+
+  /** a ^ e mod m, as bignum_modexp. */
+  friend integer pow_mod(const integer &a, const integer &e, const integer &m)
+  {
+    integer r;
+    r.assign_from(m.words() + 2, [&](bignum *out) {
+      return bignum_modexp(out, &a.b, &e.b, &m.b);
+    });
+    return r;
+  }
+
+  /** a * b mod m, as bignum_modmul. */
+  friend integer mul_mod(const integer &a, const integer &b, const integer &m)
+  {
+    integer r;
+    r.assign_from(m.words() + 2, [&](bignum *out) {
+      return bignum_modmul(out, &a.b, &b.b, &m.b);
+    });
+    return r;
+  }
+
+  /** a ^ -1 mod m.  Throws error_no_inverse if there isn't one. */
+  friend integer inverse_mod(const integer &a, const integer &m)
+  {
+    integer r;
+    r.assign_from(m.words() + 2, [&](bignum *out) {
+      return bignum_modinv(out, &a.b, &m.b);
+    });
+    return r;
+  }
+
+  friend integer gcd(const integer &a, const integer &b)
+  {
+    integer r;
+    r.assign_from(std::max(a.words(), b.words()), [&](bignum *out) {
+      return bignum_gcd(out, &a.b, &b.b);
+    });
+    return r;
+  }
+
+  /** floor(sqrt(a)).  Throws error_invalid_bignum if a is negative. */
+  friend integer sqrt(const integer &a)
+  {
+    integer r;
+    r.assign_from(a.words() / 2 + 1, [&](bignum *out) {
+      return bignum_sqrt(out, nullptr, &a.b);
+    });
+    return r;
+  }
+
+  /* --- Comparison --- */
+
+  friend bool operator==(const integer &a, const integer &b) noexcept
+  {
+    return bignum_eq(&a.b, &b.b);
+  }
+
+  friend bool operator!=(const integer &a, const integer &b) noexcept
+  {
+    return !bignum_eq(&a.b, &b.b);
+  }
+
+  friend bool operator<(const integer &a, const integer &b) noexcept
+  {
+    return bignum_lt(&a.b, &b.b);
+  }
+
+  friend bool operator<=(const integer &a, const integer &b) noexcept
+  {
+    return bignum_lte(&a.b, &b.b);
+  }
+
+  friend bool operator>(const integer &a, const integer &b) noexcept
+  {
+    return bignum_gt(&a.b, &b.b);
+  }
+
+  friend bool operator>=(const integer &a, const integer &b) noexcept
+  {
+    return bignum_gte(&a.b, &b.b);
+  }
+
+private:
+  template <size_t N> friend class sum;
+  friend class product;
+  friend class modulus;
+
+  uint32_t small[inline_words];
+  bignum b;
+
+  /* Sets this to an inline zero, forgetting any heap storage. */
+  void reset() noexcept
+  {
+    small[0] = 0;
+    b = bignum { small, small, inline_words, 0, 1, nullptr };
+  }
+
+  /* Takes o's value, leaving o zero.  Heap storage changes hands;
+   * inline values are copied. */
+  void steal(integer &o) noexcept
+  {
+    b = o.b;
+    if (o.is_inline())
+    {
+      memcpy(small, o.small, sizeof small);
+      b.v = small;
+      b.vtop = small + (o.b.vtop - o.small);
+    }
+    o.reset();
+  }
+
+  /* Moves an inline value to growable storage for words words. */
+  void spill(size_t words)
+  {
+    bignum heap;
+    detail::check(bignum_init_growable(&heap, std::max(words, 2 * inline_words),
+                                       &bignum_pool_allocator));
+
+    error err = bignum_dup(&heap, &b);
+    if (err != OK)
+    {
+      bignum_clear(&heap);
+      throw bignum_error(err);
+    }
+
+    b = heap;
+  }
+
+  /* Sets this to the result f writes to the bignum it's given.  f
+   * must not read this.  Space for words words is reserved first,
+   * and if that was a guess too small for inline storage, f is
+   * tried again once the storage can grow. */
+  template <typename F>
+  void assign_from(size_t words, F &&f)
+  {
+    reserve(words);
+
+    error err = f(&b);
+    if (err == error_bignum_sz && is_inline())
+    {
+      spill(2 * inline_words);
+      err = f(&b);
+    }
+
+    detail::check(err);
+  }
+};
+
+/** A sum of N terms, each a product or an integer, added or
+ *  subtracted.  Evaluation starts from an integer term if there is
+ *  one, otherwise the first product, and accumulates the rest in
+ *  place. */
+template <size_t N>
+class sum
+{
+public:
+  detail::term terms[N];
+
+  /** Returns true if r is an operand. */
+  bool uses(const integer *r) const noexcept
+  {
+    for (const detail::term &t : terms)
+    {
+      if (t.x == r || t.y == r)
+        return true;
+    }
+    return false;
+  }
+
+  /** Returns a guess at the size of the value, in words. */
+  size_t words() const noexcept
+  {
+    size_t w = 0;
+    for (const detail::term &t : terms)
+      w = std::max(w, t.x->words() + (t.y ? t.y->words() : 0));
+    return w + N - 1;
+  }
+
+  /** Sets r to the value.  r must not be an operand. */
+  void eval(integer &r) const
+  {
+    r.reserve(words());
+
+    size_t first = 0;
+    for (size_t i = 0; i < N; i++)
+    {
+      if (!terms[i].y)
+      {
+        first = i;
+        break;
+      }
+    }
+
+    set(r, terms[first]);
+    for (size_t i = 0; i < N; i++)
+    {
+      if (i != first)
+        accumulate(r, terms[i], 1);
+    }
+  }
+
+  /** Sets r += sign * value.  r must not be an operand. */
+  void accumulate(integer &r, int sign) const
+  {
+    for (const detail::term &t : terms)
+      accumulate(r, t, sign);
+  }
+
+  sum operator-() const
+  {
+    sum s = *this;
+    for (detail::term &t : s.terms)
+      t.sign = -t.sign;
+    return s;
+  }
+
+  template <size_t M>
+  friend sum<N + M> operator+(const sum &a, const sum<M> &b)
+  {
+    return detail::join(a, b, 1);
+  }
+
+  template <size_t M>
+  friend sum<N + M> operator-(const sum &a, const sum<M> &b)
+  {
+    return detail::join(a, b, -1);
+  }
+
+  friend sum<N + 1> operator+(const sum &a, const integer &b)
+  {
+    return detail::join(a, detail::plain(b), 1);
+  }
+
+  friend sum<N + 1> operator-(const sum &a, const integer &b)
+  {
+    return detail::join(a, detail::plain(b), -1);
+  }
+
+  friend sum<N + 1> operator+(const integer &a, const sum &b)
+  {
+    return detail::join(detail::plain(a), b, 1);
+  }
+
+  friend sum<N + 1> operator-(const integer &a, const sum &b)
+  {
+    return detail::join(detail::plain(a), b, -1);
+  }
+
+private:
+  static void set(integer &r, const detail::term &t)
+  {
+    if (!t.y)
+    {
+      r = *t.x;
+    } else {
+      r.assign_from(t.x->words() + t.y->words(), [&](bignum *out) {
+        return t.x == t.y ? bignum_sqr(out, &t.x->b)
+                          : bignum_mul(out, &t.x->b, &t.y->b);
+      });
+    }
+
+    if (t.sign < 0)
+      bignum_neg(&r.b);
+  }
+
+  static void accumulate(integer &r, const detail::term &t, int sign)
+  {
+    const bignum *x = &t.x->b;
+    sign *= t.sign;
+
+    if (!t.y)
+    {
+      r.reserve(std::max(r.words(), t.x->words()) + 1);
+      detail::check(sign > 0 ? bignum_add(&r.b, &r.b, x) : bignum_sub(&r.b, &r.b, x));
+    } else {
+      const bignum *y = &t.y->b;
+      r.reserve(std::max(r.words(), t.x->words() + t.y->words()) + 1);
+      detail::check(sign > 0 ? bignum_muladd(&r.b, x, y) : bignum_mulsub(&r.b, x, y));
+    }
+  }
+};
+
+namespace detail
+{
+  template <size_t N, size_t M>
+  sum<N + M> join(const sum<N> &a, const sum<M> &b, int sign)
+  {
+    sum<N + M> s;
+    for (size_t i = 0; i < N; i++)
+      s.terms[i] = a.terms[i];
+    for (size_t i = 0; i < M; i++)
+    {
+      s.terms[N + i] = b.terms[i];
+      s.terms[N + i].sign *= sign;
+    }
+    return s;
+  }
+
+  inline sum<1> plain(const integer &x)
+  {
+    sum<1> s;
+    s.terms[0] = term { &x, nullptr, 1 };
+    return s;
+  }
+}
+
+/** x * y, not yet evaluated.  As a sum of one term it evaluates
+ *  into the integer it is assigned to, and combines with + and -;
+ *  reduced by % it is a modular multiplication. */
+class product : public sum<1>
+{
+public:
+  product(const integer &x, const integer &y) noexcept
+  {
+    terms[0] = detail::term { &x, &y, 1 };
+  }
+
+  /** x * y mod m, by bignum_modmul. */
+  friend integer operator%(const product &p, const integer &m)
+  {
+    return p.reduce(m);
+  }
+
+private:
+  integer reduce(const integer &m) const
+  {
+    const detail::term &t = terms[0];
+    integer r;
+    r.assign_from(m.words() + 2, [&](bignum *out) {
+      return bignum_modmul(out, &t.x->b, &t.y->b, &m.b);
+    });
+    return r;
+  }
+};
+
+inline product operator*(const integer &a, const integer &b)
+{
+  return product(a, b);
+}
+
+inline integer &integer::operator*=(const integer &o)
+{
+  return *this = *this * o;
+}
+
+/** A positive modulus, with what's needed for multiplying by it set
+ *  up once.  Special moduli (2^k - c, P-256 and P-384) reduce in
+ *  linear time.  Other odd moduli use Montgomery multiplication, with
+ *  R^2 mod m so values enter the Montgomery domain by multiplication
+ *  rather than division.  Operands should be non-negative. */
+class modulus
+{
+public:
+  explicit modulus(integer m)
+    : m(std::move(m))
+  {
+    if (this->m.sign() <= 0)
+      throw bignum_error(error_invalid_bignum);
+
+    detail::check(bignum_reduce_setup(&this->m.b, &ctx));
+    if (ctx.kind == REDUCE_MONTY)
+    {
+      rr.assign_from(2 * this->m.words() + 2, [&](bignum *out) {
+        return bignum_monty_normalise2(out, &bignum_1, &this->m.b, &ctx.monty);
+      });
+    }
+  }
+
+  const integer &value() const noexcept
+  {
+    return m;
+  }
+
+  /** How products are reduced. */
+  reduce_kind kind() const noexcept
+  {
+    return ctx.kind;
+  }
+
+  /** x ^ e mod m. */
+  integer pow(const integer &x, const integer &e) const
+  {
+    integer r;
+    r.assign_from(2 * m.words() + 2, [&](bignum *out) {
+      if (ctx.kind == REDUCE_MONTY)
+        return bignum_monty_modexp(out, &x.b, &e.b, &m.b, &ctx.monty);
+      return bignum_reduce_modexp(out, &x.b, &e.b, &m.b, &ctx);
+    });
+    return r;
+  }
+
+  /** x * y mod m: by pseudo-Mersenne or Solinas reduction for
+   *  special m, bignum_monty_modmul_rr for other odd m. */
+  friend integer operator%(const product &p, const modulus &mod)
+  {
+    return mod.reduce(p);
+  }
+
+  friend integer operator%(const integer &x, const modulus &mod)
+  {
+    return x % mod.m;
+  }
+
+private:
+  integer reduce(const product &p) const
+  {
+    const detail::term &t = p.terms[0];
+    integer r;
+
+    switch (ctx.kind)
+    {
+      case REDUCE_MONTY:
+        r.assign_from(m.words() + 2, [&](bignum *out) {
+          return bignum_monty_modmul_rr(out, &t.x->b, &t.y->b, &m.b, &rr.b, &ctx.monty);
+        });
+        return r;
+
+      case REDUCE_GENERIC:
+        return p % m;
+
+      default:
+        r.assign_from(m.words() + 2, [&](bignum *out) {
+          return bignum_reduce_modmul(out, &t.x->b, &t.y->b, &m.b, &ctx);
+        });
+        return r;
+    }
+  }
+
+  integer m, rr;
+  reduce_ctx ctx;
+};
+
+/* So these are found for arguments which convert to integer. */
+integer operator+(const integer &a, const integer &b);
+integer operator-(const integer &a, const integer &b);
+integer operator/(const integer &a, const integer &b);
+integer operator%(const integer &a, const integer &b);
+bool operator==(const integer &a, const integer &b) noexcept;
+bool operator!=(const integer &a, const integer &b) noexcept;
+bool operator<(const integer &a, const integer &b) noexcept;
+bool operator<=(const integer &a, const integer &b) noexcept;
+bool operator>(const integer &a, const integer &b) noexcept;
+bool operator>=(const integer &a, const integer &b) noexcept;
+std::pair<integer, integer> divmod(const integer &a, const integer &b);
+integer pow_mod(const integer &a, const integer &e, const integer &m);
+integer mul_mod(const integer &a, const integer &b, const integer &m);
+integer inverse_mod(const integer &a, const integer &m);
+integer gcd(const integer &a, const integer &b);
+integer sqrt(const integer &a);
+
+}
+
+#endif
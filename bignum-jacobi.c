@@ -0,0 +1,126 @@
+#include <assert.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "bignum.h"
+#include "bignum-math.h"
+#include "handy.h"
+
+/* (2/n) = -1 iff n = 3 or 5 mod 8. */
+static unsigned two_is_nonresidue(uint64_t n)
+{
+  return (n & 7) == 3 || (n & 7) == 5;
+}
+
+/* Reciprocity: (a/n) = -(n/a) iff a = n = 3 mod 4. */
+static unsigned reciprocity_flips(uint64_t a, uint64_t n)
+{
+  return (a & 3) == 3 && (n & 3) == 3;
+}
+
+/* Returns the number of trailing zero bits in non-zero b. */
+static size_t trailing_zeroes(const bignum *b)
+{
+  const uint32_t *v = b->v;
+  size_t bits = 0;
+
+  while (*v == 0)
+  {
+    v++;
+    bits += BIGNUM_BITS;
+  }
+
+  return bits + bignum_math_uint32_ctz(*v);
+}
+
+/* Returns the low 64 bits of b. */
+static uint64_t low_u64(const bignum *b)
+{
+  uint64_t r = b->v[0];
+  if (bignum_len_words(b) > 1)
+    r |= (uint64_t) b->v[1] << 32;
+  return r;
+}
+
+/* The same algorithm as below, in machine words.
+ * t is the sign accumulated so far. */
+static int jacobi_u64(uint64_t a, uint64_t n, int t)
+{
+  while (a)
+  {
+    unsigned z = __builtin_ctzll(a);
+    a >>= z;
+    if ((z & 1) && two_is_nonresidue(n))
+      t = -t;
+
+    if (a < n)
+    {
+      SWAP(a, n);
+      if (reciprocity_flips(a, n))
+        t = -t;
+    }
+
+    a -= n;
+  }
+
+  return n == 1 ? t : 0;
+}
+
+error bignum_jacobi(int *j, const bignum *fa, const bignum *fn)
+{
+  assert(!bignum_check(fa));
+  assert(!bignum_check(fn));
+
+  if (bignum_is_negative(fn) || bignum_is_even(fn))
+    return error_invalid_bignum;
+
+  /* a and n swap storage, so both need room for either. */
+  size_t words = MAX(bignum_len_words(fa), bignum_len_words(fn)) + 2;
+  BIGNUM_SCRATCH(tmp, words);
+  BIGNUM_SCRATCH(a, words);
+  BIGNUM_SCRATCH(n, words);
+
+  int t = 1;
+
+  /* a <- abs(a) mod n, using (-1/n) = -1 iff n = 3 mod 4. */
+  ER(bignum_dup(&tmp, fa));
+  bignum_abs(&tmp);
+  ER(bignum_mod(&a, &tmp, fn));
+  ER(bignum_dup(&n, fn));
+
+  if (bignum_is_negative(fa) && (n.v[0] & 3) == 3)
+    t = -t;
+
+  /* This is the binary Jacobi algorithm.  Rather than halving
+   * one bit at a time, whole runs of trailing zeroes are
+   * shifted out at once.  Once both operands fit in 64 bits
+   * we finish in machine words. */
+  while (!bignum_is_zero(&a))
+  {
+    if (bignum_len_words(&a) <= 2 && bignum_len_words(&n) <= 2)
+    {
+      *j = jacobi_u64(low_u64(&a), low_u64(&n), t);
+      return OK;
+    }
+
+    /* 1. Remove factors of two from a: (2/n) each. */
+    size_t z = trailing_zeroes(&a);
+    ER(bignum_shr(&a, z));
+    if ((z & 1) && two_is_nonresidue(n.v[0]))
+      t = -t;
+
+    /* 2. Make a >= n, by reciprocity. */
+    if (bignum_lt(&a, &n))
+    {
+      SWAP(a, n);
+      if (reciprocity_flips(a.v[0], n.v[0]))
+        t = -t;
+    }
+
+    /* 3. (a/n) = ((a - n)/n). */
+    ER(bignum_subl(&a, &n));
+  }
+
+  *j = bignum_eq32(&n, 1) ? t : 0;
+  return OK;
+}
@@ -38,6 +38,24 @@ void bignum_math_mul_accum(uint32_t *r, uint32_t *a, size_t w, uint32_t m)
   }
 }
 
+uint32_t bignum_math_mul_sub(uint32_t *r, const uint32_t *a, size_t w, uint32_t m)
+{
+  uint32_t carry = 0;
+
+  for (size_t i = 0; i < w; i++)
+  {
+    uint64_t p = (uint64_t) a[i] * m + carry;
+    uint32_t lo = (uint32_t) p;
+
+    /* If p >> 32 is 0xffffffff then lo is zero, so this can't
+     * overflow. */
+    carry = (uint32_t) (p >> 32) + (r[i] < lo);
+    r[i] -= lo;
+  }
+
+  return carry;
+}
+
 uint8_t bignum_math_uint32_fls(uint32_t v)
 {
   if (v)
@@ -45,3 +63,11 @@ uint8_t bignum_math_uint32_fls(uint32_t v)
   else
     return 0;
 }
+
+uint8_t bignum_math_uint32_ctz(uint32_t v)
+{
+  if (v)
+    return __builtin_ctz(v);
+  else
+    return 32;
+}
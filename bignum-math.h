@@ -17,10 +17,20 @@
  *  r and a have w words. */
 void bignum_math_mul_accum(uint32_t *r, uint32_t *a, size_t words, uint32_t m);
 
+/** Multiply a by m, subtracting the result from r.
+ *  r and a have w words.  Returns what must still be subtracted
+ *  from the words of r above w. */
+uint32_t bignum_math_mul_sub(uint32_t *r, const uint32_t *a, size_t words, uint32_t m);
+
 /** Returns the index of the top set bit of w.
  *
  *  Returns 0 if w is 0, 32 if w is 0xffffffff, 1 if w is 1,
  *  2 if w is 3, etc. */
 uint8_t bignum_math_uint32_fls(uint32_t w);
 
+/** Returns the number of trailing zero bits in w.
+ *
+ *  Returns 32 if w is 0, 0 if w is odd, 1 if w is 2, etc. */
+uint8_t bignum_math_uint32_ctz(uint32_t w);
+
 #endif
@@ -7,18 +7,15 @@
 //#define BIGNUM_DEBUG_ENABLED
 #include "bignum-dbg.h"
 #include "bignum-monty.h"
+#include "bignum-reduce.h"
 #include "handy.h"
 
-error bignum_monty_modexp(bignum *A, const bignum *x, const bignum *e, const bignum *m,
-                          monty_ctx *monty)
+error bignum_monty_modexp_normalised(bignum *A, const bignum *xR, const bignum *e, const bignum *m,
+                                     const monty_ctx *monty)
 {
-  /* 1. x' = Mont(x, R^2 mod m). */
-  BIGNUM_TMP(tmp);
-  BIGNUM_TMP(x_prime);
-  bignum_setu(&tmp, 1);
-  ER(bignum_monty_normalise2(&tmp, &tmp, m, monty));
-  ER(bignum_monty_modmul_normalised(&x_prime, x, &tmp, m, monty));
-  bignum_dump("x~", &x_prime);
+  assert(A != xR);
+
+  BIGNUM_SCRATCH_SECRET(tmp, bignum_len_words(m) + 2);
 
   /* A = R mod m. */
   bignum_setu(A, 1);
@@ -35,11 +32,28 @@ error bignum_monty_modexp(bignum *A, const bignum *x, const bignum *e, const big
     /* 2.2 If ei == 1 then A = Mont(A, x') */
     if (bignum_get_bit(e, i - 1) == 1)
     {
-      ER(bignum_monty_modmul_normalised(&tmp, A, &x_prime, m, monty));
+      ER(bignum_monty_modmul_normalised(&tmp, A, xR, m, monty));
       ER(bignum_dup(A, &tmp));
     }
   }
 
+  return OK;
+}
+
+error bignum_monty_modexp(bignum *A, const bignum *x, const bignum *e, const bignum *m,
+                          const monty_ctx *monty)
+{
+  /* 1. x' = Mont(x, R^2 mod m).  Reducing R^2 needs room for it. */
+  BIGNUM_SCRATCH(tmp, 2 * bignum_len_words(m) + 3);
+  BIGNUM_SCRATCH_SECRET(x_prime, bignum_len_words(m) + 2);
+  bignum_setu(&tmp, 1);
+  ER(bignum_monty_normalise2(&tmp, &tmp, m, monty));
+  ER(bignum_monty_modmul_normalised(&x_prime, x, &tmp, m, monty));
+  bignum_dump("x~", &x_prime);
+
+  /* 2. A = x' ^ e, in the Montgomery domain. */
+  ER(bignum_monty_modexp_normalised(A, &x_prime, e, m, monty));
+
   /* 3. A = Mont(A, 1) */
   bignum_setu(&x_prime, 1);
   ER(bignum_monty_modmul_normalised(&tmp, A, &x_prime, m, monty));
@@ -49,7 +63,7 @@ error bignum_monty_modexp(bignum *A, const bignum *x, const bignum *e, const big
 
 error bignum_slow_modexp(bignum *r, const bignum *a, const bignum *b, const bignum *p)
 {
-  BIGNUM_TMP(S);
+  BIGNUM_SCRATCH(S, MAX(bignum_len_words(a), bignum_len_words(p)) + 2);
   ER(bignum_dup(&S, a));
   bignum_setu(r, 1);
   for (size_t i = 0; i < bignum_len_bits(b); i++)
@@ -71,6 +85,10 @@ error bignum_modexp(bignum *r, const bignum *a, const bignum *b, const bignum *p
   assert(!bignum_check(b));
   assert(!bignum_check(p));
   
+  reduce_ctx ctx;
+  if (bignum_reduce_setup(p, &ctx) == OK && bignum_reduce_is_special(&ctx))
+    return bignum_reduce_modexp(r, a, b, p, &ctx);
+
   monty_ctx monty;
   if (bignum_monty_setup(p, &monty))
     return bignum_monty_modexp(r, a, b, p, &monty);
@@ -13,8 +13,9 @@ error bignum_modinv(bignum *z, const bignum *a, const bignum *m)
   assert(!bignum_check(a));
   assert(!bignum_check(m));
 
-  BIGNUM_TMP(gcd);
-  BIGNUM_TMP(y);
+  size_t words = MAX(bignum_len_words(a), bignum_len_words(m)) + 2;
+  BIGNUM_SCRATCH(gcd, words);
+  BIGNUM_SCRATCH(y, words);
 
   ER(bignum_extended_gcd(&gcd, z, &y, a, m));
 
@@ -5,6 +5,7 @@
 
 #include "bignum.h"
 #include "bignum-monty.h"
+#include "bignum-reduce.h"
 #include "bignum-dbg.h"
 #include "handy.h"
 
@@ -15,7 +16,7 @@ static error bignum_modmul_slow(bignum *r, const bignum *a, const bignum *b, con
   assert(!bignum_check(b));
   assert(!bignum_check(p));
 
-  BIGNUM_TMP(tmp);
+  BIGNUM_SCRATCH(tmp, bignum_len_words(a) + bignum_len_words(b));
 
   ER(bignum_mul(&tmp, a, b));
   return bignum_mod(r, &tmp, p);
@@ -23,10 +24,10 @@ static error bignum_modmul_slow(bignum *r, const bignum *a, const bignum *b, con
 
 error bignum_modmul(bignum *r, const bignum *a, const bignum *b, const bignum *p)
 {
-  monty_ctx monty;
-  if (bignum_monty_setup(p, &monty))
+  reduce_ctx ctx;
+  if (bignum_reduce_setup(p, &ctx) == OK)
   {
-    return bignum_monty_modmul(r, a, b, p, &monty);
+    return bignum_reduce_modmul(r, a, b, p, &ctx);
   } else {
     return bignum_modmul_slow(r, a, b, p);
   }
@@ -0,0 +1,251 @@
+#include <assert.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "bignum.h"
+#include "bignum-monty.h"
+#include "bignum-dbg.h"
+#include "handy.h"
+
+/* Space for a Montgomery product mod p, and for normalising a
+ * value below p (which reduces one of R times its size). */
+#define MONTY_WORDS(p) (bignum_len_words(p) + 2)
+#define NORMALISE_WORDS(p) (2 * bignum_len_words(p) + 2)
+
+/* Least quadratic non-residues searched for.  Under GRH the least is
+ * below 2 ln(p)^2, which this covers for p of a few thousand bits. */
+#define MODSQRT_MAX_Z (1u << 24)
+
+/* Sets r = a mod p, with 0 <= r < p. */
+static error reduce(bignum *r, const bignum *a, const bignum *p)
+{
+  BIGNUM_SCRATCH(mag, bignum_len_words(a));
+  ER(bignum_dup(&mag, a));
+  bignum_abs(&mag);
+  ER(bignum_mod(r, &mag, p));
+
+  if (bignum_is_negative(a) && !bignum_is_zero(r))
+    ER(bignum_sub(r, p, r));
+
+  return OK;
+}
+
+/* Sets a = a * b R^-1 mod p.  b may alias a. */
+static error mont_mul(bignum *a, const bignum *b, const bignum *p,
+                      const monty_ctx *monty)
+{
+  BIGNUM_SCRATCH(tmp, MONTY_WORDS(p));
+  ER(bignum_monty_modmul_normalised(&tmp, a, b, p, monty));
+  return bignum_dup(a, &tmp);
+}
+
+/* Sets a = a + b mod p, where a and b are already reduced. */
+static error add_mod(bignum *a, const bignum *b, const bignum *p)
+{
+  ER(bignum_addl(a, b));
+  if (bignum_gte(a, p))
+    ER(bignum_subl(a, p));
+  return OK;
+}
+
+error bignum_modsqrt_setup(const bignum *p, modsqrt_ctx *ctx)
+{
+  assert(!bignum_check(p));
+
+  if (bignum_is_negative(p) ||
+      bignum_len_bits(p) < 2 ||
+      !bignum_monty_setup(p, &ctx->monty))
+    return error_invalid_bignum;
+
+  /* p is odd, so p - 1 is p with the bottom bit cleared. */
+  ctx->S = 1;
+  while (bignum_get_bit(p, ctx->S) == 0)
+    ctx->S++;
+
+  ctx->z = 0;
+
+  /* Only Tonelli-Shanks needs a non-residue.  Every odd prime has
+   * one well below the bound; a composite p may not (eg. 9), or
+   * gives itself away with a common factor. */
+  if (ctx->S > 2)
+  {
+    uint32_t zw;
+    bignum z = { &zw, &zw, 1, 0, 0, NULL };
+
+    for (ctx->z = 2; ctx->z < MODSQRT_MAX_Z; ctx->z++)
+    {
+      int j;
+      zw = ctx->z;
+      if (bignum_gte(&z, p))
+        break;
+      ER(bignum_jacobi(&j, &z, p));
+      if (j == -1)
+        return OK;
+      if (j == 0)
+        break;
+    }
+
+    return error_invalid_bignum;
+  }
+
+  return OK;
+}
+
+/* p = 3 mod 4: root = a ^ ((p + 1) / 4). */
+static error sqrt_3mod4(bignum *root, const bignum *aR, const bignum *p,
+                        const monty_ctx *monty)
+{
+  BIGNUM_SCRATCH(e, bignum_len_words(p));
+  ER(bignum_dup(&e, p));
+  ER(bignum_shr(&e, 2));
+  ER(bignum_addl(&e, &bignum_1));
+  return bignum_monty_modexp_normalised(root, aR, &e, p, monty);
+}
+
+/* p = 5 mod 8: Atkin's algorithm.
+ *
+ *   v <- (2a) ^ ((p - 5) / 8)
+ *   i <- 2a v^2
+ *   root <- a v (i - 1)
+ */
+static error sqrt_5mod8(bignum *root, const bignum *aR, const bignum *oneR,
+                        const bignum *p, const monty_ctx *monty)
+{
+  BIGNUM_SCRATCH(e, bignum_len_words(p));
+  BIGNUM_SCRATCH(a2R, MONTY_WORDS(p));
+  BIGNUM_SCRATCH(v, MONTY_WORDS(p));
+  BIGNUM_SCRATCH(i, MONTY_WORDS(p));
+
+  ER(bignum_dup(&e, p));
+  ER(bignum_shr(&e, 3));
+
+  ER(bignum_dup(&a2R, aR));
+  ER(add_mod(&a2R, aR, p));
+
+  ER(bignum_monty_modexp_normalised(&v, &a2R, &e, p, monty));
+
+  ER(bignum_dup(&i, &v));
+  ER(mont_mul(&i, &v, p, monty));
+  ER(mont_mul(&i, &a2R, p, monty));
+
+  ER(bignum_subl(&i, oneR));
+  if (bignum_is_negative(&i))
+    ER(bignum_addl(&i, p));
+
+  ER(bignum_dup(root, aR));
+  ER(mont_mul(root, &v, p, monty));
+  ER(mont_mul(root, &i, p, monty));
+  return OK;
+}
+
+/* General case: Tonelli-Shanks.  All values are in the Montgomery domain. */
+static error sqrt_tonelli_shanks(bignum *root, const bignum *aR, const bignum *oneR,
+                                 const bignum *p, const modsqrt_ctx *ctx)
+{
+  const monty_ctx *monty = &ctx->monty;
+
+  BIGNUM_SCRATCH(Q, bignum_len_words(p));
+  BIGNUM_SCRATCH(c, MONTY_WORDS(p));
+  BIGNUM_SCRATCH(t, MONTY_WORDS(p));
+  BIGNUM_SCRATCH(b, MONTY_WORDS(p));
+  BIGNUM_SCRATCH(tmp, NORMALISE_WORDS(p));
+
+  /* 1. Q <- (p - 1) / 2^S. */
+  ER(bignum_dup(&Q, p));
+  ER(bignum_shr(&Q, ctx->S));
+
+  /* 2. c <- z^Q. */
+  bignum_setu(&tmp, ctx->z);
+  ER(bignum_monty_normalise(&tmp, &tmp, p, monty));
+  ER(bignum_monty_modexp_normalised(&c, &tmp, &Q, p, monty));
+
+  /* 3. t <- a^Q, root <- a^((Q + 1) / 2), M <- S. */
+  ER(bignum_monty_modexp_normalised(&t, aR, &Q, p, monty));
+  ER(bignum_shr(&Q, 1));
+  ER(bignum_addl(&Q, &bignum_1));
+  ER(bignum_monty_modexp_normalised(root, aR, &Q, p, monty));
+  size_t M = ctx->S;
+
+  /* 4. While t != 1: */
+  while (!bignum_eq(&t, oneR))
+  {
+    /* 4.1 Find least 0 < i < M such that t^(2^i) = 1. */
+    size_t i = 0;
+    ER(bignum_dup(&tmp, &t));
+    while (!bignum_eq(&tmp, oneR))
+    {
+      ER(mont_mul(&tmp, &tmp, p, monty));
+      i++;
+
+      /* No such i: a is not a square. */
+      if (i == M)
+        return error_no_sqrt;
+    }
+
+    /* 4.2 b <- c^(2^(M - i - 1)). */
+    ER(bignum_dup(&b, &c));
+    for (size_t j = 0; j < M - i - 1; j++)
+      ER(mont_mul(&b, &b, p, monty));
+
+    /* 4.3 M <- i, c <- b^2, t <- tc, root <- root * b. */
+    M = i;
+    ER(bignum_dup(&c, &b));
+    ER(mont_mul(&c, &b, p, monty));
+    ER(mont_mul(&t, &c, p, monty));
+    ER(mont_mul(root, &b, p, monty));
+  }
+
+  return OK;
+}
+
+error bignum_monty_modsqrt(bignum *r, const bignum *a, const bignum *p,
+                           const modsqrt_ctx *ctx)
+{
+  assert(!bignum_check_mutable(r));
+  assert(!bignum_check(a));
+  assert(!bignum_check(p));
+
+  const monty_ctx *monty = &ctx->monty;
+
+  BIGNUM_SCRATCH(x, MAX(bignum_len_words(a) + 1, MONTY_WORDS(p)));
+  ER(reduce(&x, a, p));
+
+  if (bignum_is_zero(&x))
+  {
+    bignum_setu(r, 0);
+    return OK;
+  }
+
+  BIGNUM_SCRATCH(xR, NORMALISE_WORDS(p));
+  BIGNUM_SCRATCH(oneR, NORMALISE_WORDS(p));
+  BIGNUM_SCRATCH(root, MONTY_WORDS(p));
+  BIGNUM_SCRATCH(tmp, MONTY_WORDS(p));
+
+  ER(bignum_monty_normalise(&xR, &x, p, monty));
+  bignum_setu(&oneR, 1);
+  ER(bignum_monty_normalise(&oneR, &oneR, p, monty));
+
+  if (ctx->S == 1)
+    ER(sqrt_3mod4(&root, &xR, p, monty));
+  else if (ctx->S == 2)
+    ER(sqrt_5mod8(&root, &xR, &oneR, p, monty));
+  else
+    ER(sqrt_tonelli_shanks(&root, &xR, &oneR, p, ctx));
+
+  /* The fast paths produce garbage for non-squares, so check. */
+  ER(bignum_dup(&tmp, &root));
+  ER(mont_mul(&tmp, &root, p, monty));
+  if (!bignum_eq(&tmp, &xR))
+    return error_no_sqrt;
+
+  /* Leave the Montgomery domain. */
+  ER(bignum_monty_modmul_normalised(&tmp, &root, &bignum_1, p, monty));
+  return bignum_dup(r, &tmp);
+}
+
+error bignum_modsqrt(bignum *r, const bignum *a, const bignum *p)
+{
+  modsqrt_ctx ctx;
+  ER(bignum_modsqrt_setup(p, &ctx));
+  return bignum_monty_modsqrt(r, a, p, &ctx);
+}
@@ -0,0 +1,121 @@
+#include <assert.h>
+#include <string.h>
+
+#include "bignum.h"
+#include "handy.h"
+
+#define INIT_TMP(s, name) \
+  (s)->name = (bignum) { (s)->name ## _words, (s)->name ## _words, BIGNUM_MAX_WORDS, 0, 0, NULL }
+
+error bignum_modstream_init(bignum_modstream *s, const bignum *m,
+                            bignum_endian order)
+{
+  assert(!bignum_check(m));
+
+  if (bignum_is_negative(m) || bignum_is_zero(m))
+    return error_invalid_bignum;
+
+  /* A block and the residue must fit together. */
+  size_t words = bignum_len_words(m);
+  if (words > BIGNUM_MAX_WORDS / 2)
+    return error_bignum_sz;
+
+  s->m = m;
+  s->order = order;
+  s->block_bytes = words * BIGNUM_BYTES;
+  s->pending_bytes = 0;
+
+  INIT_TMP(s, acc);
+  INIT_TMP(s, power);
+  INIT_TMP(s, step);
+
+  bignum_setu(&s->acc, 0);
+
+  /* Little endian needs the weight of the next block (initially 1),
+   * and the factor between successive blocks: 2^(32k) mod m. */
+  ER(bignum_mod(&s->power, &bignum_1, m));
+  bignum_setu(&s->step, 1);
+  ER(bignum_shl(&s->step, BYTES_TO_BITS(s->block_bytes)));
+  BIGNUM_SCRATCH(tmp, BIGNUM_MAX_WORDS);
+  ER(bignum_mod(&tmp, &s->step, m));
+  return bignum_dup(&s->step, &tmp);
+}
+
+/* Sets r to the residue of the stream so far followed by the
+ * len bytes at block. */
+static error absorb(const bignum_modstream *s, bignum *r,
+                    const uint8_t *block, size_t len)
+{
+  BIGNUM_SCRATCH(t, BIGNUM_MAX_WORDS);
+  BIGNUM_SCRATCH(b, BIGNUM_MAX_WORDS);
+
+  ER(bignum_from_bytes(&b, block, len, s->order));
+
+  if (s->order == bignum_big_endian)
+  {
+    /* acc * 2^(8 len) + b: b fills the space left by the shift. */
+    ER(bignum_dup(&t, &s->acc));
+    ER(bignum_shl(&t, BYTES_TO_BITS(len)));
+    ER(bignum_addl(&t, &b));
+  } else {
+    /* acc + b * power */
+    ER(bignum_mul(&t, &b, &s->power));
+    ER(bignum_addl(&t, &s->acc));
+  }
+
+  return bignum_mod(r, &t, s->m);
+}
+
+/* Takes a whole block. */
+static error step(bignum_modstream *s, const uint8_t *block)
+{
+  BIGNUM_SCRATCH(tmp, BIGNUM_MAX_WORDS);
+
+  ER(absorb(s, &tmp, block, s->block_bytes));
+  ER(bignum_dup(&s->acc, &tmp));
+
+  if (s->order == bignum_little_endian)
+  {
+    ER(bignum_modmul(&tmp, &s->power, &s->step, s->m));
+    ER(bignum_dup(&s->power, &tmp));
+  }
+
+  return OK;
+}
+
+error bignum_modstream_feed(bignum_modstream *s, const uint8_t *buf, size_t len)
+{
+  /* Top up any partial block first. */
+  if (s->pending_bytes)
+  {
+    size_t take = MIN(len, s->block_bytes - s->pending_bytes);
+    memcpy(s->pending + s->pending_bytes, buf, take);
+    s->pending_bytes += take;
+    buf += take;
+    len -= take;
+
+    if (s->pending_bytes < s->block_bytes)
+      return OK;
+
+    ER(step(s, s->pending));
+    s->pending_bytes = 0;
+  }
+
+  /* Then whole blocks straight from buf. */
+  for (; len >= s->block_bytes; buf += s->block_bytes, len -= s->block_bytes)
+    ER(step(s, buf));
+
+  memcpy(s->pending, buf, len);
+  s->pending_bytes = len;
+  return OK;
+}
+
+error bignum_modstream_finish(bignum_modstream *s, bignum *r)
+{
+  assert(!bignum_check_mutable(r));
+
+  if (s->pending_bytes)
+    return absorb(s, r, s->pending, s->pending_bytes);
+  else
+    return bignum_dup(r, &s->acc);
+}
@@ -8,9 +8,11 @@
 #include "bignum-dbg.h"
 #include "handy.h"
 
+/* nb. words above vtop may be stale (eg. after bignum_dup
+ * of a shorter value), so they must not be read. */
 static uint32_t word(const bignum *x, size_t i)
 {
-  if (i >= x->words)
+  if (i >= bignum_len_words(x))
     return 0;
   else
     return x->v[i];
@@ -54,7 +56,7 @@ unsigned bignum_monty_setup(const bignum *m, monty_ctx *mont)
   
 error monty_normalise_n(bignum *xR, const bignum *x, const bignum *m, size_t R_shift)
 {
-  BIGNUM_TMP(tmp);
+  BIGNUM_SCRATCH(tmp, bignum_len_words(x) + R_shift / BIGNUM_BITS + 1);
   ER(bignum_dup(&tmp, x));
   ER(bignum_shl(&tmp, R_shift));
   ER(bignum_mod(xR, &tmp, m));
@@ -75,8 +77,10 @@ error bignum_monty_normalise(bignum *xR, const bignum *x, const bignum *m, const
 static error bignum_monty_modmul_normalised_reduce(bignum *A, const bignum *x, const bignum *y, const bignum *m,
                                      const monty_ctx *monty)
 {
-  BIGNUM_TMP(rx);
-  BIGNUM_TMP(ry);
+  /* nb. bignum_mod works in its result, so these need to be
+   * as big as x and y. */
+  BIGNUM_SCRATCH(rx, bignum_len_words(x) + 1);
+  BIGNUM_SCRATCH(ry, bignum_len_words(y) + 1);
   ER(bignum_mod(&rx, x, m));
   ER(bignum_mod(&ry, y, m));
   return bignum_monty_modmul_normalised(A, &rx, &ry, m, monty);
@@ -95,8 +99,8 @@ error bignum_monty_modmul_normalised(bignum *A, const bignum *x, const bignum *y
   bignum_dump("  m", m);
 
 
-  if (!(bignum_gte(x, &bignum_0) && bignum_lt(x, m)) ||
-      !(bignum_gte(y, &bignum_0) && bignum_lt(y, m)))
+  if (bignum_is_negative(x) || bignum_cmp(x, m) >= 0 ||
+      bignum_is_negative(y) || bignum_cmp(y, m) >= 0)
     return bignum_monty_modmul_normalised_reduce(A, x, y, m, monty);
 
   assert(A != x && A != y);
@@ -106,7 +110,7 @@ error bignum_monty_modmul_normalised(bignum *A, const bignum *x, const bignum *y
   /* 1. A <- 0. */
   bignum_setu(A, 0);
 
-  BIGNUM_TMP(tmp);
+  BIGNUM_SCRATCH(tmp, n + 1);
 
   /* 2. For i from 0 to (n - 1): */
   for (size_t i = 0; i < n; i++)
@@ -129,7 +133,7 @@ error bignum_monty_modmul_normalised(bignum *A, const bignum *x, const bignum *y
   }
 
   /* 3. If A >= m then A <- A - m. */
-  if (bignum_gte(A, m))
+  if (bignum_mag_cmp(A, m) >= 0)
     ER(bignum_subl(A, m));
 
   bignum_dump("  result-m", A);
@@ -141,7 +145,8 @@ static error bignum_monty_reduce(bignum *A, const bignum *T, const bignum *m,
 {
   size_t n = bignum_len_words(m);
 
-  BIGNUM_TMP(tmp);
+  /* u_i m b^i, for i < n. */
+  BIGNUM_SCRATCH(tmp, 2 * n + 1);
 
   /* 1. A <- T */
   ER(bignum_dup(A, T));
@@ -163,7 +168,7 @@ static error bignum_monty_reduce(bignum *A, const bignum *T, const bignum *m,
   ER(bignum_shr(A, monty->R_shift));
   
   /* 4. If A >= m then A <- A - m. */
-  if (bignum_gte(A, m))
+  if (bignum_mag_cmp(A, m) >= 0)
     ER(bignum_subl(A, m));
 
   return OK;
@@ -173,10 +178,10 @@ static error bignum_monty_modmul_noalias(bignum *A, const bignum *x, const bignu
                                          const monty_ctx *monty)
 {
   /* Make x < y. */
-  if (!bignum_lt(x, y))
+  if (bignum_cmp(x, y) >= 0)
     SWAP(x, y);
 
-  BIGNUM_TMP(xR);
+  BIGNUM_SCRATCH(xR, bignum_len_words(x) + bignum_len_words(m) + 2);
   ER(bignum_monty_normalise(&xR, x, m, monty));
   return bignum_monty_modmul_normalised(A, &xR, y, m, monty);
 }
@@ -184,7 +189,7 @@ static error bignum_monty_modmul_noalias(bignum *A, const bignum *x, const bignu
 static error bignum_monty_modmul_alias(bignum *r, const bignum *a, const bignum *b, const bignum *p,
                                        const monty_ctx *monty)
 {
-  BIGNUM_TMP(rt);
+  BIGNUM_SCRATCH(rt, bignum_len_words(p) + 2);
   ER(bignum_monty_modmul_noalias(&rt, a, b, p, monty));
   ER(bignum_dup(r, &rt));
   return OK;
@@ -199,10 +204,28 @@ error bignum_monty_modmul(bignum *A, const bignum *x, const bignum *y, const big
     return bignum_monty_modmul_noalias(A, x, y, m, monty);
 }
 
+error bignum_monty_modmul_rr(bignum *A, const bignum *x, const bignum *y, const bignum *m,
+                             const bignum *RR, const monty_ctx *monty)
+{
+  BIGNUM_SCRATCH(t, bignum_len_words(m) + 2);
+
+  /* xyR^-1, then xyR^-1 * R^2 * R^-1 = xy. */
+  ER(bignum_monty_modmul_normalised(&t, x, y, m, monty));
+
+  if (A == m || A == RR)
+  {
+    BIGNUM_SCRATCH(u, bignum_len_words(m) + 2);
+    ER(bignum_monty_modmul_normalised(&u, &t, RR, m, monty));
+    return bignum_dup(A, &u);
+  }
+
+  return bignum_monty_modmul_normalised(A, &t, RR, m, monty);
+}
+
 error bignum_monty_sqr_normalised(bignum *A, const bignum *x, const bignum *m,
                                   const monty_ctx *monty)
 {
-  BIGNUM_TMP(r);
+  BIGNUM_SCRATCH(r, bignum_len_words(m) + 2);
   ER(bignum_monty_modmul_normalised(&r, x, x, m, monty));
   return bignum_dup(A, &r);
   (void) bignum_monty_reduce;
@@ -3,6 +3,10 @@
 
 #include "bignum.h"
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 /** Montgomery reduction context. */
 typedef struct
 {
@@ -21,7 +25,7 @@ unsigned bignum_monty_setup(const bignum *m, monty_ctx *mont);
 error bignum_monty_normalise(bignum *xR, const bignum *x, const bignum *m,
                              const monty_ctx *monty);
 
-/** Multiplies x by 2R mod m. */
+/** Multiplies x by R^2 mod m. */
 error bignum_monty_normalise2(bignum *xRR, const bignum *x, const bignum *m,
                               const monty_ctx *monty);
                              
@@ -37,9 +41,64 @@ error bignum_monty_modmul(bignum *A, const bignum *x, const bignum *y, const big
 error bignum_monty_modmul_normalised(bignum *A, const bignum *x, const bignum *y, const bignum *m,
                                      const monty_ctx *monty);
 
+/** Sets A = xy mod m, given RR = R^2 mod m (which is
+ *  bignum_monty_normalise2 of 1).
+ *
+ *  This is two Montgomery multiplications, where
+ *  bignum_monty_modmul has to divide to get x into the
+ *  Montgomery domain.  Use it for many products by the same m.
+ *
+ *  Arguments may alias in any combination. */
+error bignum_monty_modmul_rr(bignum *A, const bignum *x, const bignum *y, const bignum *m,
+                             const bignum *RR, const monty_ctx *monty);
+
 /** Sets A = x^2R^-1 mod m.
  */
 error bignum_monty_sqr_normalised(bignum *A, const bignum *x, const bignum *m,
                                   const monty_ctx *monty);
 
+/** Sets A = x^e mod m. */
+error bignum_monty_modexp(bignum *A, const bignum *x, const bignum *e, const bignum *m,
+                          const monty_ctx *monty);
+
+/** Sets A = x^e R mod m, where xR = xR mod m.
+ *
+ *  In other words, both input and output are in the Montgomery
+ *  domain.  A must not alias xR. */
+error bignum_monty_modexp_normalised(bignum *A, const bignum *xR, const bignum *e, const bignum *m,
+                                     const monty_ctx *monty);
+
+/** Modular square root context for an odd prime p. */
+typedef struct
+{
+  monty_ctx monty;
+
+  /* p - 1 = Q * 2 ^ S, with Q odd. */
+  size_t S;
+
+  /* Smallest quadratic non-residue mod p.  Only
+   * found (and used) when p = 1 mod 8. */
+  uint32_t z;
+} modsqrt_ctx;
+
+/** Prepares *ctx for taking square roots modulo the odd prime p.
+ *
+ *  Returns error_invalid_bignum if p is even or less than three, or
+ *  if p is found not to be prime while looking for a quadratic
+ *  non-residue. */
+error bignum_modsqrt_setup(const bignum *p, modsqrt_ctx *ctx);
+
+/** Sets r such that r^2 = a mod p, using a context from
+ *  bignum_modsqrt_setup.  The other root is p - r.
+ *
+ *  Returns error_no_sqrt if a is not a square mod p.
+ *
+ *  Arguments may alias in any combination. */
+error bignum_monty_modsqrt(bignum *r, const bignum *a, const bignum *p,
+                           const modsqrt_ctx *ctx);
+
+#ifdef __cplusplus
+}
+#endif
+
 #endif
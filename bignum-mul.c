@@ -33,6 +33,7 @@ error bignum_mul(bignum *r, const bignum *a, const bignum *b)
   if (bignum_eq32(b, 1))
     return bignum_dup(r, a);
 
+  ER(bignum_grow(r, (sza + szb + BIGNUM_BITS - 1) / BIGNUM_BITS));
   if (bignum_capacity_bits(r) < sza + szb)
     return error_bignum_sz;
 
@@ -79,9 +80,10 @@ error bignum_mulw(bignum *r, const bignum *a, uint32_t b)
   assert(!bignum_check(a));
   assert(r != a);
 
-  uint8_t sza = bignum_len_bits(a);
-  uint8_t szb = bignum_math_uint32_fls(b);
+  size_t sza = bignum_len_bits(a);
+  size_t szb = bignum_math_uint32_fls(b);
 
+  ER(bignum_grow(r, (sza + szb + BIGNUM_BITS - 1) / BIGNUM_BITS));
   if (bignum_capacity_bits(r) < sza + szb)
     return error_bignum_sz;
 
@@ -119,3 +121,108 @@ error bignum_multw(bignum *tmp, bignum *r, const bignum *a, uint32_t w)
 
   return bignum_mulw(r, a, w);
 }
+
+error bignum_muladdw(bignum *r, uint32_t w, uint32_t add)
+{
+  assert(!bignum_check_mutable(r));
+
+  uint64_t carry = add;
+
+  for (uint32_t *v = r->v; v <= r->vtop; v++)
+  {
+    uint64_t t = (uint64_t) *v * w + carry;
+    *v = (uint32_t) t;
+    carry = t >> 32;
+  }
+
+  if (carry)
+  {
+    ER(bignum_reserve(r, bignum_len_words(r) + 1));
+    *++r->vtop = (uint32_t) carry;
+  }
+
+  bignum_canon(r);
+  return OK;
+}
+
+/* Subtracts v from the n words at r, borrowing up.  Returns 1 if
+ * the borrow runs off the top. */
+static unsigned sub_word(uint32_t *r, size_t n, uint32_t v)
+{
+  for (size_t i = 0; i < n && v; i++)
+  {
+    uint32_t old = r[i];
+    r[i] -= v;
+    v = r[i] > old;
+  }
+  return v;
+}
+
+/* Negates the n word two's complement number at r. */
+static void negate_words(uint32_t *r, size_t n)
+{
+  uint32_t carry = 1;
+  for (size_t i = 0; i < n; i++)
+  {
+    r[i] = ~r[i] + carry;
+    carry = carry && r[i] == 0;
+  }
+}
+
+/* r = r + sign * a * b, in place. */
+static error mul_accumulate(bignum *r, const bignum *a, const bignum *b, int sign)
+{
+  assert(!bignum_check_mutable(r));
+  assert(!bignum_check(a));
+  assert(!bignum_check(b));
+  assert(r != a && r != b);
+
+  if (bignum_is_zero(a) || bignum_is_zero(b))
+    return OK;
+
+  int psign = bignum_getsign(a) * bignum_getsign(b) * sign;
+  size_t na = bignum_len_words(a), nb = bignum_len_words(b);
+
+  /* One spare word means carries and borrows stop inside r. */
+  size_t words = MAX(bignum_len_words(r), na + nb) + 1;
+  ER(bignum_grow(r, words));
+  ER(bignum_cleartop(r, words));
+
+  if (bignum_is_zero(r))
+    bignum_setsign(r, psign);
+
+  if (bignum_getsign(r) == psign)
+  {
+    for (size_t i = 0; i < na; i++)
+      bignum_math_mul_accum(r->v + i, b->v, nb, a->v[i]);
+  } else {
+    /* Subtract magnitudes.  The running value crosses zero at
+     * most once, so a borrow off the top means the result is
+     * negative, in two's complement. */
+    unsigned wrapped = 0;
+    for (size_t i = 0; i < na; i++)
+    {
+      uint32_t borrow = bignum_math_mul_sub(r->v + i, b->v, nb, a->v[i]);
+      wrapped |= sub_word(r->v + i + nb, words - i - nb, borrow);
+    }
+
+    if (wrapped)
+    {
+      negate_words(r->v, words);
+      bignum_setsign(r, psign);
+    }
+  }
+
+  bignum_canon(r);
+  return OK;
+}
+
+error bignum_muladd(bignum *r, const bignum *a, const bignum *b)
+{
+  return mul_accumulate(r, a, b, 1);
+}
+
+error bignum_mulsub(bignum *r, const bignum *a, const bignum *b)
+{
+  return mul_accumulate(r, a, b, -1);
+}
@@ -0,0 +1,220 @@
+#include <assert.h>
+#include <pthread.h>
+#include <stdlib.h>
+
+#include "bignum.h"
+#include "handy.h"
+
+/* Buffers come in power-of-two size classes, from 2^MIN_SHIFT bytes
+ * up.  Bigger requests go straight to malloc. */
+#define MIN_SHIFT 6
+#define CLASSES 12
+
+/* Free buffers move between threads and the shared lists in batches
+ * of this many.  A thread keeps at most twice this many per class. */
+#define BATCH 32
+
+/* A free buffer.  Buffers in a thread cache are linked by next;
+ * the shared lists are stacks of batches, each a chain of count
+ * buffers from its head, linked by next_batch. */
+typedef struct free_buf
+{
+  struct free_buf *next;
+  struct free_buf *next_batch;
+  size_t count;
+} free_buf;
+
+typedef struct
+{
+  free_buf *head;
+  size_t count;
+} cache;
+
+static free_buf *shared[CLASSES];
+
+static __thread cache thread_cache[CLASSES];
+static __thread int thread_registered;
+
+static pthread_once_t key_once = PTHREAD_ONCE_INIT;
+static pthread_key_t key;
+
+/* Returns the size class for bytes, or CLASSES if it's too big. */
+static unsigned size_class(size_t bytes)
+{
+  unsigned c = 0;
+  while (c < CLASSES && ((size_t) 1 << (c + MIN_SHIFT)) < bytes)
+    c++;
+  return c;
+}
+
+static size_t class_bytes(unsigned c)
+{
+  return (size_t) 1 << (c + MIN_SHIFT);
+}
+
+/* Pushes the chain of batches from first to last onto a shared list.
+ * Pushing is safe against ABA, since nothing is read through the old
+ * head. */
+static void shared_push(unsigned c, free_buf *first, free_buf *last)
+{
+  free_buf *head = __atomic_load_n(&shared[c], __ATOMIC_RELAXED);
+  do
+    last->next_batch = head;
+  while (!__atomic_compare_exchange_n(&shared[c], &head, first, 1,
+                                      __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+}
+
+/* Takes one batch from a shared list, or returns NULL.
+ *
+ * Popping a single batch with compare-and-swap suffers from ABA, so
+ * we take the whole list instead, and push back what we don't use. */
+static free_buf *shared_pop(unsigned c)
+{
+  if (!__atomic_load_n(&shared[c], __ATOMIC_RELAXED))
+    return NULL;
+
+  free_buf *batch = __atomic_exchange_n(&shared[c], NULL, __ATOMIC_ACQUIRE);
+  if (!batch)
+    return NULL;
+
+  free_buf *rest = batch->next_batch;
+  if (rest)
+  {
+    free_buf *last = rest;
+    while (last->next_batch)
+      last = last->next_batch;
+    shared_push(c, rest, last);
+  }
+
+  return batch;
+}
+
+/* Moves count buffers from the thread's cache for class c to the
+ * shared list, as one batch. */
+static void flush(unsigned c, size_t count)
+{
+  cache *k = &thread_cache[c];
+  assert(count && count <= k->count);
+
+  free_buf *first = k->head, *last = first;
+  for (size_t i = 1; i < count; i++)
+    last = last->next;
+
+  k->head = last->next;
+  k->count -= count;
+
+  last->next = NULL;
+  first->count = count;
+  shared_push(c, first, first);
+}
+
+/* Returns a thread's cache at exit. */
+static void thread_exit(void *arg)
+{
+  for (unsigned c = 0; c < CLASSES; c++)
+  {
+    if (thread_cache[c].count)
+      flush(c, thread_cache[c].count);
+  }
+}
+
+static void make_key(void)
+{
+  pthread_key_create(&key, thread_exit);
+}
+
+static void register_thread(void)
+{
+  pthread_once(&key_once, make_key);
+
+  /* The destructor only runs for non-NULL values. */
+  pthread_setspecific(key, &thread_registered);
+  thread_registered = 1;
+}
+
+static void *pool_alloc(void *ctx, size_t bytes)
+{
+  unsigned c = size_class(bytes);
+  if (c == CLASSES)
+    return malloc(bytes);
+
+  cache *k = &thread_cache[c];
+
+  if (!k->head)
+  {
+    free_buf *batch = shared_pop(c);
+    if (!batch)
+      return malloc(class_bytes(c));
+
+    k->head = batch;
+    k->count = batch->count;
+  }
+
+  free_buf *b = k->head;
+  k->head = b->next;
+  k->count--;
+  return b;
+}
+
+static void pool_free(void *ctx, void *ptr, size_t bytes)
+{
+  const unsigned *clean = ctx;
+  unsigned c = size_class(bytes);
+
+  if (c == CLASSES)
+  {
+    if (*clean)
+      mem_clean(ptr, bytes);
+    free(ptr);
+    return;
+  }
+
+  if (*clean)
+    mem_clean(ptr, class_bytes(c));
+
+  if (!thread_registered)
+    register_thread();
+
+  cache *k = &thread_cache[c];
+  free_buf *b = ptr;
+  b->next = k->head;
+  k->head = b;
+  k->count++;
+
+  if (k->count >= 2 * BATCH)
+    flush(c, BATCH);
+}
+
+static const unsigned no = 0, yes = 1;
+
+const bignum_allocator bignum_pool_allocator = { pool_alloc, pool_free, (void *) &no };
+const bignum_allocator bignum_pool_allocator_clean = { pool_alloc, pool_free, (void *) &yes };
+
+/* Frees a chain of buffers linked by next. */
+static void free_chain(free_buf *b)
+{
+  while (b)
+  {
+    free_buf *next = b->next;
+    free(b);
+    b = next;
+  }
+}
+
+void bignum_pool_trim(void)
+{
+  for (unsigned c = 0; c < CLASSES; c++)
+  {
+    free_chain(thread_cache[c].head);
+    thread_cache[c].head = NULL;
+    thread_cache[c].count = 0;
+
+    free_buf *batch = __atomic_exchange_n(&shared[c], NULL, __ATOMIC_ACQUIRE);
+    while (batch)
+    {
+      free_buf *next = batch->next_batch;
+      free_chain(batch);
+      batch = next;
+    }
+  }
+}
@@ -0,0 +1,342 @@
+#include <assert.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "bignum.h"
+#include "bignum-reduce.h"
+#include "bignum-dbg.h"
+#include "handy.h"
+
+/* --- Solinas reduction --- */
+
+/* NIST primes, least significant word first. */
+static uint32_t p256_words[8] = {
+  0xffffffff, 0xffffffff, 0xffffffff, 0x00000000,
+  0x00000000, 0x00000000, 0x00000001, 0xffffffff
+};
+
+static uint32_t p384_words[12] = {
+  0xffffffff, 0x00000000, 0x00000000, 0xffffffff,
+  0xfffffffe, 0xffffffff, 0xffffffff, 0xffffffff,
+  0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff
+};
+
+static const bignum p256 = { p256_words, p256_words + 7, 8, BIGNUM_F_IMMUTABLE, 0, NULL };
+static const bignum p384 = { p384_words, p384_words + 11, 12, BIGNUM_F_IMMUTABLE, 0, NULL };
+
+#define SOLINAS_MAX_WORDS 12
+
+/* One term of a Solinas reduction: for each word of the result, the
+ * index of the input word which goes there (or -1 for none),
+ * multiplied by coef. */
+typedef struct
+{
+  int8_t coef;
+  int8_t src[SOLINAS_MAX_WORDS];
+} solinas_term;
+
+/* These are from FIPS 186-4 D.2, written least significant word
+ * first.  The input words c0..c(n-1) are added as-is. */
+static const solinas_term p256_terms[] = {
+  { 2, { -1, -1, -1, 11, 12, 13, 14, 15 } },
+  { 2, { -1, -1, -1, 12, 13, 14, 15, -1 } },
+  { 1, { 8, 9, 10, -1, -1, -1, 14, 15 } },
+  { 1, { 9, 10, 11, 13, 14, 15, 13, 8 } },
+  { -1, { 11, 12, 13, -1, -1, -1, 8, 10 } },
+  { -1, { 12, 13, 14, 15, -1, -1, 9, 11 } },
+  { -1, { 13, 14, 15, 8, 9, 10, -1, 12 } },
+  { -1, { 14, 15, -1, 9, 10, 11, -1, 13 } },
+};
+
+static const solinas_term p384_terms[] = {
+  { 2, { -1, -1, -1, -1, 21, 22, 23, -1, -1, -1, -1, -1 } },
+  { 1, { 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23 } },
+  { 1, { 21, 22, 23, 12, 13, 14, 15, 16, 17, 18, 19, 20 } },
+  { 1, { -1, 23, -1, 20, 12, 13, 14, 15, 16, 17, 18, 19 } },
+  { 1, { -1, -1, -1, -1, 20, 21, 22, 23, -1, -1, -1, -1 } },
+  { 1, { 20, -1, -1, 21, 22, 23, -1, -1, -1, -1, -1, -1 } },
+  { -1, { 23, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22 } },
+  { -1, { -1, 20, 21, 22, 23, -1, -1, -1, -1, -1, -1, -1 } },
+  { -1, { -1, -1, -1, 23, 23, -1, -1, -1, -1, -1, -1, -1 } },
+};
+
+typedef struct
+{
+  const bignum *p;
+  size_t words;
+  const solinas_term *terms;
+  size_t nterms;
+} solinas_prime;
+
+static const solinas_prime solinas_p256 = { &p256, 8, p256_terms, ARRAYCOUNT(p256_terms) };
+static const solinas_prime solinas_p384 = { &p384, 12, p384_terms, ARRAYCOUNT(p384_terms) };
+
+/* w += p, returning the carry out. */
+static uint32_t add_words(uint32_t *w, const uint32_t *p, size_t n)
+{
+  uint64_t carry = 0;
+  for (size_t i = 0; i < n; i++)
+  {
+    carry += (uint64_t) w[i] + p[i];
+    w[i] = (uint32_t) carry;
+    carry >>= 32;
+  }
+  return (uint32_t) carry;
+}
+
+/* w -= p, returning the borrow out. */
+static uint32_t sub_words(uint32_t *w, const uint32_t *p, size_t n)
+{
+  uint32_t borrow = 0;
+  for (size_t i = 0; i < n; i++)
+  {
+    uint64_t d = (uint64_t) w[i] - p[i] - borrow;
+    w[i] = (uint32_t) d;
+    borrow = (d >> 32) & 1;
+  }
+  return borrow;
+}
+
+static unsigned lt_words(const uint32_t *w, const uint32_t *p, size_t n)
+{
+  for (size_t i = n; i != 0; i--)
+  {
+    if (w[i - 1] != p[i - 1])
+      return w[i - 1] < p[i - 1];
+  }
+  return 0;
+}
+
+/* r = x mod s->p, where 0 <= x < 2^(64n). */
+static error solinas_reduce(bignum *r, const bignum *x, const solinas_prime *s)
+{
+  size_t n = s->words;
+  uint32_t c[2 * SOLINAS_MAX_WORDS] = { 0 };
+  memcpy(c, x->v, bignum_len_words(x) * sizeof c[0]);
+
+  /* Each word of the sum is at most ten terms of a word times
+   * two, so fits easily. */
+  int64_t acc[SOLINAS_MAX_WORDS];
+  for (size_t i = 0; i < n; i++)
+    acc[i] = c[i];
+
+  for (size_t t = 0; t < s->nterms; t++)
+  {
+    const solinas_term *term = &s->terms[t];
+    for (size_t i = 0; i < n; i++)
+    {
+      if (term->src[i] >= 0)
+        acc[i] += term->coef * (int64_t) c[term->src[i]];
+    }
+  }
+
+  /* Propagate carries.  What's left over is a small signed multiple
+   * of 2^(32n). */
+  uint32_t w[SOLINAS_MAX_WORDS];
+  int64_t carry = 0;
+  for (size_t i = 0; i < n; i++)
+  {
+    carry += acc[i];
+    w[i] = (uint32_t) carry;
+    carry >>= 32;
+  }
+
+  /* p is just under 2^(32n), so this takes a few steps at most. */
+  const uint32_t *p = s->p->v;
+  while (carry < 0)
+    carry += add_words(w, p, n);
+  while (carry > 0 || !lt_words(w, p, n))
+    carry -= sub_words(w, p, n);
+
+  ER(bignum_cleartop(r, n));
+  memcpy(r->v, w, n * sizeof w[0]);
+  bignum_canon(r);
+  return OK;
+}
+
+/* --- Pseudo-Mersenne reduction --- */
+
+/* Detects m = 2^k - c, with c one word.  Moduli smaller than two
+ * words don't gain anything. */
+static error pseudo_mersenne_setup(const bignum *m, reduce_ctx *ctx, unsigned *found)
+{
+  size_t k = bignum_len_bits(m);
+  *found = 0;
+  if (k < 64)
+    return OK;
+
+  BIGNUM_SCRATCH(c, bignum_len_words(m) + 1);
+  bignum_setu(&c, 1);
+  ER(bignum_shl(&c, k));
+  ER(bignum_subl(&c, m));
+
+  if (bignum_len_words(&c) == 1)
+  {
+    ctx->k = k;
+    ctx->c = c.v[0];
+    *found = 1;
+  }
+
+  return OK;
+}
+
+/* r = x mod m, where x >= 0 and m = 2^k - c.
+ *
+ * x = hi 2^k + lo = hi c + lo (mod m), which loses about k - 32 bits
+ * each time round. */
+static error pseudo_mersenne_reduce(bignum *r, const bignum *x, const bignum *m,
+                                    const reduce_ctx *ctx)
+{
+  size_t words = bignum_len_words(x) + 2;
+  BIGNUM_SCRATCH(acc, words);
+  BIGNUM_SCRATCH(hi, words);
+
+  ER(bignum_dup(&acc, x));
+  while (bignum_len_bits(&acc) > ctx->k)
+  {
+    ER(bignum_dup(&hi, &acc));
+    ER(bignum_shr(&hi, ctx->k));
+    ER(bignum_trunc(&acc, ctx->k));
+    if (ctx->c != 1)
+      ER(bignum_muladdw(&hi, ctx->c, 0));
+    ER(bignum_addl(&acc, &hi));
+  }
+
+  /* acc < 2^k = m + c, so at most one subtraction. */
+  if (bignum_gte(&acc, m))
+    ER(bignum_subl(&acc, m));
+
+  return bignum_dup(r, &acc);
+}
+
+/* --- Interface --- */
+
+error bignum_reduce_setup(const bignum *m, reduce_ctx *ctx)
+{
+  assert(!bignum_check(m));
+
+  if (bignum_is_zero(m) || bignum_is_negative(m))
+    return error_invalid_bignum;
+
+  memset(ctx, 0, sizeof *ctx);
+
+  unsigned pseudo_mersenne;
+  ER(pseudo_mersenne_setup(m, ctx, &pseudo_mersenne));
+
+  if (bignum_eq(m, &p256))
+    ctx->kind = REDUCE_P256;
+  else if (bignum_eq(m, &p384))
+    ctx->kind = REDUCE_P384;
+  else if (pseudo_mersenne)
+    ctx->kind = REDUCE_PSEUDO_MERSENNE;
+  else if (bignum_monty_setup(m, &ctx->monty))
+    ctx->kind = REDUCE_MONTY;
+  else
+    ctx->kind = REDUCE_GENERIC;
+
+  return OK;
+}
+
+unsigned bignum_reduce_is_special(const reduce_ctx *ctx)
+{
+  return ctx->kind == REDUCE_PSEUDO_MERSENNE ||
+         ctx->kind == REDUCE_P256 ||
+         ctx->kind == REDUCE_P384;
+}
+
+error bignum_reduce(bignum *r, const bignum *x, const bignum *m, const reduce_ctx *ctx)
+{
+  assert(!bignum_check_mutable(r));
+  assert(!bignum_check(x));
+  assert(!bignum_check(m));
+
+  /* Work on |x|, then fix the sign up at the end. */
+  bignum mag = *x;
+  mag.flags &= ~BIGNUM_F_NEG;
+
+  BIGNUM_SCRATCH(tmp, MAX(bignum_len_words(x), bignum_len_words(m)) + 2);
+
+  switch (ctx->kind)
+  {
+    case REDUCE_P256:
+    case REDUCE_P384:
+    {
+      const solinas_prime *s = ctx->kind == REDUCE_P256 ? &solinas_p256 : &solinas_p384;
+      if (bignum_len_words(&mag) <= 2 * s->words)
+      {
+        ER(solinas_reduce(&tmp, &mag, s));
+        break;
+      }
+      ER(bignum_mod(&tmp, &mag, m));
+      break;
+    }
+
+    case REDUCE_PSEUDO_MERSENNE:
+      ER(pseudo_mersenne_reduce(&tmp, &mag, m, ctx));
+      break;
+
+    default:
+      ER(bignum_mod(&tmp, &mag, m));
+      break;
+  }
+
+  if (bignum_is_negative(x) && !bignum_is_zero(&tmp))
+    ER(bignum_sub(&tmp, m, &tmp));
+
+  return bignum_dup(r, &tmp);
+}
+
+error bignum_reduce_modmul(bignum *r, const bignum *a, const bignum *b,
+                           const bignum *m, const reduce_ctx *ctx)
+{
+  assert(!bignum_check_mutable(r));
+  assert(!bignum_check(a));
+  assert(!bignum_check(b));
+  assert(!bignum_check(m));
+
+  if (ctx->kind == REDUCE_MONTY)
+    return bignum_monty_modmul(r, a, b, m, &ctx->monty);
+
+  BIGNUM_SCRATCH(tmp, bignum_len_words(a) + bignum_len_words(b));
+  ER(bignum_mul(&tmp, a, b));
+  return bignum_reduce(r, &tmp, m, ctx);
+}
+
+error bignum_reduce_modexp(bignum *r, const bignum *a, const bignum *e,
+                           const bignum *m, const reduce_ctx *ctx)
+{
+  assert(!bignum_check_mutable(r));
+  assert(!bignum_check(a));
+  assert(!bignum_check(e));
+  assert(!bignum_check(m));
+
+  if (bignum_is_negative(e))
+    return error_invalid_bignum;
+
+  if (!bignum_reduce_is_special(ctx))
+    return bignum_modexp(r, a, e, m);
+
+  size_t words = bignum_len_words(m);
+  BIGNUM_SCRATCH_SECRET(base, words + 1);
+  BIGNUM_SCRATCH_SECRET(acc, words + 1);
+  BIGNUM_SCRATCH_SECRET(tmp, 2 * words + 2);
+
+  ER(bignum_reduce(&base, a, m, ctx));
+  bignum_setu(&acc, 1);
+
+  /* Left to right binary exponentiation.  Reduction is cheap, so
+   * there's no need for the Montgomery domain. */
+  for (size_t i = bignum_len_bits(e); i != 0; i--)
+  {
+    ER(bignum_sqr(&tmp, &acc));
+    ER(bignum_reduce(&acc, &tmp, m, ctx));
+
+    if (bignum_get_bit(e, i - 1) == 1)
+    {
+      ER(bignum_mul(&tmp, &acc, &base));
+      ER(bignum_reduce(&acc, &tmp, m, ctx));
+    }
+  }
+
+  return bignum_dup(r, &acc);
+}
@@ -0,0 +1,87 @@
+#ifndef BIGNUM_REDUCE_H
+#define BIGNUM_REDUCE_H
+
+/*
+ * Bignum library reduction by special moduli.
+ *
+ * Moduli of the form 2^k - c, with c small, reduce by folding the
+ * bits above 2^k back in multiplied by c.  The NIST primes P-256 and
+ * P-384 (which are not of that form) have Solinas reductions: a few
+ * additions and subtractions of rearranged words.  Both are linear
+ * in the size of the modulus, rather than quadratic like Montgomery
+ * reduction or division.
+ *
+ * bignum_modmul and bignum_modexp use these automatically.  For
+ * repeated use of one modulus, set up a reduce_ctx once.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+#include "bignum.h"
+#include "bignum-monty.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** How a reduce_ctx reduces. */
+typedef enum
+{
+  /** By division. */
+  REDUCE_GENERIC,
+  /** Odd modulus: by Montgomery multiplication. */
+  REDUCE_MONTY,
+  /** m = 2^k - c. */
+  REDUCE_PSEUDO_MERSENNE,
+  /** m = 2^256 - 2^224 + 2^192 + 2^96 - 1. */
+  REDUCE_P256,
+  /** m = 2^384 - 2^128 - 2^96 + 2^32 - 1. */
+  REDUCE_P384
+} reduce_kind;
+
+/** Reduction context for a modulus. */
+typedef struct
+{
+  reduce_kind kind;
+
+  /* REDUCE_PSEUDO_MERSENNE: m = 2^k - c. */
+  size_t k;
+  uint32_t c;
+
+  /* REDUCE_MONTY. */
+  monty_ctx monty;
+} reduce_ctx;
+
+/** Works out the best way to reduce by m, which must be positive.
+ *
+ *  Returns error_invalid_bignum if m is not positive. */
+error bignum_reduce_setup(const bignum *m, reduce_ctx *ctx);
+
+/** Returns 1 if ctx reduces by a special form: pseudo-Mersenne or
+ *  Solinas. */
+unsigned bignum_reduce_is_special(const reduce_ctx *ctx);
+
+/** Sets r = x mod m, with 0 <= r < m.
+ *
+ *  Arguments may alias in any combination. */
+error bignum_reduce(bignum *r, const bignum *x, const bignum *m,
+                    const reduce_ctx *ctx);
+
+/** Sets r = ab mod m, with 0 <= r < m.
+ *
+ *  Arguments may alias in any combination. */
+error bignum_reduce_modmul(bignum *r, const bignum *a, const bignum *b,
+                           const bignum *m, const reduce_ctx *ctx);
+
+/** Sets r = a^e mod m, with 0 <= r < m.  e must not be negative,
+ *  otherwise error_invalid_bignum is returned.
+ *
+ *  Arguments may alias in any combination. */
+error bignum_reduce_modexp(bignum *r, const bignum *a, const bignum *e,
+                           const bignum *m, const reduce_ctx *ctx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,270 @@
+#include <assert.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "bignum.h"
+#include "bignum-math.h"
+#include "handy.h"
+
+/* Sets b to the value of v. */
+static error set_u64(bignum *b, uint64_t v)
+{
+  bignum_setu(b, 0);
+  ER(bignum_cleartop(b, 2));
+  b->v[0] = v & 0xffffffff;
+  b->v[1] = v >> 32;
+  bignum_canon(b);
+  return OK;
+}
+
+/* Returns the low 64 bits of b. */
+static uint64_t low_u64(const bignum *b)
+{
+  uint64_t r = b->v[0];
+  if (bignum_len_words(b) > 1)
+    r |= (uint64_t) b->v[1] << 32;
+  return r;
+}
+
+/* Returns 1 if x ^ n <= t. */
+static unsigned pow_u64_lte(uint64_t x, unsigned n, uint64_t t)
+{
+  uint64_t acc = 1;
+  while (n--)
+  {
+    if (__builtin_mul_overflow(acc, x, &acc) || acc > t)
+      return 0;
+  }
+  return 1;
+}
+
+/* Returns floor(t ^ (1/n)), bit by bit from the top. */
+static uint64_t iroot_u64(uint64_t t, unsigned n)
+{
+  if (n >= 64)
+    return t != 0;
+
+  uint64_t r = 0;
+  for (unsigned bit = 64 / n + 1; bit != 0; bit--)
+  {
+    uint64_t candidate = r | (uint64_t) 1 << (bit - 1);
+    if (pow_u64_lte(candidate, n, t))
+      r = candidate;
+  }
+
+  return r;
+}
+
+/* r = x ^ k, for x >= 1.  r must not alias x.
+ *
+ * If the result would be larger than bound, *over is set
+ * and r is left meaningless.  This keeps intermediates within
+ * twice the size of bound, whatever the size of k. */
+static error pow_bounded(bignum *r, unsigned *over, const bignum *x, unsigned k,
+                         const bignum *bound)
+{
+  BIGNUM_SCRATCH(tmp, bignum_len_words(bound) + 1);
+  size_t limit = bignum_len_bits(bound);
+
+  *over = 0;
+  bignum_setu(r, 1);
+
+  for (unsigned bit = bignum_math_uint32_fls(k); bit != 0; bit--)
+  {
+    /* A product of i and j bit numbers has at least i + j - 1 bits. */
+    if (2 * bignum_len_bits(r) - 1 > limit)
+    {
+      *over = 1;
+      return OK;
+    }
+
+    ER(bignum_sqr(r, r));
+
+    if ((k >> (bit - 1)) & 1)
+    {
+      if (bignum_len_bits(r) + bignum_len_bits(x) - 1 > limit)
+      {
+        *over = 1;
+        return OK;
+      }
+
+      ER(bignum_mul(&tmp, r, x));
+      ER(bignum_dup(r, &tmp));
+    }
+  }
+
+  *over = bignum_gt(r, bound);
+  return OK;
+}
+
+/* Sets x to an overestimate of floor(a ^ (1/n)), good to
+ * roughly 64/n bits.
+ *
+ * If a = t * 2^(nq) + s, with t < 2^64 and s < 2^(nq), then
+ * a ^ (1/n) < (t + 1) ^ (1/n) * 2^q <= (floor(t ^ (1/n)) + 1) * 2^q. */
+static error initial_estimate(bignum *x, const bignum *a, unsigned n)
+{
+  BIGNUM_SCRATCH(top, bignum_len_words(a));
+
+  size_t bits = bignum_len_bits(a);
+  size_t q = bits > 64 ? (bits - 64 + n - 1) / n : 0;
+
+  ER(bignum_dup(&top, a));
+  ER(bignum_shr(&top, q * n));
+
+  ER(set_u64(x, iroot_u64(low_u64(&top), n) + 1));
+  return bignum_shl(x, q);
+}
+
+error bignum_rootn(bignum *r, bignum *rem, const bignum *a, unsigned n)
+{
+  assert(!bignum_check_mutable(r));
+  assert(!bignum_check(a));
+  assert(r != a && rem != a);
+
+  if (n == 0 || bignum_is_negative(a))
+    return error_invalid_bignum;
+
+  /* 0 and 1 are their own roots. */
+  if (n == 1 || bignum_len_bits(a) == 1)
+  {
+    ER(bignum_dup(r, a));
+    if (rem)
+      bignum_setu(rem, 0);
+    return OK;
+  }
+
+  /* 2 <= a < 2^n has root 1. */
+  if (n >= bignum_len_bits(a))
+  {
+    bignum_setu(r, 1);
+    if (rem)
+      ER(bignum_sub(rem, a, &bignum_1));
+    return OK;
+  }
+
+  uint32_t nw = n;
+  bignum nbn = { &nw, &nw, 1, BIGNUM_F_IMMUTABLE, 0, NULL };
+
+  /* Everything here is bounded by a, or just over it. */
+  size_t words = bignum_len_words(a) + 2;
+  BIGNUM_SCRATCH(p, words);
+  BIGNUM_SCRATCH(y, words);
+  BIGNUM_SCRATCH(tmp, words);
+
+  /* This is Newton's method, which decreases monotonically to
+   * floor(a ^ (1/n)) from any starting point above it:
+   *
+   * 1. x <- an overestimate of the root
+   * 2. y <- ((n - 1) x + a / x^(n - 1)) / n
+   * 3. If y >= x, return x.
+   * 4. x <- y, goto 2.
+   */
+  ER(initial_estimate(r, a, n));
+
+  while (1)
+  {
+    unsigned over;
+    ER(pow_bounded(&p, &over, r, n - 1, a));
+
+    if (over)
+      bignum_setu(&tmp, 0);
+    else
+      ER(bignum_div(&tmp, a, &p));
+
+    ER(bignum_mulw(&y, r, n - 1));
+    ER(bignum_addl(&y, &tmp));
+
+    if (n == 2)
+    {
+      ER(bignum_shr(&y, 1));
+    } else {
+      ER(bignum_dup(&tmp, &y));
+      ER(bignum_div(&y, &tmp, &nbn));
+    }
+
+    if (!bignum_lt(&y, r))
+      break;
+
+    ER(bignum_dup(r, &y));
+  }
+
+  if (rem)
+  {
+    unsigned over;
+    ER(pow_bounded(&p, &over, r, n, a));
+    assert(!over);
+    ER(bignum_sub(rem, a, &p));
+  }
+
+  return OK;
+}
+
+error bignum_sqrt(bignum *r, bignum *rem, const bignum *a)
+{
+  return bignum_rootn(r, rem, a, 2);
+}
+
+static unsigned is_small_prime(size_t k)
+{
+  if (k < 2)
+    return 0;
+
+  for (size_t d = 2; d * d <= k; d++)
+  {
+    if (k % d == 0)
+      return 0;
+  }
+
+  return 1;
+}
+
+/* Bit i set iff i is a square mod 64. */
+#define SQUARES_MOD_64 0x0202021202030213ull
+
+error bignum_is_perfect_power(unsigned *result, const bignum *a)
+{
+  assert(!bignum_check(a));
+
+  BIGNUM_SCRATCH(mag, bignum_len_words(a));
+  BIGNUM_SCRATCH(root, bignum_len_words(a) + 2);
+  BIGNUM_SCRATCH(rem, bignum_len_words(a) + 2);
+
+  ER(bignum_dup(&mag, a));
+  bignum_abs(&mag);
+
+  *result = 0;
+
+  /* 0, 1 and -1 are all trivially powers. */
+  if (bignum_len_bits(&mag) == 1)
+  {
+    *result = 1;
+    return OK;
+  }
+
+  /* If a = b^k then k divides the number of trailing zeroes. */
+  size_t zeroes = 0;
+  while (bignum_get_bit(&mag, zeroes) == 0)
+    zeroes++;
+
+  /* b >= 2, so k < log2(a).  Only prime k need checking,
+   * since b^(jk) = (b^j)^k. */
+  size_t bits = bignum_len_bits(&mag);
+  for (size_t k = 2; k < bits; k++)
+  {
+    if (!is_small_prime(k) ||
+        (zeroes && zeroes % k) ||
+        (k == 2 && bignum_is_negative(a)) ||
+        (k == 2 && !((SQUARES_MOD_64 >> (mag.v[0] & 63)) & 1)))
+      continue;
+
+    ER(bignum_rootn(&root, &rem, &mag, k));
+    if (bignum_is_zero(&rem))
+    {
+      *result = 1;
+      return OK;
+    }
+  }
+
+  return OK;
+}
@@ -111,7 +111,7 @@ error bignum_trunc(bignum *r, size_t bits)
     return OK;
 
   size_t word = bits / BIGNUM_BITS;
-  uint32_t mask = (1 << (bits % BIGNUM_BITS)) - 1;
+  uint32_t mask = (UINT32_C(1) << (bits % BIGNUM_BITS)) - 1;
 
   for (uint32_t *top = r->v + word + 1;
        top <= r->vtop;
@@ -5,10 +5,11 @@
 
 #include "bignum.h"
 #include "bignum-math.h"
+#include "handy.h"
 
 static error bignum_sqr_tmp(bignum *r, const bignum *a)
 {
-  BIGNUM_TMP(tmp);
+  BIGNUM_SCRATCH(tmp, 2 * bignum_len_words(a));
   return bignum_mult(&tmp, r, a, a);
 }
 
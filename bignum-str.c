@@ -1,82 +1,345 @@
 
 #include "bignum.h"
 #include "bignum-str.h"
+#include "bignum-math.h"
+#include "bignum-hex.h"
+#include "bignum-digits.h"
 #include "sstr.h"
+#include "handy.h"
+
+/* Crossovers found by tunebignum, if make tune has been run. */
+#ifdef BIGNUM_TUNED
+# include "bignum-tune.h"
+#endif
 
 #include <assert.h>
+#include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
 
-static const char *hex_chars = "0123456789abcdef";
+static const char digit_chars[] = "0123456789abcdefghijklmnopqrstuvwxyz";
+
+/* Returns log2(base) for bases which are powers of two, else 0. */
+static unsigned base_bits(unsigned base)
+{
+  if (base & (base - 1))
+    return 0;
+  return bignum_math_uint32_ctz(base);
+}
+
+/* Writes the lowest digits digits of the magnitude of x, in a base
+ * of 2 ^ bits, right to left ending at end.  There must be room.
+ *
+ * This takes x a word at a time. */
+static void fmt_pow2(const bignum *x, unsigned bits, char *end, size_t digits)
+{
+  const uint32_t mask = (1u << bits) - 1;
+  const uint32_t *v = x->v;
+  size_t words = bignum_len_words(x);
+
+  uint64_t acc = 0;
+  unsigned have = 0;
+  size_t w = 0;
+
+  /* Hex converts whole words in bulk. */
+  if (bits == 4)
+  {
+    w = MIN(digits / 8, words);
+    end -= 8 * w;
+    digits -= 8 * w;
+    bignum_hex_encode_words(end, v, w);
+  }
+
+  for (; digits; w++)
+  {
+    acc |= (uint64_t) (w < words ? v[w] : 0) << have;
+    have += BIGNUM_BITS;
+
+    for (; have >= bits && digits; have -= bits, digits--)
+    {
+      *--end = digit_chars[acc & mask];
+      acc >>= bits;
+    }
+  }
+}
+
+/* Parses all of s as digits in a base of 2 ^ bits, a word
+ * at a time from the right. */
+static error parse_pow2(bignum *r, sstr *s, unsigned bits)
+{
+  /* Leading zeroes don't count towards the size. */
+  while (sstr_left(s) && *s->start == '0')
+    s->start++;
+
+  size_t words = (sstr_left(s) * bits + BIGNUM_BITS - 1) / BIGNUM_BITS;
+
+  bignum_setu(r, 0);
+  if (words > 1)
+    ER(bignum_cleartop(r, words));
+
+  uint32_t *out = r->v;
+  const char *end = s->end;
+  uint64_t acc = 0;
+  unsigned have = 0;
+
+  /* Hex converts whole words in bulk. */
+  if (bits == 4)
+  {
+    size_t whole = sstr_left(s) / 8;
+    end -= 8 * whole;
+    if (bignum_hex_decode_words(out, end, whole))
+      return error_invalid_string;
+    out += whole;
+  }
+
+  for (const char *p = end; p != s->start; )
+  {
+    unsigned digit = digit_value(*--p);
+    if (digit >> bits)
+      return error_invalid_string;
+
+    acc |= (uint64_t) digit << have;
+    have += bits;
+
+    if (have >= BIGNUM_BITS)
+    {
+      *out++ = (uint32_t) acc;
+      acc >>= BIGNUM_BITS;
+      have -= BIGNUM_BITS;
+    }
+  }
+
+  if (have)
+    *out = (uint32_t) acc;
+
+  s->start = s->end;
+  bignum_canon(r);
+  return OK;
+}
 
 error bignum_fmt_hex(const bignum *b, char *buf, size_t len)
 {
   assert(!bignum_check(b));
   assert(buf && len);
 
-  sstr out = { buf, buf + len };
-
-  size_t bytes = bignum_len_bytes(b);
+  size_t digits = bignum_len_bytes(b) * 2;
   size_t sign = bignum_is_negative(b);
 
-  if ((sign && sstr_putc(&out, '-')) ||
-      sstr_putc(&out, '0') ||
-      sstr_putc(&out, 'x'))
+  if (len < sign + 2 + digits + 1)
     return error_buffer_sz;
 
-  for (size_t i = bytes; i > 0; i--)
-  {
-    uint8_t byte = bignum_get_byte(b, i - 1);
+  if (sign)
+    *buf++ = '-';
+  *buf++ = '0';
+  *buf++ = 'x';
 
-    if (sstr_putc(&out, hex_chars[(byte >> 4) & 0xf]) ||
-        sstr_putc(&out, hex_chars[byte & 0xf]))
-      return error_buffer_sz;
+  fmt_pow2(b, 4, buf + digits, digits);
+  buf[digits] = 0;
+  return OK;
+}
+
+/* Other bases are converted in chunks of as many digits as fit
+ * in a word.  For decimal that's DEC_CHUNK_DIGITS digits. */
+typedef struct
+{
+  unsigned digits;
+  uint32_t chunk;
+} chunking;
+
+/* Returns the largest power of base which fits in a word. */
+static chunking base_chunking(unsigned base)
+{
+  chunking c = { 0, 1 };
+  while (c.chunk <= UINT32_MAX / base)
+  {
+    c.chunk *= base;
+    c.digits++;
   }
+  return c;
+}
 
-  if (sstr_put0(&out))
-    return error_buffer_sz;
+/* With the schoolbook multiply and divide, divide and conquer
+ * does no better than chunked conversion at any size, so it is off
+ * by default.  See bignum_dec_dc_threshold, and tunebignum, which
+ * measures it. */
+#ifndef BIGNUM_DEC_DC_THRESHOLD
+# define BIGNUM_DEC_DC_THRESHOLD SIZE_MAX
+#endif
+
+size_t bignum_dec_dc_threshold = BIGNUM_DEC_DC_THRESHOLD;
+
+/* Decimal digits for a value of bits bits, perhaps one more than
+ * needed.  That's bits * log10(2) rounded up, and log10(2) is a
+ * little under 1234 / 4096. */
+#define DEC_DIGITS(bits) ((bits) * 1234 / 4096 + 1)
+
+/* The powers of ten.  Each is the square of the one before, and
+ * they're made as they're first needed, so DEC_POWERS bounds the
+ * size of a value to be split rather than the storage used. */
+static bignum dec_powers[DEC_POWERS];
+static size_t dec_powers_made;
+static int dec_powers_lock;
+
+/* Makes powers up to k, with the lock held. */
+static error dec_powers_make(size_t k)
+{
+  for (size_t i = dec_powers_made; i <= k; i++)
+  {
+    bignum *p = &dec_powers[i];
+    ER(bignum_init_growable(p, i ? 2 * bignum_len_words(&dec_powers[i - 1]) : 1, NULL));
+
+    error err;
+    if (i == 0)
+    {
+      bignum_setu(p, DEC_CHUNK);
+      err = OK;
+    } else {
+      err = bignum_mul(p, &dec_powers[i - 1], &dec_powers[i - 1]);
+    }
+
+    if (err)
+    {
+      bignum_clear(p);
+      return err;
+    }
+
+    p->flags |= BIGNUM_F_IMMUTABLE;
+    __atomic_store_n(&dec_powers_made, i + 1, __ATOMIC_RELEASE);
+  }
 
   return OK;
 }
 
-error bignum_fmt_dec(const bignum *b, char *buf, size_t len)
+error bignum_dec_power(const bignum **p, size_t k)
 {
-  uint32_t ten = 10;
-  bignum tenbn = { &ten, &ten, 1, 0 };
+  assert(k < DEC_POWERS);
 
-  BIGNUM_TMP(unitbn);
+  if (__atomic_load_n(&dec_powers_made, __ATOMIC_ACQUIRE) <= k)
+  {
+    while (__atomic_exchange_n(&dec_powers_lock, 1, __ATOMIC_ACQUIRE))
+      ;
 
-  if (len < 2)
-    return error_buffer_sz;
+    error err = dec_powers_make(k);
+    __atomic_store_n(&dec_powers_lock, 0, __ATOMIC_RELEASE);
+    ER(err);
+  }
 
-  BIGNUM_TMP(tmp);
-  BIGNUM_TMP(tmp2);
-  bignum_dup(&tmp, b);
+  *p = &dec_powers[k];
+  return OK;
+}
 
-  /* Work from right to left */
-  char *out = buf + len;
-  *--out = 0;
+/* Writes the digits of the magnitude of x in base right to left,
+ * moving *out down (but not below buf).  Zero pads to at least
+ * min_digits.
+ *
+ * Here and below, owner is the value being converted, which
+ * scratch space may come from if it's growable. */
+static error fmt_chunked(const bignum *x, unsigned base, char **out, char *buf,
+                         size_t min_digits, const bignum *owner)
+{
+  BIGNUM_SCRATCH_FOR(tmp, bignum_len_words(x), owner);
+  error err = bignum_dup(&tmp, x);
+  if (err)
+    return err;
+  bignum_abs(&tmp);
+
+  chunking c = base_chunking(base);
+  size_t written = 0;
+
+  /* Repeatedly divide by c.chunk to obtain chunks of digits.
+   * Every chunk but the top one is zero-padded.
+   *
+   * nb. zero comes out as a single top chunk, of "0". */
+  do
+  {
+    uint32_t chunk;
+    bignum_divmodw(&tmp, &chunk, &tmp, c.chunk);
+    unsigned top = bignum_is_zero(&tmp);
+
+    for (size_t i = 0; i < c.digits; i++)
+    {
+      if (*out == buf)
+        return error_buffer_sz;
+      *--*out = digit_chars[chunk % base];
+      chunk /= base;
+      written++;
+
+      if (top && chunk == 0)
+        break;
+    }
+  } while (!bignum_is_zero(&tmp));
 
-  /* Output single 0 for zero. */
-  if (bignum_eq(&tmp, &bignum_0))
+  for (; written < min_digits; written++)
   {
-    if (out == buf)
+    if (*out == buf)
       return error_buffer_sz;
-    *--out = '0';
+    *--*out = '0';
   }
 
-  tmp.flags &= ~BIGNUM_F_NEG;
+  return OK;
+}
+
+/* As fmt_chunked in decimal, for 0 <= x < 10 ^ DEC_POWER_DIGITS(k + 1),
+ * with the powers up to k made. */
+static error fmt_dec_dc(const bignum *x, int k, char **out, char *buf, size_t min_digits,
+                        const bignum *owner)
+{
+  if (k < 0 || bignum_len_words(x) < bignum_dec_dc_threshold)
+    return fmt_chunked(x, 10, out, buf, min_digits, owner);
+
+  /* x = q * 10^d + r, where d = DEC_POWER_DIGITS(k).
+   * r needs exactly d digits, q the rest. */
+  size_t digits = DEC_POWER_DIGITS(k);
+  size_t high_min_digits = min_digits > digits ? min_digits - digits : 0;
+
+  const bignum *power;
+  ER(bignum_dec_power(&power, k));
+
+  /* Nothing to split: x needs fewer than d digits. */
+  if (bignum_lt(x, power))
+    return fmt_dec_dc(x, k - 1, out, buf, min_digits, owner);
+
+  BIGNUM_SCRATCH_FOR(q, bignum_len_words(x) + 1, owner);
+  BIGNUM_SCRATCH_FOR(r, bignum_len_words(x) + 2, owner);
+  ER(bignum_divmod(&q, &r, x, power));
+  ER(fmt_dec_dc(&r, k - 1, out, buf, digits, owner));
+  return fmt_dec_dc(&q, k - 1, out, buf, high_min_digits, owner);
+}
+
+error bignum_fmt_dec(const bignum *b, char *buf, size_t len)
+{
+  assert(!bignum_check(b));
+  assert(buf && len);
+
+  if (len < 2)
+    return error_buffer_sz;
 
-  /* Otherwise, repeatedly divide by 10 to obtain digits. */
-  while (bignum_gt(&tmp, &bignum_0))
+  /* Work from right to left */
+  char *out = buf + len;
+  *--out = 0;
+
+  if (bignum_len_words(b) < bignum_dec_dc_threshold)
   {
-    error err = bignum_divmod(&tmp2, &unitbn, &tmp, &tenbn);
-    assert(err == OK);
-    if (out == buf)
-      return error_buffer_sz;
-    assert(unitbn.v[0] < 10);
-    *--out = '0' + unitbn.v[0];
-    bignum_dup(&tmp, &tmp2);
+    ER(fmt_chunked(b, 10, &out, buf, 0, b));
+  } else {
+    BIGNUM_SCRATCH_FOR(mag, bignum_len_words(b), b);
+    ER(bignum_dup(&mag, b));
+    bignum_abs(&mag);
+
+    /* Start with the largest power b might reach, going by its
+     * length, so that b has fewer digits than the next.  Past the
+     * powers there are, or if they can't be made, convert it in
+     * chunks. */
+    size_t digits = DEC_DIGITS(bignum_len_bits(&mag));
+    int k = 0;
+    while (k + 1 < DEC_POWERS && DEC_POWER_DIGITS(k + 1) < digits)
+      k++;
+
+    const bignum *power;
+    if (k + 1 == DEC_POWERS || bignum_dec_power(&power, k))
+      ER(fmt_chunked(&mag, 10, &out, buf, 0, b));
+    else
+      ER(fmt_dec_dc(&mag, k, &out, buf, 0, b));
   }
 
   /* Finally, add negative sign if necessary. */
@@ -94,119 +357,212 @@ error bignum_fmt_dec(const bignum *b, char *buf, size_t len)
   return OK;
 }
 
-error bignum_parse_str(bignum *r, const char *buf)
+typedef error (*fmt_fn)(const bignum *b, char *buf, size_t len);
+
+/* Returns the buffer size which fmt needs for b, including the
+ * terminator. */
+static size_t fmt_len(const bignum *b, fmt_fn fmt)
 {
-  return bignum_parse_strl(r, buf, strlen(buf));
+  size_t sign = bignum_is_negative(b);
+
+  if (fmt == bignum_fmt_hex)
+    return sign + 2 + 2 * bignum_len_bytes(b) + 1;
+  else
+    return sign + DEC_DIGITS(bignum_len_bits(b)) + 1;
 }
 
-static unsigned parse_hexbyte(char x, uint8_t *out)
+/* Enough for anything fmt_len allows up to BIGNUM_MAX_WORDS.
+ * Growable bignums can be longer, and are formatted on the heap. */
+#define FMT_MAX_LEN (1 + DEC_DIGITS(BIGNUM_MAX_WORDS * BIGNUM_BITS) + 1)
+
+static error fmt_sink(const bignum *b, fmt_fn fmt, const bignum_sink *sink)
 {
-  if (x >= '0' && x <= '9')
+  char stack[FMT_MAX_LEN];
+  size_t len = fmt_len(b, fmt);
+  char *buf = stack;
+
+  if (len > sizeof stack)
   {
-    *out = x - '0';
-    return 0;
-  } else if (x >= 'A' && x <= 'F') {
-    *out = x - 'A' + 10;
-    return 0;
-  } else if (x >= 'a' && x <= 'f') {
-    *out = x - 'a' + 10;
-    return 0;
-  } else {
-    return 1;
+    buf = malloc(len);
+    if (!buf)
+      return error_buffer_sz;
   }
+
+  error err = fmt(b, buf, len);
+  if (!err && sink->write(sink->ctx, buf, strlen(buf)))
+    err = error_io;
+
+  if (buf != stack)
+    free(buf);
+  return err;
 }
 
-static unsigned take_hexbyte(sstr *s, uint8_t *b)
+static error fmt_dstr(const bignum *b, fmt_fn fmt, dstr *d)
 {
-  char h, l;
-  uint8_t rh, rl;
-  
-  if (sstr_takec(s, &h) ||
-      sstr_takec(s, &l) ||
-      parse_hexbyte(h, &rh) ||
-      parse_hexbyte(l, &rl))
-    return 1;
+  size_t len = fmt_len(b, fmt);
+  if (dstr_expand(d, len))
+    return error_buffer_sz;
 
-  *b = (rh << 4) | rl;
-  return 0;
+  ER(fmt(b, d->wr, len));
+  d->wr += strlen(d->wr);
+  return OK;
 }
 
-static error parse_hex(bignum *r, sstr *s)
+static unsigned write_file(void *ctx, const char *buf, size_t len)
 {
-  bignum_set(r, 0);
+  return fwrite(buf, 1, len, ctx) != len;
+}
 
-  size_t bytes = (sstr_left(s) + 1) / 2;
+error bignum_fmt_hex_sink(const bignum *b, const bignum_sink *sink)
+{
+  return fmt_sink(b, bignum_fmt_hex, sink);
+}
 
-  /* If we have an odd-length input, interpret
-   * the first character as the low nibble of the
-   * first byte. */
-  unsigned short_start = sstr_left(s) % 2 == 1;
+error bignum_fmt_dec_sink(const bignum *b, const bignum_sink *sink)
+{
+  return fmt_sink(b, bignum_fmt_dec, sink);
+}
 
-  for (size_t i = bytes; i > 0; i--)
-  {
-    uint8_t byte;
+error bignum_fmt_hex_dstr(const bignum *b, dstr *d)
+{
+  return fmt_dstr(b, bignum_fmt_hex, d);
+}
 
-    if (i == bytes && short_start)
-    {
-      /* Take a single nibble */
-      char l;
-      if (sstr_takec(s, &l) ||
-          parse_hexbyte(l, &byte))
-        return error_invalid_string;
-    } else {
-      /* Take a byte */
-      if (take_hexbyte(s, &byte))
-        return error_invalid_string;
-    }
+error bignum_fmt_dec_dstr(const bignum *b, dstr *d)
+{
+  return fmt_dstr(b, bignum_fmt_dec, d);
+}
 
-    error err = bignum_set_byte(r, byte, i - 1);
-    if (err)
-      return err;
-  }
+error bignum_fmt_hex_file(const bignum *b, FILE *f)
+{
+  bignum_sink sink = { write_file, f };
+  return fmt_sink(b, bignum_fmt_hex, &sink);
+}
 
-  return OK;
+error bignum_fmt_dec_file(const bignum *b, FILE *f)
+{
+  bignum_sink sink = { write_file, f };
+  return fmt_sink(b, bignum_fmt_dec, &sink);
+}
+
+error bignum_parse_str(bignum *r, const char *buf)
+{
+  return bignum_parse_strl(r, buf, strlen(buf));
 }
 
-error parse_dec(bignum *r, sstr *s)
+/* Parses exactly digits characters in base into *value, and
+ * sets *scale to base ^ digits. */
+static unsigned take_chunk(sstr *s, size_t digits, unsigned base,
+                           uint32_t *value, uint32_t *scale)
 {
-  uint32_t digit = 0;
-  bignum bignum_dig = { &digit, &digit, 1, BIGNUM_F_IMMUTABLE };
-  BIGNUM_TMP(bignum_tmp);
+  uint32_t v = 0, m = 1;
+  char c;
 
+  while (digits--)
+  {
+    unsigned digit;
+    if (sstr_takec(s, &c) || (digit = digit_value(c)) >= base)
+      return 1;
+    v = v * base + digit;
+    m *= base;
+  }
+
+  *value = v;
+  *scale = m;
+  return 0;
+}
+
+static error parse_chunked(bignum *r, sstr *s, unsigned base)
+{
   bignum_set(r, 0);
 
-  char c;
-  error err;
+  chunking c = base_chunking(base);
+
+  /* Take a short chunk first, so the rest are whole. */
+  size_t digits = sstr_left(s) % c.digits;
+  if (digits == 0)
+    digits = c.digits;
 
-  while (!sstr_takec(s, &c))
+  while (sstr_left(s))
   {
-    if (c >= '0' && c <= '9')
-      digit = c - '0';
-    else
+    uint32_t chunk, scale;
+    if (take_chunk(s, digits, base, &chunk, &scale))
       return error_invalid_string;
 
-    if ((err = bignum_multw(&bignum_tmp, r, r, 10)))
-      return err;
-    if ((err = bignum_addl(r, &bignum_dig)))
+    error err = bignum_muladdw(r, scale, chunk);
+    if (err)
       return err;
+
+    digits = c.digits;
   }
 
   return OK;
 }
 
-/* nb. this could be generalised to more bases quite nicely.
- * Don't need that right now, though. */
+/* owner is the result, as for fmt_chunked. */
+static error parse_dec(bignum *r, sstr *s, const bignum *owner)
+{
+  size_t len = sstr_left(s);
+
+  if (len / DEC_CHUNK_DIGITS < bignum_dec_dc_threshold)
+    return parse_chunked(r, s, 10);
+
+  /* Split off the bottom d = DEC_POWER_DIGITS(k) digits, for the
+   * largest such d below len, so high has no more digits than low.
+   * Then r = high * 10^d + low.
+   *
+   * Past the powers there are, or if they can't be made, parse it
+   * in chunks.  Making power k makes those below, so this is only
+   * needed at the top. */
+  size_t k = 0;
+  while (k + 1 < DEC_POWERS && DEC_POWER_DIGITS(k + 1) < len)
+    k++;
+
+  const bignum *power;
+  if (len > 2 * DEC_POWER_DIGITS(k) || bignum_dec_power(&power, k))
+    return parse_chunked(r, s, 10);
+
+  sstr high = { s->start, s->end - DEC_POWER_DIGITS(k) };
+  sstr low = { high.end, s->end };
+
+  /* Each chunk of digits fits in a word. */
+  BIGNUM_SCRATCH_FOR(tmp, len / DEC_CHUNK_DIGITS + 1, owner);
+  ER(parse_dec(&tmp, &high, owner));
+  ER(bignum_mul(r, &tmp, power));
+  ER(parse_dec(&tmp, &low, owner));
+  ER(bignum_addl(r, &tmp));
+
+  s->start = s->end;
+  return OK;
+}
+
+/* Parses all of s in base. */
+static error parse_digits(bignum *r, sstr *s, unsigned base)
+{
+  unsigned bits = base_bits(base);
+
+  if (bits)
+    return parse_pow2(r, s, bits);
+  else if (base == 10)
+    return parse_dec(r, s, r);
+  else
+    return parse_chunked(r, s, base);
+}
+
+/* Slurps any '-' from the front of s. */
+static unsigned take_negmark(sstr *s)
+{
+  char negmark;
+  return !sstr_peekn(s, &negmark, 1) &&
+         negmark == '-' &&
+         !sstr_skip(s, 1);
+}
+
 error bignum_parse_strl(bignum *r, const char *buf, size_t len)
 {
   sstr s = { (char *) buf, (char*) buf + len };
-  char hexmark[2], negmark;
-  unsigned hex = 0, neg = 0;
-  
-  /* Slurp any '-' first. */
-  if (!sstr_peekn(&s, &negmark, 1) &&
-      negmark == '-' &&
-      !sstr_skip(&s, 1))
-    neg = 1;
+  char hexmark[2];
+  unsigned hex = 0, neg = take_negmark(&s);
 
   /* Slurp any '0x' next. */
   if (!sstr_peekn(&s, hexmark, sizeof hexmark) &&
@@ -215,11 +571,7 @@ error bignum_parse_strl(bignum *r, const char *buf, size_t len)
       !sstr_skip(&s, sizeof hexmark))
     hex = 1;
 
-  error err;
-  if (hex)
-    err = parse_hex(r, &s);
-  else
-    err = parse_dec(r, &s);
+  error err = parse_digits(r, &s, hex ? 16 : 10);
 
   if (err == OK && neg)
     bignum_setsign(r, -1);
@@ -227,3 +579,66 @@ error bignum_parse_strl(bignum *r, const char *buf, size_t len)
   bignum_canon(r);
   return err;
 }
+
+error bignum_parse_base(bignum *r, const char *buf, size_t len, unsigned base)
+{
+  assert(base >= 2 && base <= 36);
+
+  sstr s = { (char *) buf, (char *) buf + len };
+  unsigned neg = take_negmark(&s);
+
+  error err = parse_digits(r, &s, base);
+
+  if (err == OK && neg)
+    bignum_setsign(r, -1);
+
+  bignum_canon(r);
+  return err;
+}
+
+error bignum_fmt_base(const bignum *b, unsigned base, char *buf, size_t len)
+{
+  assert(!bignum_check(b));
+  assert(buf && len);
+  assert(base >= 2 && base <= 36);
+
+  unsigned bits = base_bits(base);
+
+  if (base == 10)
+    return bignum_fmt_dec(b, buf, len);
+
+  if (bits)
+  {
+    size_t digits = (bignum_len_bits(b) + bits - 1) / bits;
+    size_t sign = bignum_is_negative(b);
+
+    if (len < sign + digits + 1)
+      return error_buffer_sz;
+
+    if (sign)
+      *buf++ = '-';
+
+    fmt_pow2(b, bits, buf + digits, digits);
+    buf[digits] = 0;
+    return OK;
+  }
+
+  /* Work from right to left */
+  char *out = buf + len;
+  *--out = 0;
+
+  ER(fmt_chunked(b, base, &out, buf, 0, b));
+
+  if (bignum_is_negative(b))
+  {
+    if (out == buf)
+      return error_buffer_sz;
+
+    *--out = '-';
+  }
+
+  /* Adjust left */
+  memmove(buf, out, buf + len - out);
+
+  return OK;
+}
@@ -7,7 +7,13 @@
 
 #include <stddef.h>
 #include <stdint.h>
+#include <stdio.h>
 #include "bignum.h"
+#include "dstr.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
 
 /**
  * Formats the value of b in hex into buf.  buf is always
@@ -40,6 +46,76 @@ error bignum_fmt_hex(const bignum *b, char *buf, size_t len);
  */
 error bignum_fmt_dec(const bignum *b, char *buf, size_t len);
 
+/**
+ * Formats the value of b in the given base into buf.  buf is
+ * always 0 terminated if OK is returned.
+ *
+ * Formatting:
+ * - Negative numbers are prepended with '-',
+ * - Digits above 9 are lower case letters,
+ * - There is no prefix, and no leading zeroes (zero is "0").
+ *
+ * Power of two bases are taken straight from the words of b;
+ * other bases by repeated division.
+ *
+ * error_buffer_sz is returned if buf isn't big enough.
+ * buf as NULL, len as 0, or base outside 2 to 36 is
+ * meaningless and illegal.
+ */
+error bignum_fmt_base(const bignum *b, unsigned base, char *buf, size_t len);
+
+/**
+ * A destination for formatted numbers.  write is called with
+ * the formatted text (not 0 terminated), and returns 0 on
+ * success.
+ */
+typedef struct
+{
+  unsigned (*write)(void *ctx, const char *buf, size_t len);
+  void *ctx;
+} bignum_sink;
+
+/**
+ * Formats b as bignum_fmt_hex or bignum_fmt_dec would, and
+ * passes the result to sink.
+ *
+ * error_io is returned if the sink fails.
+ */
+error bignum_fmt_hex_sink(const bignum *b, const bignum_sink *sink);
+error bignum_fmt_dec_sink(const bignum *b, const bignum_sink *sink);
+
+/**
+ * Formats b as bignum_fmt_hex or bignum_fmt_dec would, appending
+ * to d (without 0 termination).  d is grown once, to a size worked
+ * out from the length of b.
+ *
+ * error_buffer_sz is returned if d cannot be grown.
+ */
+error bignum_fmt_hex_dstr(const bignum *b, dstr *d);
+error bignum_fmt_dec_dstr(const bignum *b, dstr *d);
+
+/**
+ * Formats b as bignum_fmt_hex or bignum_fmt_dec would, writing
+ * to f (without 0 termination).
+ *
+ * error_io is returned if writing fails.
+ */
+error bignum_fmt_hex_file(const bignum *b, FILE *f);
+error bignum_fmt_dec_file(const bignum *b, FILE *f);
+
+/**
+ * Numbers of at least this many words are converted to and
+ * from decimal by divide and conquer: they are split by a cached
+ * power of ten into halves which are converted recursively.
+ * Smaller numbers are converted nine digits at a time.
+ *
+ * This is only a win with fast multiplication and division,
+ * so the default is SIZE_MAX, which turns it off.  make tune
+ * measures it for the machine, and builds the library with the
+ * result.
+ */
+extern size_t bignum_dec_dc_threshold;
+
 /**
  * Parses the hex value from the characters at buf[:len].
  *
@@ -50,6 +126,18 @@ error bignum_fmt_dec(const bignum *b, char *buf, size_t len);
  */
 error bignum_parse_strl(bignum *out, const char *buf, size_t len);
 
+/**
+ * Parses the characters at buf[:len] as a number in the given base.
+ *
+ * - If the string starts with '-', the number is negative.
+ * - There is no prefix: a leading '0x' is not skipped.
+ * - Both cases of letter digits are allowed.
+ *
+ * error_invalid_string is returned for a character which is not
+ * a digit in base.  base outside 2 to 36 is illegal.
+ */
+error bignum_parse_base(bignum *out, const char *buf, size_t len, unsigned base);
+
 /**
  * Nul-terminated version of bignum_parse_strl.
  *
@@ -57,4 +145,96 @@ error bignum_parse_strl(bignum *out, const char *buf, size_t len);
  */
 error bignum_parse_str(bignum *out, const char *buf);
 
+/**
+ * Incremental parser, for numbers which arrive in pieces.
+ *
+ * The syntax is that of bignum_parse_strl, except that trailing
+ * whitespace (such as a final newline) is allowed.  Hex is
+ * accumulated straight into the words of the result; decimal
+ * nine digits at a time.
+ *
+ * Decimal costs a multiply by 10^9 across the whole result for
+ * every nine digits, so time goes as the square of the length.
+ * With divide and conquer on (see bignum_dec_dc_threshold), decimal
+ * into a growable result is instead gathered in blocks of that
+ * many chunks, which are combined pairwise as they pile up, each
+ * pair by one multiply by a power of ten: a product tree.  The
+ * blocks are held in storage from r's allocator until the parser
+ * is finished.
+ *
+ * Usage:
+ *   bignum_parser p;
+ *   bignum_parser_init(&p, r);
+ *   while (more input)
+ *     ER(bignum_parser_feed(&p, buf, len));
+ *   ER(bignum_parser_finish(&p));
+ *
+ * To give up part way, call bignum_parser_finish anyway, to release
+ * its storage.  The fields are private.
+ */
+#define BIGNUM_PARSER_PARTS 40
+
+typedef struct
+{
+  bignum *r;
+  unsigned state, neg, hex;
+  uint32_t chunk;
+  unsigned chunk_digits;
+  size_t words;
+
+  /* Decimal blocks, most significant first, and the chunks in r
+   * since the last. */
+  bignum parts[BIGNUM_PARSER_PARTS];
+  unsigned part_levels[BIGNUM_PARSER_PARTS];
+  unsigned nparts, block_level;
+  size_t block_chunks;
+} bignum_parser;
+
+/** Starts parsing into r.  r must stay valid until finished. */
+void bignum_parser_init(bignum_parser *p, bignum *r);
+
+/**
+ * Parses buf[:len], which continues the input.
+ *
+ * error_invalid_string or error_bignum_sz are returned as
+ * bignum_parse_strl would, and after either p is finished.
+ */
+error bignum_parser_feed(bignum_parser *p, const char *buf, size_t len);
+
+/** Completes parsing.  r is meaningless until this returns OK. */
+error bignum_parser_finish(bignum_parser *p);
+
+/**
+ * Called while streaming input, after each window.  done is the
+ * number of bytes consumed so far; total is the input size, or 0
+ * if that's unknown (eg. for a pipe).
+ */
+typedef struct
+{
+  void (*progress)(void *ctx, uint64_t done, uint64_t total);
+  void *ctx;
+} bignum_progress;
+
+/**
+ * Parses everything read from fd until end of file, into r.
+ * Input is read BIGNUM_PARSE_WINDOW bytes at a time.
+ *
+ * progress may be NULL.  error_io is returned if reading fails.
+ */
+error bignum_parse_fd(bignum *r, int fd, const bignum_progress *progress);
+
+/**
+ * As bignum_parse_fd, but fd is mapped into memory and parsed a
+ * window at a time.  Pages already parsed are dropped, so resident
+ * memory stays bounded.  fd must be a regular file.
+ */
+error bignum_parse_mmap(bignum *r, int fd, const bignum_progress *progress);
+
+/** Bytes of input handled between progress reports. */
+#define BIGNUM_PARSE_WINDOW 16384
+
+#ifdef __cplusplus
+}
+#endif
+
 #endif
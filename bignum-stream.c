@@ -0,0 +1,410 @@
+#include <assert.h>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "bignum.h"
+#include "bignum-str.h"
+#include "bignum-digits.h"
+#include "handy.h"
+
+enum
+{
+  ST_START,   /* nothing yet */
+  ST_PREFIX,  /* after any '-' */
+  ST_ZERO,    /* after a leading '0', which might start '0x' */
+  ST_DIGITS,  /* in the digits */
+  ST_TRAIL,   /* in trailing whitespace */
+  ST_DONE     /* finished, or failed */
+};
+
+/* Hex digits are collected into words, most significant first,
+ * in r->v[0..words).  They're put in order at the end, once the
+ * number of digits (and so their alignment) is known.
+ *
+ * Decimal digits are collected nine at a time and multiplied
+ * into r as they come.  For growable r, once divide and conquer
+ * pays (see bignum_dec_dc_threshold), every 2 ^ block_level chunks
+ * are moved to a new part, of DEC_POWER_DIGITS(block_level) digits.
+ * Two parts of the same level k are merged into one of level k + 1
+ * by hi * 10 ^ DEC_POWER_DIGITS(k) + lo, so the parts form a binary
+ * counter, with at most one of each level. */
+#define HEX_CHUNK_DIGITS 8
+
+/* The level of blocks of at least bignum_dec_dc_threshold chunks,
+ * or DEC_POWERS if there are none. */
+static unsigned block_level(void)
+{
+  unsigned k = 0;
+  while (k < DEC_POWERS && ((size_t) 1 << k) < bignum_dec_dc_threshold)
+    k++;
+  return k;
+}
+
+void bignum_parser_init(bignum_parser *p, bignum *r)
+{
+  assert(!bignum_check_mutable(r));
+
+  memset(p, 0, sizeof *p);
+  p->r = r;
+  p->state = ST_START;
+  p->block_level = (r->flags & BIGNUM_F_GROWABLE) ? block_level() : DEC_POWERS;
+  bignum_setu(r, 0);
+}
+
+/* Frees the decimal parts. */
+static void release(bignum_parser *p)
+{
+  for (unsigned i = 0; i < p->nparts; i++)
+    bignum_clear(&p->parts[i]);
+  p->nparts = 0;
+}
+
+/* Sets r = hi * 10 ^ DEC_POWER_DIGITS(k) + lo (or just the product
+ * if lo is NULL), in new storage from hi's allocator. */
+static error combine(bignum *r, const bignum *hi, const bignum *lo, unsigned k)
+{
+  const bignum *power;
+  if (k >= DEC_POWERS)
+    return error_bignum_sz;
+  ER(bignum_dec_power(&power, k));
+
+  ER(bignum_init_growable(r, bignum_len_words(hi) + bignum_len_words(power) + 1,
+                          hi->allocator));
+  error err = bignum_mul(r, hi, power);
+  if (!err && lo)
+    err = bignum_addl(r, lo);
+  if (err)
+    bignum_clear(r);
+  return err;
+}
+
+/* Moves the block of chunks in r to a new part, and merges parts
+ * of the same level. */
+static error push_block(bignum_parser *p)
+{
+  if (p->nparts == BIGNUM_PARSER_PARTS)
+    return error_bignum_sz;
+
+  bignum *part = &p->parts[p->nparts];
+  ER(bignum_init_growable(part, bignum_len_words(p->r), p->r->allocator));
+  p->part_levels[p->nparts++] = p->block_level;
+  ER(bignum_dup(part, p->r));
+  bignum_setu(p->r, 0);
+  p->block_chunks = 0;
+
+  while (p->nparts >= 2 &&
+         p->part_levels[p->nparts - 1] == p->part_levels[p->nparts - 2])
+  {
+    bignum *hi = &p->parts[p->nparts - 2], *lo = &p->parts[p->nparts - 1];
+    unsigned k = p->part_levels[p->nparts - 1];
+    bignum merged;
+
+    ER(combine(&merged, hi, lo, k));
+    bignum_clear(hi);
+    bignum_clear(lo);
+    *hi = merged;
+    p->nparts--;
+    p->part_levels[p->nparts - 1] = k + 1;
+  }
+
+  return OK;
+}
+
+static unsigned is_space(char c)
+{
+  return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+/* Takes c, which is a digit or trailing whitespace. */
+static error take(bignum_parser *p, char c)
+{
+  if (is_space(c))
+  {
+    p->state = ST_TRAIL;
+    return OK;
+  }
+
+  unsigned digit = digit_value(c);
+
+  if (p->state == ST_TRAIL || digit >= (p->hex ? 16u : 10u))
+    return error_invalid_string;
+
+  if (p->hex)
+  {
+    /* Leading zeroes don't count towards the size. */
+    if (p->words == 0 && p->chunk_digits == 0 && digit == 0)
+      return OK;
+
+    p->chunk = (p->chunk << 4) | digit;
+    if (++p->chunk_digits == HEX_CHUNK_DIGITS)
+    {
+      ER(bignum_reserve(p->r, p->words + 1));
+      p->r->v[p->words++] = p->chunk;
+      p->r->dirty = MAX(p->r->dirty, p->words);
+      p->chunk = p->chunk_digits = 0;
+    }
+  } else {
+    p->chunk = p->chunk * 10 + digit;
+    if (++p->chunk_digits == DEC_CHUNK_DIGITS)
+    {
+      ER(bignum_muladdw(p->r, DEC_CHUNK, p->chunk));
+      p->chunk = p->chunk_digits = 0;
+
+      if (p->block_level < DEC_POWERS &&
+          ++p->block_chunks == (size_t) 1 << p->block_level)
+        ER(push_block(p));
+    }
+  }
+
+  return OK;
+}
+
+error bignum_parser_feed(bignum_parser *p, const char *buf, size_t len)
+{
+  for (size_t i = 0; i < len; i++)
+  {
+    char c = buf[i];
+
+    switch (p->state)
+    {
+      case ST_START:
+        p->state = ST_PREFIX;
+        if (c == '-')
+        {
+          p->neg = 1;
+          continue;
+        }
+        /* fall through */
+
+      case ST_PREFIX:
+        if (c == '0')
+        {
+          p->state = ST_ZERO;
+          continue;
+        }
+        p->state = ST_DIGITS;
+        break;
+
+      case ST_ZERO:
+        p->state = ST_DIGITS;
+        if (c == 'x')
+        {
+          p->hex = 1;
+          continue;
+        }
+        break;
+
+      case ST_DIGITS:
+      case ST_TRAIL:
+        break;
+
+      default:
+        return error_invalid_string;
+    }
+
+    error err = take(p, c);
+    if (err)
+    {
+      p->state = ST_DONE;
+      release(p);
+      return err;
+    }
+  }
+
+  return OK;
+}
+
+/* Puts the hex words in order, and appends the short chunk. */
+static error finish_hex(bignum_parser *p)
+{
+  bignum *r = p->r;
+  size_t n = p->words;
+
+  for (size_t i = 0; i < n / 2; i++)
+  {
+    uint32_t t = r->v[i];
+    r->v[i] = r->v[n - 1 - i];
+    r->v[n - 1 - i] = t;
+  }
+
+  r->vtop = r->v + (n ? n - 1 : 0);
+
+  if (p->chunk_digits)
+  {
+    unsigned shift = 4 * p->chunk_digits;
+    uint32_t carry = p->chunk;
+
+    for (size_t i = 0; i < n; i++)
+    {
+      uint32_t w = r->v[i];
+      r->v[i] = (w << shift) | carry;
+      carry = w >> (BIGNUM_BITS - shift);
+    }
+
+    if (carry || n == 0)
+    {
+      ER(bignum_reserve(r, n + 1));
+      r->v[n] = carry;
+      r->vtop = r->v + n;
+    }
+  }
+
+  return OK;
+}
+
+/* Appends the short chunk, and puts the parts in front of r. */
+static error finish_dec(bignum_parser *p)
+{
+  bignum *r = p->r;
+
+  if (p->chunk_digits)
+  {
+    uint32_t scale = 1;
+    for (unsigned i = 0; i < p->chunk_digits; i++)
+      scale *= 10;
+    ER(bignum_muladdw(r, scale, p->chunk));
+  }
+
+  if (p->nparts == 0)
+    return OK;
+
+  /* Most significant first, the parts have levels in decreasing
+   * order, so each can be shifted up by the next's length.  Then
+   * make room for the chunks in r, a power for each bit of their
+   * count. */
+  for (unsigned i = 1; i < p->nparts; i++)
+  {
+    bignum merged;
+    ER(combine(&merged, &p->parts[0], &p->parts[i], p->part_levels[i]));
+    bignum_clear(&p->parts[0]);
+    p->parts[0] = merged;
+  }
+
+  bignum *acc = &p->parts[0];
+  for (unsigned k = 0; p->block_chunks >> k; k++)
+  {
+    if (!(p->block_chunks >> k & 1))
+      continue;
+
+    bignum shifted;
+    ER(combine(&shifted, acc, NULL, k));
+    bignum_clear(acc);
+    *acc = shifted;
+  }
+  if (p->chunk_digits)
+  {
+    uint32_t scale = 1;
+    for (unsigned i = 0; i < p->chunk_digits; i++)
+      scale *= 10;
+    ER(bignum_muladdw(acc, scale, 0));
+  }
+
+  ER(bignum_addl(acc, r));
+  return bignum_dup(r, acc);
+}
+
+error bignum_parser_finish(bignum_parser *p)
+{
+  if (p->state == ST_DONE)
+    return error_invalid_string;
+
+  p->state = ST_DONE;
+
+  error err = p->hex ? finish_hex(p) : finish_dec(p);
+  release(p);
+  ER(err);
+
+  bignum_canon(p->r);
+  if (p->neg)
+    bignum_setsign(p->r, -1);
+  bignum_canon(p->r);
+  return OK;
+}
+
+static void report(const bignum_progress *progress, uint64_t done, uint64_t total)
+{
+  if (progress && progress->progress)
+    progress->progress(progress->ctx, done, total);
+}
+
+error bignum_parse_fd(bignum *r, int fd, const bignum_progress *progress)
+{
+  char buf[BIGNUM_PARSE_WINDOW];
+  struct stat st;
+  uint64_t done = 0, total = 0;
+
+  if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode))
+    total = st.st_size;
+
+  bignum_parser p;
+  bignum_parser_init(&p, r);
+
+  while (1)
+  {
+    ssize_t got = read(fd, buf, sizeof buf);
+
+    if (got < 0 && errno == EINTR)
+      continue;
+    else if (got < 0)
+      return error_io;
+    else if (got == 0)
+      break;
+
+    ER(bignum_parser_feed(&p, buf, got));
+    done += got;
+    report(progress, done, total);
+  }
+
+  return bignum_parser_finish(&p);
+}
+
+error bignum_parse_mmap(bignum *r, int fd, const bignum_progress *progress)
+{
+  struct stat st;
+  if (fstat(fd, &st) || !S_ISREG(st.st_mode))
+    return error_io;
+
+  bignum_parser p;
+  bignum_parser_init(&p, r);
+
+  size_t size = st.st_size;
+  if (size == 0)
+    return bignum_parser_finish(&p);
+
+  char *map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (map == MAP_FAILED)
+    return error_io;
+
+  madvise(map, size, MADV_SEQUENTIAL);
+
+  size_t page = sysconf(_SC_PAGESIZE);
+  size_t done = 0, dropped = 0;
+  error err = OK;
+
+  while (done < size && !err)
+  {
+    size_t n = MIN(size - done, (size_t) BIGNUM_PARSE_WINDOW);
+    err = bignum_parser_feed(&p, map + done, n);
+    done += n;
+
+    /* We're finished with whole pages before done. */
+    size_t drop = done / page * page;
+    if (drop > dropped)
+    {
+      madvise(map + dropped, drop - dropped, MADV_DONTNEED);
+      dropped = drop;
+    }
+
+    if (!err)
+      report(progress, done, size);
+  }
+
+  munmap(map, size);
+
+  if (err)
+    return err;
+  return bignum_parser_finish(&p);
+}
@@ -25,8 +25,7 @@ error bignum_sub(bignum *r, const bignum *a, const bignum *b)
     return bignum_sub_unsigned(r, b, a);
   } else if (nega ^ negb) {
     error err = bignum_add_unsigned(r, a, b);
-    if (nega)
-      bignum_setsign(r, -1);
+    bignum_setsign(r, nega ? -1 : 1);
     return err;
   }
 
@@ -43,6 +42,10 @@ error bignum_sub_unsigned(bignum *r, const bignum *a, const bignum *b)
     bignum_abs(r);
   }
 
+  /* r->vtop is reset below, so remember how much of r was used. */
+  r->dirty = MAX(r->dirty, bignum_len_words(r));
+  ER(bignum_grow(r, MAX(bignum_len_words(a), bignum_len_words(b))));
+
   uint32_t *atop = a->vtop,
            *btop = b->vtop;
 
@@ -56,7 +59,7 @@ error bignum_sub_unsigned(bignum *r, const bignum *a, const bignum *b)
     if (!have_a)
       break;
     
-    if (rv - r->v >= r->words)
+    if ((size_t) (rv - r->v) >= r->words)
       return error_bignum_sz;
 
     uint32_t rw = *av++;
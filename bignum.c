@@ -8,12 +8,12 @@
 #include "handy.h"
 
 static uint32_t zero = 0, one = 1, base[2] = { 0, 1 };
-bignum bignum_0 = { &zero, &zero, 1, BIGNUM_F_IMMUTABLE };
-bignum bignum_1 = { &one, &one, 1, BIGNUM_F_IMMUTABLE };
-bignum bignum_neg1 = { &one, &one, 1, BIGNUM_F_IMMUTABLE | BIGNUM_F_NEG };
-bignum bignum_base = { &base[0], &base[1], 2, BIGNUM_F_IMMUTABLE };
+bignum bignum_0 = { &zero, &zero, 1, BIGNUM_F_IMMUTABLE, 0, NULL };
+bignum bignum_1 = { &one, &one, 1, BIGNUM_F_IMMUTABLE, 0, NULL };
+bignum bignum_neg1 = { &one, &one, 1, BIGNUM_F_IMMUTABLE | BIGNUM_F_NEG, 0, NULL };
+bignum bignum_base = { &base[0], &base[1], 2, BIGNUM_F_IMMUTABLE, 0, NULL };
 
-error bignum_check(const bignum *b)
+error bignum_check_storage(const bignum *b)
 {
   assert(b != NULL);
   if (b->v == NULL ||
@@ -21,12 +21,23 @@ error bignum_check(const bignum *b)
       b->v > b->vtop ||
       bignum_len_words(b) > b->words ||
       b->words == 0 ||
-      b->words > BIGNUM_MAX_WORDS ||
+      b->dirty > b->words ||
+      ((b->flags & BIGNUM_F_GROWABLE) && !b->allocator) ||
       (b->flags & ~BIGNUM_F__ALL))
     return error_invalid_bignum;
   return OK;
 }
 
+error bignum_check(const bignum *b)
+{
+  ER(bignum_check_storage(b));
+
+  /* vtop is the most significant non-zero word. */
+  if (b->vtop != b->v && *b->vtop == 0)
+    return error_invalid_bignum;
+  return OK;
+}
+
 error bignum_check_mutable(const bignum *b)
 {
   error e = bignum_check(b);
@@ -39,9 +50,11 @@ error bignum_cleartop(bignum *b, size_t words)
   assert(!bignum_check_mutable(b));
   assert(words != 0);
 
-  if (words == 0 || words > b->words)
+  if (words == 0)
     return error_bignum_sz;
 
+  ER(bignum_reserve(b, words));
+
   uint32_t *newtop = b->v + words - 1;
 
   for (uint32_t *ptr = b->vtop + 1;
@@ -49,13 +62,17 @@ error bignum_cleartop(bignum *b, size_t words)
        ptr++)
     *ptr = 0;
   b->vtop = newtop;
+  b->dirty = MAX(b->dirty, words);
 
   return OK;
 }
 
 void bignum_canon(bignum *b)
 {
-  assert(!bignum_check_mutable(b));
+  assert(!bignum_check_storage(b));
+  assert(!(b->flags & BIGNUM_F_IMMUTABLE));
+  b->dirty = MAX(b->dirty, bignum_len_words(b));
+
   while (b->vtop != b->v && *b->vtop == 0)
     b->vtop--;
   
@@ -66,7 +83,11 @@ void bignum_canon(bignum *b)
 void bignum_clear(bignum *b)
 {
   assert(!bignum_check_mutable(b));
-  mem_clean(b->v, b->words * BIGNUM_BYTES);
+  mem_clean(b->v, MAX(b->dirty, bignum_len_words(b)) * BIGNUM_BYTES);
+
+  if (b->flags & BIGNUM_F_GROWABLE)
+    b->allocator->free(b->allocator->ctx, b->v, b->words * BIGNUM_BYTES);
+
   mem_clean(b, sizeof *b);
 }
 
@@ -75,8 +96,9 @@ error bignum_dup(bignum *r, const bignum *a)
   assert(!bignum_check_mutable(r));
   assert(!bignum_check(a));
 
-  if (a->vtop - a->v >= r->words)
-    return error_bignum_sz;
+  ER(bignum_reserve(r, bignum_len_words(a)));
+
+  r->dirty = MAX(r->dirty, bignum_len_words(r));
 
   uint32_t *rtop = r->v + r->words - 1;
   uint32_t *atop = a->vtop;
@@ -89,7 +111,7 @@ error bignum_dup(bignum *r, const bignum *a)
     r->vtop = vr;
   }
 
-  r->flags = 0;
+  r->flags &= BIGNUM_F_GROWABLE;
   bignum_setsign(r, bignum_getsign(a));
   bignum_canon(r);
   return OK;
@@ -98,7 +120,13 @@ error bignum_dup(bignum *r, const bignum *a)
 void bignum_setu(bignum *b, uint32_t l)
 {
   assert(!bignum_check_mutable(b));
-  memset(b->v, 0, b->words * BIGNUM_BYTES);
+  b->dirty = MAX(b->dirty, bignum_len_words(b));
+
+#ifndef NDEBUG
+  /* Catch anyone relying on the old words being zeroed. */
+  memset(b->v, 0xa5, b->dirty * BIGNUM_BYTES);
+#endif
+
   *b->v = l;
   b->vtop = b->v;
   bignum_setsign(b, 1);
@@ -173,7 +201,8 @@ int bignum_getsign(const bignum *b)
 
 void bignum_setsign(bignum *b, int sign)
 {
-  assert(!bignum_check_mutable(b));
+  assert(!bignum_check_storage(b));
+  assert(!(b->flags & BIGNUM_F_IMMUTABLE));
   if (sign < 0)
     b->flags |= BIGNUM_F_NEG;
   else
@@ -183,12 +212,10 @@ void bignum_setsign(bignum *b, int sign)
 size_t bignum_len_bits(const bignum *b)
 {
   assert(!bignum_check(b));
-  uint32_t *v = b->vtop;
-  while (v != b->v && *v == 0)
-    v--;
 
-  size_t whole_words = v - b->v;
-  uint8_t extra_bits = bignum_math_uint32_fls(*v);
+  /* vtop is the top non-zero word, unless b is zero. */
+  size_t whole_words = b->vtop - b->v;
+  uint8_t extra_bits = bignum_math_uint32_fls(*b->vtop);
 
   /* Zero: we need 1 bit to represent this. */
   if (extra_bits == 0 && whole_words == 0)
@@ -219,7 +246,7 @@ uint8_t bignum_get_byte(const bignum *b, size_t n)
   size_t word = n / BIGNUM_BYTES;
   size_t byte = n % BIGNUM_BYTES;
 
-  if (word > bignum_len_words(b))
+  if (word >= bignum_len_words(b))
     return 0;
 
   return (b->v[word] >> (byte * 8)) & 0xff;
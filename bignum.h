@@ -4,6 +4,10 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 typedef enum
 {
   OK = 0,
@@ -12,7 +16,10 @@ typedef enum
   error_bignum_sz,
   error_invalid_string,
   error_div_zero,
-  error_no_inverse
+  error_no_inverse,
+  error_no_sqrt,
+  error_io,
+  error_infinity
 } error;
 
 #define BIGNUM_BYTES 4
@@ -20,15 +27,48 @@ typedef enum
 #define BITS_TO_BYTES(bits) (((bits) + 7) >> 3)
 #define BYTES_TO_BITS(bytes) ((bytes) << 3)
 
-/** We have a fairly arbitrary limit on the size of bignum we'll
- *  process, for sanity checking rather than because of any
- *  underlying limitation.
+/** The size of fixed temporaries (BIGNUM_TMP, and internal
+ *  scratch space not sized to the operands).  Functions which need
+ *  these cannot handle larger numbers.  Within the library, that is
+ *  only bignum_modstream, whose state is fixed size.  Everything
+ *  else sizes its scratch space from its operands, so is limited
+ *  by the thread's arena instead (see BIGNUM_ARENA_WORDS).
  *
- *  In fact, the structure can handle up to 0xffff word-bignums
- *  so, 2-million-odd bits.
+ *  This is not a limit on the size of bignums themselves: see
+ *  bignum_init_growable.
  */
 #define BIGNUM_MAX_WORDS 256
 
+/** Source of storage for growable bignums. */
+typedef struct
+{
+  /** Returns at least bytes bytes of storage aligned for uint32_t,
+   *  or NULL. */
+  void *(*alloc)(void *ctx, size_t bytes);
+
+  /** Releases ptr, which was returned by alloc for bytes bytes. */
+  void (*free)(void *ctx, void *ptr, size_t bytes);
+
+  void *ctx;
+} bignum_allocator;
+
+/** Allocator using malloc and free. */
+extern const bignum_allocator bignum_malloc_allocator;
+
+/** Allocators drawing from a process-wide pool of power-of-two
+ *  sized buffers.  Each thread caches freed buffers, and passes
+ *  them to the other threads in batches through lock-free lists.
+ *  Requests over 128KB go to malloc.
+ *
+ *  The _clean variant zeroes whole buffers when they're freed.
+ *  (bignum_clear already wipes the words a bignum has used.) */
+extern const bignum_allocator bignum_pool_allocator;
+extern const bignum_allocator bignum_pool_allocator_clean;
+
+/** Frees the buffers cached by the calling thread, and those shared
+ *  between threads, back to malloc. */
+void bignum_pool_trim(void);
+
 /**
  * Arbitrary sized integer type.
  *
@@ -37,30 +77,44 @@ typedef enum
 typedef struct
 {
   /** Magnitude:
-   *  LSW first vector of words, with possibly trailing zeroes. */
+   *  LSW first vector of words, with possibly trailing zeroes.
+   *  Words above vtop are undefined: they are not necessarily zero. */
   uint32_t *v;
   
   /** MSW of v. vtop - v < words. */
   uint32_t *vtop;
 
   /** The number of words available for use pointed to by v. */
-  uint16_t words;
+  size_t words;
 
   /** Number is negative. Negative zeros are allowed, but are not canonical. */
 #define BIGNUM_F_NEG        0x0001
   /** Number is immutable.  Trying to mutate this number will cause an assert to fail. */
 #define BIGNUM_F_IMMUTABLE  0x0002
+  /** v is owned, and was allocated from allocator.  Storage grows as
+   *  needed, rather than functions returning error_bignum_sz. */
+#define BIGNUM_F_GROWABLE   0x0004
   /** All valid flags. */
-#define BIGNUM_F__ALL       0x0003
+#define BIGNUM_F__ALL       0x0007
   uint16_t flags;
+
+  /** High-water mark: words at v + dirty and above have not held
+   *  any part of a value, so need not be zeroed or wiped.  This is
+   *  maintained by bignum_cleartop and bignum_canon, and may be left
+   *  zero by initialisers if storage above vtop is unused. */
+  size_t dirty;
+
+  /** Where v came from, for BIGNUM_F_GROWABLE bignums. */
+  const bignum_allocator *allocator;
 } bignum;
 
 /** Pre-canned immutable bignums: 0, 1, -1 and 2 ** BIGNUM_BITS. */
 extern bignum bignum_0, bignum_1, bignum_neg1, bignum_base;
 
 #define BIGNUM_TMP_SZ(var, words) \
-  uint32_t var ## _words[words] = { 0 }; \
-  bignum var = { var ## _words, var ## _words, words, 0 }
+  uint32_t var ## _words[words]; \
+  var ## _words[0] = 0; \
+  bignum var = { var ## _words, var ## _words, words, 0, 1, NULL }
 
 /** Defines a bignum with identifier var, suitable for providing as a
  *  temporary for functions which need it.
@@ -68,14 +122,118 @@ extern bignum bignum_0, bignum_1, bignum_neg1, bignum_base;
  *  This uses quite a lot of stack, so consider doing it once per thread. */
 #define BIGNUM_TMP(var) BIGNUM_TMP_SZ(var, BIGNUM_MAX_WORDS)
 
+/** Scratch space for temporary bignums: a stack of words, allocated
+ *  from the bottom up and released in reverse order.
+ *
+ *  Library functions take their temporaries from the calling
+ *  thread's arena (see bignum_arena_thread), rather than the stack.
+ *  Space is not zeroed, on allocation or release, except by
+ *  BIGNUM_SCRATCH_SECRET.
+ */
+typedef struct
+{
+  uint32_t *base, *top, *end;
+} bignum_arena;
+
+/** A position in an arena, to release back to. */
+typedef struct
+{
+  bignum_arena *arena;
+  uint32_t *top;
+} bignum_arena_mark;
+
+/** Default size of each thread's arena, in words. */
+#ifndef BIGNUM_ARENA_WORDS
+# define BIGNUM_ARENA_WORDS (64 * BIGNUM_MAX_WORDS)
+#endif
+
+/** Makes a an arena of the n words at words. */
+void bignum_arena_init(bignum_arena *a, uint32_t *words, size_t n);
+
+/** Returns the calling thread's arena.  Unless replaced with
+ *  bignum_arena_use, this is BIGNUM_ARENA_WORDS words allocated
+ *  on first use, and freed when the thread exits. */
+bignum_arena *bignum_arena_thread(void);
+
+/** Makes a the calling thread's arena, returning the previous one.
+ *  Passing NULL restores the default.  The previous arena must not
+ *  be in use (ie. don't call this while inside the library). */
+bignum_arena *bignum_arena_use(bignum_arena *a);
+
+/** Sets b to a zero bignum with space for words words, allocated
+ *  from a.
+ *
+ *  Returns error_bignum_sz if a is exhausted. */
+error bignum_arena_alloc(bignum_arena *a, bignum *b, size_t words);
+
+/** Returns the current position of a. */
+bignum_arena_mark bignum_arena_save(bignum_arena *a);
+
+/** Releases everything allocated since m was saved. */
+void bignum_arena_restore(bignum_arena_mark *m);
+
+/** As bignum_arena_restore, but zeroes the released space. */
+void bignum_arena_restore_clean(bignum_arena_mark *m);
+
+/** Defines a bignum with identifier var and space for words words,
+ *  from the thread's arena.  It is released at the end of the
+ *  enclosing scope.  If the arena is exhausted, the enclosing
+ *  function returns error_bignum_sz.
+ *
+ *  This is the cheap alternative to BIGNUM_TMP: it uses no stack,
+ *  and zeroes nothing. */
+#define BIGNUM_SCRATCH(var, words) \
+  BIGNUM_SCRATCH_WITH(var, words, bignum_arena_restore)
+
+/** As BIGNUM_SCRATCH, but zeroes the space on release.  Use this for
+ *  temporaries which might hold secrets. */
+#define BIGNUM_SCRATCH_SECRET(var, words) \
+  BIGNUM_SCRATCH_WITH(var, words, bignum_arena_restore_clean)
+
+#define BIGNUM_SCRATCH_WITH(var, words, release) \
+  bignum_arena_mark var ## _mark __attribute__((cleanup(release))) = \
+    bignum_arena_save(bignum_arena_thread()); \
+  bignum var; \
+  ER(bignum_arena_alloc(var ## _mark.arena, &var, words))
+
+/** As BIGNUM_SCRATCH, but if operand is growable and the arena is
+ *  short of space, var is a growable bignum from operand's
+ *  allocator instead, and is cleared at the end of the enclosing
+ *  scope.  Short means less than four times words left, so that
+ *  functions called with var still find space in the arena.
+ *
+ *  Use this for scratch space sized from operands which may be
+ *  growable, so that their size is limited by their allocator
+ *  rather than the arena. */
+#define BIGNUM_SCRATCH_FOR(var, words, operand) \
+  bignum_arena_mark var ## _mark __attribute__((cleanup(bignum_arena_restore))) = \
+    bignum_arena_save(bignum_arena_thread()); \
+  bignum var __attribute__((cleanup(bignum_scratch_release))) = { 0 }; \
+  ER(bignum_scratch_alloc(var ## _mark.arena, &var, words, operand))
+
+/** Allocates b as BIGNUM_SCRATCH_FOR does. */
+error bignum_scratch_alloc(bignum_arena *a, bignum *b, size_t words,
+                           const bignum *operand);
+
+/** Clears b if bignum_scratch_alloc made it growable. */
+void bignum_scratch_release(bignum *b);
+
 /** Sanity check b.
  *
  * Returns an error if the bignum is internally consistent, OK otherwise.
+ * That includes the canonical form every public function leaves its
+ * results in: vtop points at the most significant non-zero word, or
+ * at v for zero.  So lengths are O(1).
  *
  * Example: assert(!bignum_check(b))
  */
 error bignum_check(const bignum *b);
 
+/** As bignum_check, but allows vtop to point at zero words above
+ *  the value: for bignums part way through being written, between
+ *  bignum_cleartop and bignum_canon. */
+error bignum_check_storage(const bignum *b);
+
 /** Sanity check b, and fail an assert if it is immutable. */
 error bignum_check_mutable(const bignum *b);
 
@@ -88,6 +246,7 @@ error bignum_check_mutable(const bignum *b);
 void bignum_canon(bignum *b);
 
 /** Moves b->vtop to b->v + words, zeroing as it goes.
+ *  Only words above the old vtop are written.
  *
  *  Use this to prepare a bignum for arbitrary writes
  *  to storage, then use bignum_canon afterwards to
@@ -96,9 +255,33 @@ void bignum_canon(bignum *b);
  *  Fails if there isn't enough storage. */
 error bignum_cleartop(bignum *b, size_t words);
 
-/** Zeroes all digits, and leave structure b invalid. */
+/** Zeroes all digits that have been used (see bignum.dirty), and
+ *  leave structure b invalid.  Growable storage is freed. */
 void bignum_clear(bignum *b);
 
+/** Sets b to a growable zero, with initial space for words words
+ *  (at least one) from allocator a, or malloc if a is NULL.
+ *
+ *  Release b with bignum_clear.  Don't copy the structure: growing
+ *  one copy would leave the other dangling.
+ *
+ *  Most functions take their scratch space from the thread's arena,
+ *  so fail with error_bignum_sz for operands approaching
+ *  BIGNUM_ARENA_WORDS, growable or not.  Division, gcd and decimal
+ *  conversion instead take scratch space for growable operands from
+ *  their allocator when the arena is short (see BIGNUM_SCRATCH_FOR). */
+error bignum_init_growable(bignum *b, size_t words, const bignum_allocator *a);
+
+/** Ensures b has space for words words.  Growable bignums are
+ *  reallocated if need be; others fail with error_bignum_sz if
+ *  they are too small. */
+error bignum_reserve(bignum *b, size_t words);
+
+/** As bignum_reserve, but only for growable b: b is unchanged
+ *  otherwise.  This suits upper bounds which fixed size results
+ *  needn't meet. */
+error bignum_grow(bignum *b, size_t words);
+
 /** Copies the value of a into r. */
 error bignum_dup(bignum *r, const bignum *a);
 
@@ -135,6 +318,44 @@ uint8_t bignum_get_byte(const bignum *b, size_t n);
  */
 error bignum_set_byte(bignum *b, uint8_t v, size_t n);
 
+/** Byte orders for bignum_from_bytes and bignum_to_bytes. */
+typedef enum
+{
+  bignum_big_endian,
+  bignum_little_endian
+} bignum_endian;
+
+/** Sets r to the unsigned value of the len bytes at buf,
+ *  which are in the given order.
+ *
+ *  Leading zero bytes are allowed, and don't count towards
+ *  the size.  If r is too small, error_bignum_sz is returned.
+ */
+error bignum_from_bytes(bignum *r, const uint8_t *buf, size_t len,
+                        bignum_endian order);
+
+/** Writes the magnitude of b into exactly len bytes at buf,
+ *  in the given order, zero padded.  The sign is ignored.
+ *
+ *  For the minimal encoding, use len = bignum_len_bytes(b).
+ *  (Zero is then a single zero byte.)
+ *
+ *  If b does not fit, error_buffer_sz is returned.
+ */
+error bignum_to_bytes(const bignum *b, uint8_t *buf, size_t len,
+                      bignum_endian order);
+
+/** Makes r an immutable bignum whose words are the len little
+ *  endian bytes at buf, without copying them.  r is only valid
+ *  while buf is, and must not be cleared.
+ *
+ *  This needs a little endian host, buf aligned for uint32_t,
+ *  and len a non-zero multiple of BIGNUM_BYTES.  Otherwise
+ *  error_invalid_bignum is returned, and bignum_from_bytes must
+ *  be used instead.
+ */
+error bignum_view_bytes_le(bignum *r, const uint8_t *buf, size_t len);
+
 /** Returns the value of the i-th bit in the bignum.
  *
  *  i = 0 gives the rightmost (LSB) bit.
@@ -206,6 +427,13 @@ unsigned bignum_eq32(const bignum *a, int32_t b);
 /** Returns 1 if a == b, 0 otherwise.  In constant time. */
 unsigned bignum_const_eq(const bignum *a, const bignum *b);
 
+/** Returns -1, 0 or 1 as abs(a) is less than, equal to or greater
+ *  than abs(b), in one pass down from the top words. */
+int bignum_mag_cmp(const bignum *a, const bignum *b);
+
+/** Returns -1, 0 or 1 as a is less than, equal to or greater than b. */
+int bignum_cmp(const bignum *a, const bignum *b);
+
 /** Returns abs(a) < abs(b). */
 unsigned bignum_mag_lt(const bignum *a, const bignum *b);
 
@@ -286,6 +514,22 @@ error bignum_mulw(bignum *r, const bignum *a, uint32_t w);
  * r may alias a.  tmp must not alias anything else. */
 error bignum_multw(bignum *tmp, bignum *r, const bignum *a, uint32_t w);
 
+/** r = r + a * b, accumulating the product straight into r.
+ *
+ * r MUST NOT alias a or b. */
+error bignum_muladd(bignum *r, const bignum *a, const bignum *b);
+
+/** r = r - a * b, accumulating the product straight into r.
+ *
+ * r MUST NOT alias a or b. */
+error bignum_mulsub(bignum *r, const bignum *a, const bignum *b);
+
+/** r = r * w + add, on the magnitude of r (the sign of r is
+ *  unchanged).
+ *
+ *  Fails with error_bignum_sz if the result is too large. */
+error bignum_muladdw(bignum *r, uint32_t w, uint32_t add);
+
 /** Shifts r left by the given number of bits.
  *
  *  Fails with error_bignum_sz if the resulting value is too large. */
@@ -328,11 +572,89 @@ error bignum_mod(bignum *r, const bignum *a, const bignum *b);
  */
 error bignum_divmod(bignum *q, bignum *r, const bignum *a, const bignum *b);
 
+/** r = floor(sqrt(a)).
+ *  rem = a - r ^ 2, unless rem is NULL.
+ *
+ *  a must not be negative, otherwise error_invalid_bignum
+ *  is returned.  r and rem must not alias a. */
+error bignum_sqrt(bignum *r, bignum *rem, const bignum *a);
+
+/** r = floor(a ^ (1/n)).
+ *  rem = a - r ^ n, unless rem is NULL.
+ *
+ *  n must be at least 1 and a must not be negative, otherwise
+ *  error_invalid_bignum is returned.  r and rem must not
+ *  alias a. */
+error bignum_rootn(bignum *r, bignum *rem, const bignum *a, unsigned n);
+
+/** Sets *result to 1 if a = b ^ k for some integers b and
+ *  k >= 2, 0 otherwise.
+ *
+ *  Zero and one are perfect powers.  Negative a are perfect
+ *  powers if k can be odd, so -8 is but -4 is not. */
+error bignum_is_perfect_power(unsigned *result, const bignum *a);
+
+/** q = a / w
+ *  *rem = a mod w, unless rem is NULL.
+ *
+ *  This works on the magnitude of a: q has the sign of a,
+ *  and the remainder is never negative.
+ *
+ *  q may alias a.
+ *  if w is zero, error_div_zero is returned.
+ */
+error bignum_divmodw(bignum *q, uint32_t *rem, const bignum *a, uint32_t w);
+
 /** Return a * b mod p.
  *
  *  Arguments may alias in any combination. */
 error bignum_modmul(bignum *r, const bignum *a, const bignum *b, const bignum *p);
 
+/** Reduces a stream of bytes, of any length, modulo m.
+ *
+ *  Input is taken in blocks as wide as m, with Horner's rule:
+ *  the residue so far is moved up a block and the next is added
+ *  (big endian), or each block is scaled by the next power of
+ *  2^(32k) mod m (little endian).  Memory use is constant.
+ *
+ *  Usage:
+ *    bignum_modstream s;
+ *    ER(bignum_modstream_init(&s, m, bignum_big_endian));
+ *    while (more input)
+ *      ER(bignum_modstream_feed(&s, buf, len));
+ *    ER(bignum_modstream_finish(&s, r));
+ *
+ *  The fields are private.  This refers to itself, so must not
+ *  be copied.
+ */
+typedef struct
+{
+  const bignum *m;
+  bignum_endian order;
+  size_t block_bytes, pending_bytes;
+  bignum acc, power, step;
+  uint32_t acc_words[BIGNUM_MAX_WORDS];
+  uint32_t power_words[BIGNUM_MAX_WORDS];
+  uint32_t step_words[BIGNUM_MAX_WORDS];
+  uint8_t pending[BIGNUM_MAX_WORDS / 2 * BIGNUM_BYTES];
+} bignum_modstream;
+
+/** Starts reducing a stream of bytes in the given order mod m.
+ *  m must stay valid until finished.
+ *
+ *  m must be positive, otherwise error_invalid_bignum is returned.
+ *  It may be at most BIGNUM_MAX_WORDS / 2 words, otherwise
+ *  error_bignum_sz is returned. */
+error bignum_modstream_init(bignum_modstream *s, const bignum *m,
+                            bignum_endian order);
+
+/** Continues the stream with buf[:len]. */
+error bignum_modstream_feed(bignum_modstream *s, const uint8_t *buf, size_t len);
+
+/** Sets r to the value of the whole stream mod m.  s may be
+ *  fed further afterwards, to get the residue of a longer stream. */
+error bignum_modstream_finish(bignum_modstream *s, bignum *r);
+
 /** Return a ^ b mod p.
  *
  *  Arguments may alias in any combination. */
@@ -358,4 +680,28 @@ error bignum_extended_gcd(bignum *v, bignum *a, bignum *b,
  *  Arguments may alias in any combination. */
 error bignum_modinv(bignum *z, const bignum *a, const bignum *m);
 
+/** Sets *j to the Jacobi symbol (a/n): one of -1, 0 or 1.
+ *
+ *  When n is prime this is the Legendre symbol, and is 1 if a is
+ *  a non-zero square mod n, -1 if it is not a square.
+ *
+ *  n must be odd and positive, otherwise error_invalid_bignum
+ *  is returned. */
+error bignum_jacobi(int *j, const bignum *a, const bignum *n);
+
+/** Finds r such that r^2 mod p = a.  In other words, find a
+ *  square root of a mod p.  The other root is p - r.
+ *
+ *  p must be an odd prime.  For repeated roots with the same p,
+ *  see bignum_modsqrt_setup in bignum-monty.h.
+ *
+ *  Returns error_no_sqrt if a is not a square mod p.
+ *
+ *  Arguments may alias in any combination. */
+error bignum_modsqrt(bignum *r, const bignum *a, const bignum *p);
+
+#ifdef __cplusplus
+}
+#endif
+
 #endif
@@ -6,6 +6,8 @@
 #include <string.h>
 #include <stdarg.h>
 
+#include "handy.h"
+
 void dstr_init(dstr *d)
 {
   memset(d, 0, sizeof *d);
@@ -17,46 +19,66 @@ void dstr_free(dstr *d)
   dstr_init(d);
 }
 
-/** Size of allocation blocks. Tunable. */
+/** Smallest allocation.  Tunable. */
 #define ALLOC_SIZE 0x200
 
-unsigned require(dstr *d, size_t extra)
+/* Reallocates d to hold at least sz bytes.  Storage grows
+ * geometrically, so appending n bytes costs O(n) overall. */
+static unsigned grow(dstr *d, size_t sz)
 {
-  char *newwr = d->wr + extra;
+  size_t current_offset = dstr_used(d); /* nb. wr pointer is not stable over realloc */
+  size_t current_sz = dstr_allocated(d);
 
-  if (newwr < d->wr)
-    return 1;
+  if (sz <= current_sz)
+    return 0;
 
-  if (newwr + extra > d->end)
+  size_t new_sz = MAX(current_sz, (size_t) ALLOC_SIZE);
+  while (new_sz < sz)
   {
-    size_t current_offset = dstr_used(d); /* nb. wr pointer is not stable over realloc */
-    size_t current_sz = dstr_allocated(d);
-    size_t new_sz = (current_sz + extra + ALLOC_SIZE - 1) / ALLOC_SIZE * ALLOC_SIZE;
-   
     /* overflow? */
-    if (new_sz < current_sz)
-      return 1;
-    
-    /* nb. dstr is still valid if realloc fails. */
-    char *new_start = realloc(d->start, new_sz);
-    if (!new_start)
-      return 1;
-
-    /* clear new memory between offset and end */
-    memset(new_start + current_offset, 0, new_sz - current_offset);
-    d->start = new_start;
-    d->end = new_start + new_sz;
-    d->wr = new_start + current_offset;
+    if (new_sz * 2 < new_sz)
+    {
+      new_sz = sz;
+      break;
+    }
+    new_sz *= 2;
   }
 
+  /* nb. dstr is still valid if realloc fails. */
+  char *new_start = realloc(d->start, new_sz);
+  if (!new_start)
+    return 1;
+
+  /* clear new memory between offset and end */
+  memset(new_start + current_offset, 0, new_sz - current_offset);
+  d->start = new_start;
+  d->end = new_start + new_sz;
+  d->wr = new_start + current_offset;
   return 0;
 }
 
+/* Arranges for at least extra bytes to be available at wr. */
+static unsigned require(dstr *d, size_t extra)
+{
+  size_t used = dstr_used(d);
+
+  /* overflow? */
+  if (used + extra < used)
+    return 1;
+
+  return grow(d, used + extra);
+}
+
 unsigned dstr_expand(dstr *d, size_t want)
 {
   return require(d, want);
 }
 
+unsigned dstr_reserve(dstr *d, size_t len)
+{
+  return grow(d, len);
+}
+
 unsigned dstr_put(dstr *d, const char *buf, size_t len)
 {
   if (require(d, len))
@@ -106,8 +128,8 @@ unsigned dstr_vputf(dstr *d, const char *fmt, va_list ap)
     return 0;
   }
 
-  /* Otherwise, we need available - used more bytes. */
-  if (require(d, available - used))
+  /* Otherwise, we need used bytes, plus the terminator. */
+  if (require(d, used + 1))
     return 1;
 
   /* Now, try the format again. */
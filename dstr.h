@@ -18,6 +18,10 @@
 #include <stdint.h>
 #include <stdarg.h>
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 typedef struct
 {
   /* Start and end of allocated buffer.
@@ -65,10 +69,20 @@ unsigned dstr_puthex(dstr *d, const uint8_t *buf, size_t len);
  *  bytes available for writing. */
 unsigned dstr_expand(dstr *d, size_t len);
 
+/** Arranges for d to have at least len bytes allocated
+ *  in total, so it can be filled to len without reallocating.
+ *
+ *  Storage otherwise grows by doubling. */
+unsigned dstr_reserve(dstr *d, size_t len);
+
 /** Difference between start and end pointers. */
 size_t dstr_allocated(dstr *d);
 
 /** Difference between wr and start pointers. */
 size_t dstr_used(dstr *d);
 
+#ifdef __cplusplus
+}
+#endif
+
 #endif
@@ -13,6 +13,7 @@ SIGNS = (1, -1)
 SIZES = (16, 32, 64, 128, 192, 512, 1024, 2048, )
 SHIFT_SIZES = range(1, 8)
 EXP_SIZES = SIZES[:6]
+ROOT_SIZES = range(1, 6)
 
 def wordsz(n):
     if n == 0:
@@ -63,13 +64,30 @@ def gen_tests(f, function, nargs, op, reject = lambda *x: False, sizesa = SIZES,
             for sz in sizes:
                 gen(sz, can, sg)
 
+# Primes covering each of the modsqrt cases: 3 mod 4, 5 mod 8
+# and 1 mod 8 (with increasing powers of two dividing p - 1).
+SQRT_PRIMES = (7, 13, 17, 41, 97, 65537,
+               2 ** 127 - 1,
+               2 ** 255 - 19,
+               2 ** 224 - 2 ** 96 + 1,
+               2 ** 256 - 2 ** 224 + 2 ** 192 + 2 ** 96 - 1,
+               2 ** 521 - 1)
+
+def gen_modsqrt_tests(f, function):
+    for p in SQRT_PRIMES:
+        for _ in range(TESTS * 2):
+            x = random.randrange(0, p)
+            a = (x * x) % p
+            print >>f, 'check("%s(%d, %d) == %d");' % (function, a, p, min(x, p - x))
+
 def gen_tests_with_file(fout, funcname, *args, **kwargs):
+    generator = kwargs.pop('generator', gen_tests)
     if fout is not None:
-        gen_tests(fout, funcname, *args, **kwargs)
+        generator(fout, funcname, *args, **kwargs)
     else:
         filename = 'test-%s.inc' % funcname
         with open(filename, 'w') as f:
-            gen_tests(f, funcname, *args, **kwargs)
+            generator(f, funcname, *args, **kwargs)
         print filename, 'written.'
 
 def gcd(a, b):
@@ -87,6 +105,42 @@ def gcd_eq_zero(x, m):
     # to modulus
     return gcd(x, m) != 1
 
+def jacobi(a, n):
+    a %= n
+    t = 1
+    while a != 0:
+        while a % 2 == 0:
+            a //= 2
+            if n % 8 in (3, 5):
+                t = -t
+        a, n = n, a
+        if a % 4 == 3 and n % 4 == 3:
+            t = -t
+        a %= n
+    if n == 1:
+        return t
+    return 0
+
+def rootn(a, n):
+    if a < 2:
+        return a
+    x = 1 << ((a.bit_length() + n - 1) // n)
+    while True:
+        y = ((n - 1) * x + a // x ** (n - 1)) // n
+        if y >= x:
+            return x
+        x = y
+
+def sqrt(a):
+    return rootn(a, 2)
+
+def bad_root(a, n):
+    return a < 0 or n < 1
+
+def not_odd_positive(a, n):
+    # jacobi is only defined for odd, positive n
+    return n <= 0 or n % 2 == 0
+
 def modinv(x, m):
     gcd, a, b = egcd(x, m)
     assert gcd == 1
@@ -115,6 +169,10 @@ def emit_tests(fout = None):
     gen_tests_with_file(fout, 'egcd-a', 2, egcd_a)
     gen_tests_with_file(fout, 'egcd-b', 2, egcd_b)
     gen_tests_with_file(fout, 'modinv', 2, modinv, reject = gcd_eq_zero)
+    gen_tests_with_file(fout, 'modsqrt', generator = gen_modsqrt_tests)
+    gen_tests_with_file(fout, 'jacobi', 2, jacobi, reject = not_odd_positive)
+    gen_tests_with_file(fout, 'sqrt', 1, sqrt, reject = lambda a: a < 0)
+    gen_tests_with_file(fout, 'rootn', 2, rootn, reject = bad_root, sizesb = ROOT_SIZES)
 
 if __name__ == '__main__':
     op = optparse.OptionParser()
@@ -18,6 +18,10 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#ifdef __cplusplus
+extern "C" {
+#endif
+
 typedef struct
 {
   char *start, *end;
@@ -55,4 +59,8 @@ unsigned sstr_skip(sstr *s, size_t n);
 /** Difference between start and end pointers. */
 size_t sstr_left(sstr *s);
 
+#ifdef __cplusplus
+}
+#endif
+
 #endif
@@ -4,10 +4,17 @@
 #include <assert.h>
 #include <ctype.h>
 #include <sys/time.h>
+#include <unistd.h>
+#include <pthread.h>
 
 #include "bignum.h"
 #include "bignum-str.h"
+#include "bignum-der.h"
+#include "bignum-monty.h"
+#include "bignum-reduce.h"
+#include "bignum-ec.h"
 #include "bignum-dbg.h"
+#include "handy.h"
 #include "ext/cutest.h"
 
 static bignum bignum_alloc(void)
@@ -17,7 +24,7 @@ static bignum bignum_alloc(void)
   uint32_t *v = malloc(bytes);
   assert(v);
   memset(v, 0, bytes);
-  return (bignum) { v, v, words, 0 };
+  return (bignum) { v, v, words, 0, 0, NULL };
 }
 
 /* Compact heap allocation to improve valgrind sensitivity. */
@@ -31,6 +38,7 @@ static void bignum_compact(bignum *b)
   b->v = new_storage;
   b->vtop = b->v + words - 1;
   b->words = words;
+  b->dirty = MIN(b->dirty, words);
   assert(!bignum_check(b));
 }
 
@@ -241,6 +249,96 @@ static void eval_modinv(bignum *r, const bignum *arg1, const bignum *arg2, const
   assert(err == OK);
 }
 
+/* Returns the smaller root, so tests are deterministic. */
+static void eval_modsqrt(bignum *r, const bignum *arg1, const bignum *arg2, const bignum *arg3)
+{
+  assert(arg1 && arg2 && !arg3);
+  error err = bignum_modsqrt(r, arg1, arg2);
+  assert(err == OK);
+
+  BIGNUM_TMP(other);
+  err = bignum_sub(&other, arg2, r);
+  assert(err == OK);
+  if (bignum_lt(&other, r))
+  {
+    err = bignum_dup(r, &other);
+    assert(err == OK);
+  }
+}
+
+static void eval_jacobi(bignum *r, const bignum *arg1, const bignum *arg2, const bignum *arg3)
+{
+  assert(arg1 && arg2 && !arg3);
+  int j;
+  error err = bignum_jacobi(&j, arg1, arg2);
+  assert(err == OK);
+  bignum_set(r, j);
+}
+
+/* Checks that r ^ n + rem = a and (r + 1) ^ n > a. */
+static void check_root(const bignum *r, const bignum *rem, const bignum *a, unsigned n)
+{
+  BIGNUM_TMP(p);
+  BIGNUM_TMP(tmp);
+  BIGNUM_TMP(r1);
+  error err;
+
+  for (unsigned i = 0; i < 2; i++)
+  {
+    bignum_setu(&p, 1);
+    if (i == 0)
+      err = bignum_dup(&r1, r);
+    else
+      err = bignum_add(&r1, r, &bignum_1);
+    assert(err == OK);
+
+    for (unsigned j = 0; j < n; j++)
+    {
+      err = bignum_mul(&tmp, &p, &r1);
+      assert(err == OK);
+      err = bignum_dup(&p, &tmp);
+      assert(err == OK);
+    }
+
+    if (i == 0)
+    {
+      err = bignum_addl(&p, rem);
+      assert(err == OK);
+      assert(bignum_eq(&p, a));
+    } else {
+      assert(bignum_gt(&p, a));
+    }
+  }
+}
+
+static void eval_sqrt(bignum *r, const bignum *arg1, const bignum *arg2, const bignum *arg3)
+{
+  assert(arg1 && !arg2 && !arg3);
+  BIGNUM_TMP(rem);
+  error err = bignum_sqrt(r, &rem, arg1);
+  assert(err == OK);
+  check_root(r, &rem, arg1, 2);
+}
+
+static void eval_rootn(bignum *r, const bignum *arg1, const bignum *arg2, const bignum *arg3)
+{
+  assert(arg1 && arg2 && !arg3);
+  assert(bignum_len_words(arg2) == 1 && !bignum_is_negative(arg2));
+  BIGNUM_TMP(rem);
+  error err = bignum_rootn(r, &rem, arg1, *arg2->vtop);
+  assert(err == OK);
+  check_root(r, &rem, arg1, *arg2->vtop);
+}
+
+static void eval_ispow(bignum *r, const bignum *arg1, const bignum *arg2, const bignum *arg3)
+{
+  assert(arg1 && !arg2 && !arg3);
+  unsigned result;
+  error err = bignum_is_perfect_power(&result, arg1);
+  assert(err == OK);
+  bignum_setu(r, result);
+}
+
 static void eval_gcd(bignum *r, const bignum *arg1, const bignum *arg2, const bignum *arg3)
 {
   assert(arg1 && arg2 && !arg3);
@@ -309,6 +407,11 @@ static const eval evaluators[] = {
   { "modmul", eval_modmul },
   { "modexp", eval_modexp },
   { "modinv", eval_modinv },
+  { "modsqrt", eval_modsqrt },
+  { "jacobi", eval_jacobi },
+  { "rootn", eval_rootn },
+  { "sqrt", eval_sqrt },
+  { "ispow", eval_ispow },
   { "egcd-v", eval_egcd_v },
   { "egcd-a", eval_egcd_a },
   { "egcd-b", eval_egcd_b },
@@ -469,6 +572,38 @@ static void inequality(void)
   check("1 >= 0");
   check("1 > -1");
   check("1234567890123456789 > 1234567890123456788");
+  check("-4 < -3");
+  check("-3 > -4");
+  check("-4 <= -3");
+  check("-1234567890123456789 < -1234567890123456788");
+
+  BIGNUM_TMP(a);
+  BIGNUM_TMP(b);
+  TEST_CHECK(bignum_parse_str(&a, "-0x100000000") == OK);
+  TEST_CHECK(bignum_parse_str(&b, "0xffffffff") == OK);
+  TEST_CHECK(bignum_cmp(&a, &b) == -1);
+  TEST_CHECK(bignum_cmp(&b, &a) == 1);
+  TEST_CHECK(bignum_cmp(&a, &a) == 0);
+  TEST_CHECK(bignum_mag_cmp(&a, &b) == 1);
+  TEST_CHECK(bignum_mag_cmp(&b, &a) == -1);
+  TEST_CHECK(bignum_mag_cmp(&a, &a) == 0);
+  TEST_CHECK(bignum_cmp(&bignum_neg1, &bignum_0) == -1);
+  TEST_CHECK(bignum_cmp(&bignum_0, &bignum_0) == 0);
+
+  /* Results are canonical, so lengths are exact. */
+  TEST_CHECK(bignum_sub(&a, &b, &b) == OK);
+  TEST_CHECK(bignum_check(&a) == OK && bignum_len_words(&a) == 1);
+  TEST_CHECK(bignum_add(&a, &b, &bignum_1) == OK);
+  TEST_CHECK(bignum_len_words(&a) == 2 && bignum_len_bits(&a) == 33);
+  TEST_CHECK(bignum_sub(&a, &a, &bignum_1) == OK);
+  TEST_CHECK(bignum_len_words(&a) == 1 && bignum_len_bits(&a) == 32);
+
+  /* Storage part way through being written isn't. */
+  TEST_CHECK(bignum_cleartop(&a, 4) == OK);
+  TEST_CHECK(bignum_check(&a) == error_invalid_bignum);
+  TEST_CHECK(bignum_check_storage(&a) == OK);
+  bignum_canon(&a);
+  TEST_CHECK(bignum_check(&a) == OK && bignum_eq(&a, &b));
 }
 
 static void addsign(void)
@@ -479,6 +614,1539 @@ static void addsign(void)
   check("add(-1,1) == 0");
   check("add(-1,2) == 1");
   check("add(-1,-1) == -2");
+
+  /* The sign of r before doesn't matter. */
+  BIGNUM_TMP(r);
+  bignum_set(&r, -1);
+  TEST_CHECK(bignum_sub(&r, &bignum_1, &bignum_neg1) == OK);
+  TEST_CHECK(bignum_eq32(&r, 2));
+}
+
+static void fmt_dec(void)
+{
+  const char *cases[] = {
+    "0",
+    "1",
+    "-1",
+    "9",
+    "10",
+    "999999999",
+    "1000000000",
+    "-1000000001",
+    "4294967295",
+    "4294967296",
+    "18446744073709551616",
+    "100000000000000000000000000000000000000000000000000000000000000",
+    "-123456789012345678901234567890123456789012345678901234567890",
+  };
+  char buf[128];
+
+  bignum b = bignum_alloc();
+
+  for (size_t i = 0; i < ARRAYCOUNT(cases); i++)
+  {
+    TEST_CHECK(bignum_parse_str(&b, cases[i]) == OK);
+    TEST_CHECK(bignum_fmt_dec(&b, buf, sizeof buf) == OK);
+    TEST_CHECK_(strcmp(buf, cases[i]) == 0, "'%s' formatted as '%s'", cases[i], buf);
+    TEST_CHECK(bignum_fmt_dec(&b, buf, strlen(cases[i])) == error_buffer_sz);
+  }
+
+  TEST_CHECK(bignum_parse_str(&b, "12a") == error_invalid_string);
+  TEST_CHECK(bignum_parse_str(&b, "1234567890x") == error_invalid_string);
+
+  bignum_free(&b);
+}
+
+static void fmt_base(void)
+{
+  const struct
+  {
+    unsigned base;
+    const char *str;
+  } cases[] = {
+    { 2, "10010001101000101011001111000100100001010101111001101111011110001000100100010001100110100010001010101011001100111011110001000" },
+    { 3, "1110210002211020111201112221221200000201221102202012102112012200222210102000220" },
+    { 7, "140364251452044004232460113503410631340236356" },
+    { 8, "221505317044125715736104421464212531473610" },
+    { 10, "24197857200151252728892302578581665672" },
+    { 16, "1234567890abcdef1122334455667788" },
+    { 32, "i6hb7h45bpnnh28hj8hamcts8" },
+    { 36, "12srde1xpfeunn62ic3gkzr0o" },
+  };
+  char buf[256];
+
+  bignum a = bignum_alloc();
+  bignum b = bignum_alloc();
+
+  TEST_CHECK(bignum_parse_str(&a, "0x1234567890abcdef1122334455667788") == OK);
+
+  for (size_t i = 0; i < ARRAYCOUNT(cases); i++)
+  {
+    const char *str = cases[i].str;
+    unsigned base = cases[i].base;
+
+    TEST_CHECK(bignum_fmt_base(&a, base, buf, sizeof buf) == OK);
+    TEST_CHECK_(strcmp(buf, str) == 0, "base %u formatted as '%s'", base, buf);
+    TEST_CHECK(bignum_fmt_base(&a, base, buf, strlen(str)) == error_buffer_sz);
+
+    TEST_CHECK(bignum_parse_base(&b, str, strlen(str), base) == OK);
+    TEST_CHECK_(bignum_eq(&a, &b), "base %u does not parse", base);
+
+    /* Negated, and with leading zeroes. */
+    buf[0] = '-';
+    buf[1] = '0';
+    strcpy(buf + 2, str);
+    TEST_CHECK(bignum_parse_base(&b, buf, strlen(buf), base) == OK);
+    bignum_neg(&b);
+    TEST_CHECK_(bignum_eq(&a, &b), "base %u does not parse negative", base);
+  }
+
+  /* Every base round trips, including zero. */
+  for (unsigned base = 2; base <= 36; base++)
+  {
+    for (unsigned neg = 0; neg < 2; neg++)
+    {
+      TEST_CHECK(bignum_parse_str(&a, neg ? "-0x1f2e3d4c5b6a798800000000ffffffff01" : "0") == OK);
+      TEST_CHECK(bignum_fmt_base(&a, base, buf, sizeof buf) == OK);
+      TEST_CHECK(bignum_parse_base(&b, buf, strlen(buf), base) == OK);
+      TEST_CHECK_(bignum_eq(&a, &b), "'%s' does not round trip in base %u", buf, base);
+    }
+  }
+
+  TEST_CHECK(bignum_fmt_base(&bignum_0, 2, buf, sizeof buf) == OK);
+  TEST_CHECK(strcmp(buf, "0") == 0);
+
+  TEST_CHECK(bignum_parse_base(&b, "ZZ", 2, 36) == OK);
+  TEST_CHECK(bignum_eq32(&b, 1295));
+  TEST_CHECK(bignum_parse_base(&b, "12", 2, 2) == error_invalid_string);
+  TEST_CHECK(bignum_parse_base(&b, "8", 1, 8) == error_invalid_string);
+  TEST_CHECK(bignum_parse_base(&b, "g", 1, 16) == error_invalid_string);
+  TEST_CHECK(bignum_parse_base(&b, "a", 1, 10) == error_invalid_string);
+  TEST_CHECK(bignum_parse_str(&b, "0x12g4") == error_invalid_string);
+
+  /* Hex which is too wide, unless it's just leading zeroes. */
+  static char wide[BIGNUM_MAX_WORDS * 8 + 1];
+  memset(wide, '1', sizeof wide);
+  TEST_CHECK(bignum_parse_base(&b, wide, sizeof wide, 16) == error_bignum_sz);
+  memset(wide, '0', sizeof wide);
+  wide[sizeof wide - 1] = '7';
+  TEST_CHECK(bignum_parse_base(&b, wide, sizeof wide, 16) == OK);
+  TEST_CHECK(bignum_eq32(&b, 7));
+
+  bignum_free(&a);
+  bignum_free(&b);
+}
+
+/* Checks bulk hex conversion at every length, against the
+ * words themselves. */
+static void fmt_hex_words(void)
+{
+  static char buf[BIGNUM_MAX_WORDS * 8 + 4];
+  uint32_t seed = 0x9abcdef0;
+
+  bignum b = bignum_alloc();
+  bignum c = bignum_alloc();
+
+  for (size_t words = 1; words <= 72; words++)
+  {
+    bignum_setu(&b, 0);
+    TEST_CHECK(bignum_cleartop(&b, words) == OK);
+    for (size_t i = 0; i < words; i++)
+    {
+      seed = seed * 1103515245 + 12345;
+      b.v[i] = seed ^ (seed << 13);
+    }
+    b.v[words - 1] |= 0x10000000;
+
+    TEST_CHECK(bignum_fmt_hex(&b, buf, sizeof buf) == OK);
+    TEST_CHECK(strlen(buf) == 2 + words * 8);
+
+    unsigned same = 1;
+    for (size_t i = 0; i < words * 8; i++)
+    {
+      unsigned nibble = (b.v[words - 1 - i / 8] >> (28 - 4 * (i % 8))) & 0xf;
+      same &= buf[2 + i] == "0123456789abcdef"[nibble];
+    }
+    TEST_CHECK_(same, "%zu word hex differs", words);
+
+    /* Upper case parses the same. */
+    for (char *p = buf + 2; *p; p++)
+      if (*p >= 'a')
+        *p -= 0x20;
+
+    TEST_CHECK(bignum_parse_str(&c, buf) == OK);
+    TEST_CHECK_(bignum_eq(&b, &c), "%zu word hex does not round trip", words);
+
+    /* A bad character anywhere is noticed. */
+    for (size_t i = 2; i < 2 + words * 8; i++)
+    {
+      char good = buf[i];
+      buf[i] = "g/:@G`\x80"[i % 7];
+      TEST_CHECK_(bignum_parse_str(&c, buf) == error_invalid_string,
+                  "%zu word hex with bad character at %zu", words, i);
+      buf[i] = good;
+    }
+  }
+
+  bignum_free(&b);
+  bignum_free(&c);
+}
+
+static void bytes(void)
+{
+  const uint8_t be[] = { 0x00, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09 };
+  const uint8_t le[] = { 0x09, 0x08, 0x07, 0x06, 0x05, 0x04, 0x03, 0x02, 0x01, 0x00, 0x00 };
+  uint8_t buf[64];
+
+  bignum a = bignum_alloc();
+  bignum b = bignum_alloc();
+
+  TEST_CHECK(bignum_parse_str(&a, "0x010203040506070809") == OK);
+
+  TEST_CHECK(bignum_from_bytes(&b, be, sizeof be, bignum_big_endian) == OK);
+  TEST_CHECK(bignum_eq(&a, &b));
+  TEST_CHECK(bignum_from_bytes(&b, le, sizeof le, bignum_little_endian) == OK);
+  TEST_CHECK(bignum_eq(&a, &b));
+
+  /* Padded, and minimal. */
+  TEST_CHECK(bignum_to_bytes(&a, buf, sizeof be, bignum_big_endian) == OK);
+  TEST_CHECK(memcmp(buf, be, sizeof be) == 0);
+  TEST_CHECK(bignum_to_bytes(&a, buf, sizeof le, bignum_little_endian) == OK);
+  TEST_CHECK(memcmp(buf, le, sizeof le) == 0);
+  TEST_CHECK(bignum_len_bytes(&a) == 9);
+  TEST_CHECK(bignum_to_bytes(&a, buf, 9, bignum_big_endian) == OK);
+  TEST_CHECK(memcmp(buf, be + 2, 9) == 0);
+  TEST_CHECK(bignum_to_bytes(&a, buf, 8, bignum_big_endian) == error_buffer_sz);
+  TEST_CHECK(bignum_to_bytes(&a, buf, 8, bignum_little_endian) == error_buffer_sz);
+
+  /* Zero, and the sign is ignored. */
+  TEST_CHECK(bignum_from_bytes(&b, be, 2, bignum_big_endian) == OK);
+  TEST_CHECK(bignum_is_zero(&b));
+  TEST_CHECK(bignum_from_bytes(&b, be, 0, bignum_little_endian) == OK);
+  TEST_CHECK(bignum_is_zero(&b));
+  TEST_CHECK(bignum_to_bytes(&b, buf, 1, bignum_big_endian) == OK && buf[0] == 0);
+  TEST_CHECK(bignum_to_bytes(&b, buf, 0, bignum_big_endian) == error_buffer_sz);
+  TEST_CHECK(bignum_to_bytes(&bignum_neg1, buf, 1, bignum_big_endian) == OK && buf[0] == 1);
+
+  /* Every length and order round trips, through both byte orders. */
+  for (size_t len = 1; len <= sizeof buf; len++)
+  {
+    uint8_t in[sizeof buf], out[sizeof buf];
+    for (size_t i = 0; i < len; i++)
+      in[i] = (uint8_t) (i * 37 + len + 1);
+
+    TEST_CHECK(bignum_from_bytes(&a, in, len, bignum_big_endian) == OK);
+    TEST_CHECK(bignum_len_bytes(&a) == len);
+    TEST_CHECK(bignum_get_byte(&a, 0) == in[len - 1]);
+    TEST_CHECK(bignum_to_bytes(&a, out, len, bignum_little_endian) == OK);
+    for (size_t i = 0; i < len; i++)
+      TEST_CHECK_(out[i] == in[len - 1 - i], "%zu byte reversal differs at %zu", len, i);
+
+    TEST_CHECK(bignum_from_bytes(&b, out, len, bignum_little_endian) == OK);
+    TEST_CHECK_(bignum_eq(&a, &b), "%zu bytes do not round trip", len);
+    TEST_CHECK(bignum_to_bytes(&b, out, len, bignum_big_endian) == OK);
+    TEST_CHECK(memcmp(in, out, len) == 0);
+  }
+
+  /* Too big for the destination. */
+  bignum small = { (uint32_t *) buf, (uint32_t *) buf, 2, 0, 0, NULL };
+  TEST_CHECK(bignum_from_bytes(&small, be, sizeof be, bignum_big_endian) == error_bignum_sz);
+  TEST_CHECK(bignum_from_bytes(&small, be + 3, sizeof be - 3, bignum_big_endian) == OK);
+
+  /* No-copy views. */
+  uint32_t words[3] = { 0, 0, 0 };
+  TEST_CHECK(bignum_to_bytes(&a, (uint8_t *) words, sizeof words, bignum_little_endian) == error_buffer_sz);
+  TEST_CHECK(bignum_parse_str(&a, "0x1122334455667788") == OK);
+  TEST_CHECK(bignum_to_bytes(&a, (uint8_t *) words, sizeof words, bignum_little_endian) == OK);
+
+  bignum view;
+  uint16_t one = 1;
+  if (*(uint8_t *) &one == 1)
+  {
+    TEST_CHECK(bignum_view_bytes_le(&view, (uint8_t *) words, sizeof words) == OK);
+    TEST_CHECK(bignum_eq(&a, &view));
+    TEST_CHECK(bignum_len_words(&view) == 2);
+    TEST_CHECK(bignum_view_bytes_le(&view, (uint8_t *) words + 1, 8) == error_invalid_bignum);
+    TEST_CHECK(bignum_view_bytes_le(&view, (uint8_t *) words, 6) == error_invalid_bignum);
+    TEST_CHECK(bignum_view_bytes_le(&view, (uint8_t *) words, 0) == error_invalid_bignum);
+  }
+
+  bignum_free(&a);
+  bignum_free(&b);
+}
+
+static void der_integer(void)
+{
+  const struct
+  {
+    const char *value;
+    size_t len;
+    const char *der;
+  } cases[] = {
+    { "0", 3, "\x02\x01\x00" },
+    { "127", 3, "\x02\x01\x7f" },
+    { "128", 4, "\x02\x02\x00\x80" },
+    { "256", 4, "\x02\x02\x01\x00" },
+    { "-1", 3, "\x02\x01\xff" },
+    { "-128", 3, "\x02\x01\x80" },
+    { "-129", 4, "\x02\x02\xff\x7f" },
+    { "-256", 4, "\x02\x02\xff\x00" },
+    { "-32768", 4, "\x02\x02\x80\x00" },
+    { "-32769", 5, "\x02\x03\xff\x7f\xff" },
+    { "-0x100000000", 7, "\x02\x05\xff\x00\x00\x00\x00" },
+    { "0x80000000", 7, "\x02\x05\x00\x80\x00\x00\x00" },
+  };
+  uint8_t buf[600];
+  size_t used;
+
+  bignum a = bignum_alloc();
+  bignum b = bignum_alloc();
+
+  for (size_t i = 0; i < ARRAYCOUNT(cases); i++)
+  {
+    TEST_CHECK(bignum_parse_str(&a, cases[i].value) == OK);
+    TEST_CHECK(bignum_der_integer_len(&a) == cases[i].len);
+    TEST_CHECK(bignum_der_encode_integer(&a, buf, sizeof buf, &used) == OK);
+    TEST_CHECK_(used == cases[i].len && memcmp(buf, cases[i].der, used) == 0,
+                "%s encodes wrongly", cases[i].value);
+    TEST_CHECK(bignum_der_encode_integer(&a, buf, cases[i].len - 1, &used) == error_buffer_sz);
+
+    TEST_CHECK(bignum_der_decode_integer(&b, (const uint8_t *) cases[i].der, cases[i].len, &used) == OK);
+    TEST_CHECK(used == cases[i].len);
+    TEST_CHECK_(bignum_eq(&a, &b), "%s decodes wrongly", cases[i].value);
+    TEST_CHECK(bignum_der_decode_integer(&b, (const uint8_t *) cases[i].der, cases[i].len - 1, &used) == error_invalid_string);
+  }
+
+  /* Long and short form lengths, through a dstr. */
+  const char *longs[] = {
+    "0x8000000000000000000000000000000000000000000000000000000000000000"
+      "0000000000000000000000000000000000000000000000000000000000000000"
+      "0000000000000000000000000000000000000000000000000000000000000000"
+      "0000000000000000000000000000000000000000000000000000000000000000",
+    "-0x8000000000000000000000000000000000000000000000000000000000000000"
+      "0000000000000000000000000000000000000000000000000000000000000001",
+    "-0x8000000000000000000000000000000000000000000000000000000000000000"
+      "0000000000000000000000000000000000000000000000000000000000000000"
+      "0000000000000000000000000000000000000000000000000000000000000000"
+      "0000000000000000000000000000000000000000000000000000000000000000",
+  };
+  const size_t long_lens[] = { 1 + 2 + 129, 1 + 1 + 65, 1 + 2 + 128 };
+
+  dstr d;
+  dstr_init(&d);
+
+  for (size_t i = 0; i < ARRAYCOUNT(longs); i++)
+  {
+    TEST_CHECK(bignum_parse_str(&a, longs[i]) == OK);
+    TEST_CHECK(bignum_der_encode_integer_dstr(&a, &d) == OK);
+    TEST_CHECK(bignum_der_integer_len(&a) == long_lens[i]);
+  }
+
+  const uint8_t *p = (const uint8_t *) d.start;
+  for (size_t i = 0; i < ARRAYCOUNT(longs); i++)
+  {
+    TEST_CHECK(bignum_parse_str(&a, longs[i]) == OK);
+    TEST_CHECK(bignum_der_decode_integer(&b, p, (const uint8_t *) d.wr - p, &used) == OK);
+    TEST_CHECK(used == long_lens[i]);
+    TEST_CHECK_(bignum_eq(&a, &b), "long %zu does not round trip", i);
+    p += used;
+  }
+  TEST_CHECK(p == (const uint8_t *) d.wr);
+  dstr_free(&d);
+
+  /* Bad encodings. */
+  const struct
+  {
+    size_t len;
+    const char *der;
+  } bad[] = {
+    { 0, "" },
+    { 2, "\x02\x00" },
+    { 3, "\x03\x01\x00" },
+    { 4, "\x02\x02\x00\x7f" },
+    { 4, "\x02\x02\xff\x80" },
+    { 3, "\x02\x80\x00" },
+    { 4, "\x02\x81\x01\x00" },
+    { 5, "\x02\x82\x00\x01\x00" },
+    { 4, "\x02\x81\x80\x00" },
+  };
+
+  for (size_t i = 0; i < ARRAYCOUNT(bad); i++)
+    TEST_CHECK_(bignum_der_decode_integer(&b, (const uint8_t *) bad[i].der, bad[i].len, NULL) == error_invalid_string,
+                "bad case %zu accepted", i);
+
+  /* Too big for r. */
+  bignum small = { (uint32_t *) buf, (uint32_t *) buf, 1, 0, 0, NULL };
+  TEST_CHECK(bignum_der_decode_integer(&small, (const uint8_t *) "\x02\x05\x00\x80\x00\x00\x00", 7, NULL) == OK);
+  TEST_CHECK(bignum_der_decode_integer(&small, (const uint8_t *) "\x02\x05\xff\x00\x00\x00\x00", 7, NULL) == error_bignum_sz);
+
+  bignum_free(&a);
+  bignum_free(&b);
+}
+
+static unsigned count_sink(void *ctx, const char *buf, size_t len)
+{
+  dstr *d = ctx;
+  return len == 0 || dstr_put(d, buf, len);
+}
+
+static unsigned failing_sink(void *ctx, const char *buf, size_t len)
+{
+  return 1;
+}
+
+/* Checks the sink formatters against the buffer ones, at the
+ * longest decimal for each bit length. */
+static void fmt_sinks(void)
+{
+  static char buf[4096];
+  bignum b = bignum_alloc();
+
+  for (size_t bits = 1; bits < (BIGNUM_MAX_WORDS - 1) * BIGNUM_BITS; bits += 13)
+  {
+    bignum_setu(&b, 1);
+    TEST_CHECK(bignum_shl(&b, bits) == OK);
+    TEST_CHECK(bignum_subl(&b, &bignum_1) == OK);
+    if (bits % 2)
+      bignum_neg(&b);
+
+    dstr d, e;
+    dstr_init(&d);
+    dstr_init(&e);
+    bignum_sink sink = { count_sink, &e };
+
+    TEST_CHECK(bignum_fmt_dec(&b, buf, sizeof buf) == OK);
+    TEST_CHECK(bignum_fmt_dec_dstr(&b, &d) == OK);
+    TEST_CHECK(bignum_fmt_dec_sink(&b, &sink) == OK);
+    TEST_CHECK_(dstr_used(&d) == strlen(buf) && memcmp(d.start, buf, strlen(buf)) == 0,
+                "%zu bit decimal differs in dstr", bits);
+    TEST_CHECK(dstr_used(&e) == strlen(buf) && memcmp(e.start, buf, strlen(buf)) == 0);
+
+    dstr_free(&d);
+    dstr_free(&e);
+
+    TEST_CHECK(bignum_fmt_hex(&b, buf, sizeof buf) == OK);
+    TEST_CHECK(bignum_fmt_hex_dstr(&b, &d) == OK);
+    TEST_CHECK(bignum_fmt_hex_sink(&b, &sink) == OK);
+    TEST_CHECK_(dstr_used(&d) == strlen(buf) && memcmp(d.start, buf, strlen(buf)) == 0,
+                "%zu bit hex differs in dstr", bits);
+    TEST_CHECK(dstr_used(&e) == strlen(buf) && memcmp(e.start, buf, strlen(buf)) == 0);
+
+    dstr_free(&d);
+    dstr_free(&e);
+  }
+
+  /* Appending. */
+  dstr d;
+  dstr_init(&d);
+  TEST_CHECK(dstr_puts(&d, "x = ") == 0);
+  TEST_CHECK(bignum_fmt_dec_dstr(&bignum_neg1, &d) == OK);
+  TEST_CHECK(dstr_puts(&d, ", y = ") == 0);
+  TEST_CHECK(bignum_fmt_hex_dstr(&bignum_base, &d) == OK);
+  TEST_CHECK(dstr_put0(&d) == 0);
+  TEST_CHECK(strcmp(d.start, "x = -1, y = 0x0100000000") == 0);
+  dstr_free(&d);
+
+  bignum_sink fail = { failing_sink, NULL };
+  TEST_CHECK(bignum_fmt_dec_sink(&bignum_1, &fail) == error_io);
+
+  FILE *f = tmpfile();
+  TEST_CHECK(f != NULL);
+  TEST_CHECK(bignum_fmt_hex_file(&bignum_base, f) == OK);
+  TEST_CHECK(bignum_fmt_dec_file(&bignum_neg1, f) == OK);
+  rewind(f);
+  TEST_CHECK(fgets(buf, sizeof buf, f) != NULL);
+  TEST_CHECK(strcmp(buf, "0x0100000000-1") == 0);
+  fclose(f);
+
+  /* Long enough for a loose digit count to come up short:
+   * 2^217769 - 1 has 65556 digits.  Chunked conversion writes
+   * every one of them. */
+  size_t old_threshold = bignum_dec_dc_threshold;
+  bignum_dec_dc_threshold = SIZE_MAX;
+
+  bignum big;
+  TEST_CHECK(bignum_init_growable(&big, 1, NULL) == OK);
+  bignum_setu(&big, 1);
+  TEST_CHECK(bignum_shl(&big, 217769) == OK);
+  TEST_CHECK(bignum_subl(&big, &bignum_1) == OK);
+
+  dstr_init(&d);
+  TEST_CHECK(bignum_fmt_dec_dstr(&big, &d) == OK);
+  TEST_CHECK(dstr_used(&d) == 65556);
+  dstr_free(&d);
+  bignum_clear(&big);
+
+  bignum_dec_dc_threshold = old_threshold;
+
+  bignum_free(&b);
+}
+
+static void count_progress(void *ctx, uint64_t done, uint64_t total)
+{
+  uint64_t *last = ctx;
+  TEST_CHECK(done > last[0]);
+  TEST_CHECK(total == last[1]);
+  last[0] = done;
+}
+
+/* Checks the incremental parser agrees with bignum_parse_strl,
+ * however the input is split. */
+static void parse_stream(void)
+{
+  const char *cases[] = {
+    "0",
+    "-0",
+    "",
+    "0x",
+    "1",
+    "-1",
+    "00000000000000000000000001",
+    "123456789",
+    "1234567890",
+    "-0x1",
+    "0x0000000000000000000000000000000000000000000000000123",
+    "0x12345678",
+    "0x123456789",
+    "-0xfedcba9876543210FEDCBA9876543210f",
+    "-123456789012345678901234567890123456789012345678901234567890",
+  };
+
+  bignum a = bignum_alloc();
+  bignum b = bignum_alloc();
+
+  for (size_t i = 0; i < ARRAYCOUNT(cases); i++)
+  {
+    const char *str = cases[i];
+    size_t len = strlen(str);
+    TEST_CHECK(bignum_parse_str(&a, str) == OK);
+
+    for (size_t step = 1; step <= len + 1; step++)
+    {
+      bignum_parser p;
+      bignum_parser_init(&p, &b);
+      for (size_t at = 0; at < len; at += step)
+        TEST_CHECK(bignum_parser_feed(&p, str + at, MIN(step, len - at)) == OK);
+      TEST_CHECK(bignum_parser_feed(&p, "\n", 1) == OK);
+      TEST_CHECK(bignum_parser_finish(&p) == OK);
+      TEST_CHECK_(bignum_eq(&a, &b) && bignum_getsign(&a) == bignum_getsign(&b),
+                  "'%s' in steps of %zu differs", str, step);
+    }
+  }
+
+  const char *bad[] = { "12a", "0x12g", "1 2", "--1", "0x-1", "1-" };
+  for (size_t i = 0; i < ARRAYCOUNT(bad); i++)
+  {
+    bignum_parser p;
+    bignum_parser_init(&p, &b);
+    TEST_CHECK_(bignum_parser_feed(&p, bad[i], strlen(bad[i])) == error_invalid_string,
+                "'%s' accepted", bad[i]);
+    TEST_CHECK(bignum_parser_finish(&p) == error_invalid_string);
+  }
+
+  /* The largest hex, then one and nine digits too many. */
+  static char wide[2 + BIGNUM_MAX_WORDS * 8 + 8];
+  memset(wide, 'f', sizeof wide);
+  wide[0] = '0';
+  wide[1] = 'x';
+  bignum_parser p;
+  bignum_parser_init(&p, &b);
+  TEST_CHECK(bignum_parser_feed(&p, wide, sizeof wide - 8) == OK);
+  TEST_CHECK(bignum_parser_finish(&p) == OK);
+  TEST_CHECK(bignum_len_bits(&b) == BIGNUM_MAX_WORDS * BIGNUM_BITS);
+  bignum_parser_init(&p, &b);
+  TEST_CHECK(bignum_parser_feed(&p, wide, sizeof wide - 7) == OK);
+  TEST_CHECK(bignum_parser_finish(&p) == error_bignum_sz);
+  bignum_parser_init(&p, &b);
+  TEST_CHECK(bignum_parser_feed(&p, wide, sizeof wide) == error_bignum_sz);
+
+  /* From a file, by read and mmap. */
+  static char dec[2400];
+  TEST_CHECK(bignum_parse_str(&a, "-0x123456789abcdef") == OK);
+  TEST_CHECK(bignum_shl(&a, 7000) == OK);
+  TEST_CHECK(bignum_fmt_dec(&a, dec, sizeof dec) == OK);
+
+  FILE *f = tmpfile();
+  TEST_CHECK(f != NULL);
+  for (size_t i = 0; i < BIGNUM_PARSE_WINDOW; i++)
+    fputc('0', f);
+  fputs(dec + 1, f);
+  fputs("\r\n", f);
+  fflush(f);
+  bignum_neg(&a);
+
+  uint64_t size = BIGNUM_PARSE_WINDOW + strlen(dec + 1) + 2;
+  uint64_t last[2] = { 0, size };
+  bignum_progress progress = { count_progress, last };
+
+  rewind(f);
+  TEST_CHECK(bignum_parse_fd(&b, fileno(f), &progress) == OK);
+  TEST_CHECK(bignum_eq(&a, &b));
+  TEST_CHECK(last[0] == size);
+
+  last[0] = 0;
+  TEST_CHECK(bignum_parse_mmap(&b, fileno(f), &progress) == OK);
+  TEST_CHECK(bignum_eq(&a, &b));
+  TEST_CHECK(last[0] == size);
+
+  fseek(f, 0, SEEK_END);
+  fputs("x", f);
+  fflush(f);
+  TEST_CHECK(bignum_parse_mmap(&b, fileno(f), NULL) == error_invalid_string);
+  fclose(f);
+
+  /* A pipe has no size. */
+  int fds[2];
+  TEST_CHECK(pipe(fds) == 0);
+  TEST_CHECK(write(fds[1], "0x1234\n", 7) == 7);
+  close(fds[1]);
+  last[0] = 0;
+  last[1] = 0;
+  TEST_CHECK(bignum_parse_fd(&b, fds[0], &progress) == OK);
+  TEST_CHECK(bignum_eq32(&b, 0x1234));
+  TEST_CHECK(bignum_parse_mmap(&b, fds[0], NULL) == error_io);
+  close(fds[0]);
+
+  bignum_free(&a);
+  bignum_free(&b);
+}
+
+static void feed_in_pieces(bignum_modstream *s, const uint8_t *buf, size_t len, size_t piece)
+{
+  for (size_t at = 0; at < len; at += piece)
+    TEST_CHECK(bignum_modstream_feed(s, buf + at, MIN(piece, len - at)) == OK);
+}
+
+static void modstream(void)
+{
+  static uint8_t data[1 << 16], reversed[1 << 16];
+  const char *moduli[] = {
+    "1",
+    "2",
+    "0xfffffffb",
+    "0x100000000",
+    "0xffffffff00000001",
+    "0x7fffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff",
+    "1000000000000000000000000000000000000000000000000000000000000000000000007",
+  };
+
+  uint32_t seed = 0x31415926;
+  for (size_t i = 0; i < sizeof data; i++)
+  {
+    seed = seed * 1103515245 + 12345;
+    data[i] = seed >> 16;
+    reversed[sizeof data - 1 - i] = data[i];
+  }
+
+  bignum m = bignum_alloc();
+  bignum x = bignum_alloc();
+  bignum want = bignum_alloc();
+  bignum got = bignum_alloc();
+  bignum_modstream s;
+
+  for (size_t i = 0; i < ARRAYCOUNT(moduli); i++)
+  {
+    TEST_CHECK(bignum_parse_str(&m, moduli[i]) == OK);
+
+    /* Short streams, against reducing the whole number. */
+    for (size_t len = 0; len < 300; len += 7)
+    {
+      TEST_CHECK(bignum_from_bytes(&x, data, len, bignum_big_endian) == OK);
+      TEST_CHECK(bignum_mod(&want, &x, &m) == OK);
+
+      TEST_CHECK(bignum_modstream_init(&s, &m, bignum_big_endian) == OK);
+      feed_in_pieces(&s, data, len, 1 + len % 5);
+      TEST_CHECK(bignum_modstream_finish(&s, &got) == OK);
+      TEST_CHECK_(bignum_eq(&want, &got), "%zu bytes big endian mod %s", len, moduli[i]);
+
+      TEST_CHECK(bignum_modstream_init(&s, &m, bignum_little_endian) == OK);
+      feed_in_pieces(&s, reversed + sizeof data - len, len, 1 + len % 11);
+      TEST_CHECK(bignum_modstream_finish(&s, &got) == OK);
+      TEST_CHECK_(bignum_eq(&want, &got), "%zu bytes little endian mod %s", len, moduli[i]);
+    }
+
+    /* Long streams: both orders agree, and finishing early
+     * doesn't disturb anything. */
+    TEST_CHECK(bignum_modstream_init(&s, &m, bignum_big_endian) == OK);
+    feed_in_pieces(&s, data, sizeof data / 2, 1000);
+    TEST_CHECK(bignum_modstream_finish(&s, &got) == OK);
+    feed_in_pieces(&s, data + sizeof data / 2, sizeof data / 2, 999);
+    TEST_CHECK(bignum_modstream_finish(&s, &want) == OK);
+
+    TEST_CHECK(bignum_modstream_init(&s, &m, bignum_little_endian) == OK);
+    feed_in_pieces(&s, reversed, sizeof data, 4093);
+    TEST_CHECK(bignum_modstream_finish(&s, &got) == OK);
+    TEST_CHECK_(bignum_eq(&want, &got), "long stream mod %s", moduli[i]);
+    TEST_CHECK(bignum_lt(&got, &m));
+  }
+
+  /* And against a word-sized reduction done by hand. */
+  uint64_t residue = 0;
+  for (size_t i = 0; i < sizeof data; i++)
+    residue = ((residue << 8) | data[i]) % 0xfffffffb;
+
+  TEST_CHECK(bignum_parse_str(&m, "0xfffffffb") == OK);
+  TEST_CHECK(bignum_modstream_init(&s, &m, bignum_big_endian) == OK);
+  feed_in_pieces(&s, data, sizeof data, sizeof data);
+  TEST_CHECK(bignum_modstream_finish(&s, &got) == OK);
+  TEST_CHECK(bignum_len_words(&got) == 1 && got.v[0] == residue);
+
+  TEST_CHECK(bignum_modstream_init(&s, &bignum_0, bignum_big_endian) == error_invalid_bignum);
+  TEST_CHECK(bignum_modstream_init(&s, &bignum_neg1, bignum_big_endian) == error_invalid_bignum);
+  bignum_setu(&m, 1);
+  TEST_CHECK(bignum_shl(&m, BIGNUM_MAX_WORDS / 2 * BIGNUM_BITS) == OK);
+  TEST_CHECK(bignum_modstream_init(&s, &m, bignum_big_endian) == error_bignum_sz);
+  TEST_CHECK(bignum_shr(&m, 1) == OK);
+  TEST_CHECK(bignum_modstream_init(&s, &m, bignum_big_endian) == OK);
+
+  bignum_free(&m);
+  bignum_free(&x);
+  bignum_free(&want);
+  bignum_free(&got);
+}
+
+static void *modexp_thread(void *arg)
+{
+  error *err = arg;
+  BIGNUM_TMP_SZ(r, 64);
+  BIGNUM_TMP_SZ(m, 64);
+
+  *err = bignum_parse_str(&m, "0xfffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff"
+                              "fffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff61");
+  if (!*err)
+    *err = bignum_modexp(&r, &bignum_base, &m, &m);
+  return NULL;
+}
+
+static error scratch_user(size_t words)
+{
+  BIGNUM_SCRATCH(a, words);
+  BIGNUM_SCRATCH(b, words);
+  TEST_CHECK(b.v == a.v + words);
+  TEST_CHECK(bignum_is_zero(&a) && bignum_is_zero(&b));
+  return OK;
+}
+
+static void scratch(void)
+{
+  uint32_t words[100];
+  bignum_arena small;
+  bignum_arena_init(&small, words, 100);
+
+  /* Allocation, release at scope end, and exhaustion. */
+  bignum_arena *def = bignum_arena_thread();
+  bignum_arena *prev = bignum_arena_use(&small);
+  TEST_CHECK(scratch_user(50) == OK);
+  TEST_CHECK(small.top == words);
+  TEST_CHECK(scratch_user(51) == error_bignum_sz);
+  TEST_CHECK(small.top == words);
+
+  bignum_arena_mark mark = bignum_arena_save(&small);
+  bignum x;
+  TEST_CHECK(bignum_arena_alloc(&small, &x, 1000) == error_bignum_sz);
+  TEST_CHECK(bignum_arena_alloc(&small, &x, 60) == OK);
+  TEST_CHECK(x.words == 60 && bignum_is_zero(&x));
+  bignum_setu(&x, 0x12345678);
+  bignum_arena_restore_clean(&mark);
+  TEST_CHECK(small.top == words && words[0] == 0);
+
+  /* Library functions fail cleanly when out of space. */
+  bignum a = bignum_alloc();
+  TEST_CHECK(bignum_parse_str(&a, "-12345678901234567890123456789012345678901234567890") == OK);
+  bignum_arena_init(&small, words, 2);
+  TEST_CHECK(bignum_mod(&a, &a, &bignum_base) == error_bignum_sz);
+  bignum_free(&a);
+
+  TEST_CHECK(bignum_arena_use(prev) == &small);
+  TEST_CHECK(bignum_arena_thread() == def);
+
+  /* A 1024-bit modexp on a 64KB stack. */
+  pthread_attr_t attr;
+  pthread_t thread;
+  error err = error_invalid_bignum;
+  TEST_CHECK(pthread_attr_init(&attr) == 0);
+  TEST_CHECK(pthread_attr_setstacksize(&attr, 64 * 1024) == 0);
+  TEST_CHECK(pthread_create(&thread, &attr, modexp_thread, &err) == 0);
+  TEST_CHECK(pthread_join(thread, NULL) == 0);
+  TEST_CHECK(err == OK);
+  pthread_attr_destroy(&attr);
+}
+
+static void dirty(void)
+{
+  BIGNUM_TMP_SZ(x, 8);
+  x_words[7] = 0x55555555;
+
+  TEST_CHECK(x.dirty == 1);
+  TEST_CHECK(bignum_parse_str(&x, "0x123456789abcdef0123") == OK);
+  TEST_CHECK(x.dirty == 3);
+
+  /* Smaller values don't lower the mark, and nothing above it is
+   * touched. */
+  bignum_setu(&x, 5);
+  TEST_CHECK(x.dirty == 3);
+  TEST_CHECK(bignum_get_byte(&x, 4) == 0);
+  TEST_CHECK(bignum_dup(&x, &bignum_base) == OK);
+  TEST_CHECK(bignum_add(&x, &x, &bignum_1) == OK);
+  TEST_CHECK(x.dirty == 3);
+  TEST_CHECK(x_words[7] == 0x55555555);
+
+  bignum_clear(&x);
+  TEST_CHECK(x_words[0] == 0 && x_words[1] == 0 && x_words[2] == 0);
+  TEST_CHECK(x_words[7] == 0x55555555);
+}
+
+typedef struct
+{
+  size_t live, allocs;
+} counting;
+
+static void *counting_alloc(void *ctx, size_t bytes)
+{
+  counting *c = ctx;
+  c->live += bytes;
+  c->allocs++;
+  return malloc(bytes);
+}
+
+static void counting_free(void *ctx, void *ptr, size_t bytes)
+{
+  counting *c = ctx;
+  c->live -= bytes;
+  free(ptr);
+}
+
+static void growable(void)
+{
+  counting count = { 0, 0 };
+  bignum_allocator alloc = { counting_alloc, counting_free, &count };
+  bignum a, b, r, q;
+
+  TEST_CHECK(bignum_init_growable(&a, 1, &alloc) == OK);
+  TEST_CHECK(bignum_init_growable(&b, 0, &alloc) == OK);
+  TEST_CHECK(bignum_init_growable(&r, 4, &alloc) == OK);
+  TEST_CHECK(bignum_init_growable(&q, 4, NULL) == OK);
+  TEST_CHECK(count.allocs == 3);
+
+  /* 2^12000 - 1 and 3^6000: both well over BIGNUM_MAX_WORDS. */
+  bignum_setu(&a, 1);
+  TEST_CHECK(bignum_shl(&a, 12000) == OK);
+  TEST_CHECK(bignum_subl(&a, &bignum_1) == OK);
+  TEST_CHECK(bignum_len_bits(&a) == 12000);
+
+  bignum_setu(&b, 1);
+  for (int i = 0; i < 6000; i++)
+    TEST_CHECK(bignum_muladdw(&b, 3, 0) == OK);
+  TEST_CHECK(bignum_len_words(&b) > BIGNUM_MAX_WORDS);
+
+  /* Products, quotients and gcds of them. */
+  TEST_CHECK(bignum_mul(&r, &a, &b) == OK);
+  TEST_CHECK(bignum_len_bits(&r) > 12000 + 9500);
+  TEST_CHECK(bignum_div(&q, &r, &a) == OK);
+  TEST_CHECK(bignum_eq(&q, &b));
+  TEST_CHECK(bignum_gcd(&q, &r, &b) == OK);
+  TEST_CHECK(bignum_eq(&q, &b));
+
+  /* Modular arithmetic and roots size their temporaries from the
+   * operands.  m = 2^12000 + 1 is coprime to b. */
+  bignum m, t;
+  TEST_CHECK(bignum_init_growable(&m, 1, NULL) == OK);
+  TEST_CHECK(bignum_init_growable(&t, 1, NULL) == OK);
+  TEST_CHECK(bignum_add(&m, &a, &bignum_1) == OK);
+  TEST_CHECK(bignum_add(&m, &m, &bignum_1) == OK);
+
+  uint32_t three = 3;
+  bignum e = { &three, &three, 1, BIGNUM_F_IMMUTABLE, 0, NULL };
+  TEST_CHECK(bignum_modexp(&r, &b, &e, &m) == OK);
+  TEST_CHECK(bignum_mul(&q, &b, &b) == OK);
+  TEST_CHECK(bignum_mul(&t, &q, &b) == OK);
+  TEST_CHECK(bignum_mod(&q, &t, &m) == OK);
+  TEST_CHECK(bignum_eq(&q, &r));
+
+  TEST_CHECK(bignum_modinv(&r, &b, &m) == OK);
+  TEST_CHECK(bignum_modmul(&q, &r, &b, &m) == OK);
+  TEST_CHECK(bignum_eq32(&q, 1));
+
+  int j;
+  TEST_CHECK(bignum_jacobi(&j, &b, &m) == OK);
+  TEST_CHECK(j == 1 || j == -1);
+
+  TEST_CHECK(bignum_sqrt(&r, &q, &t) == OK);
+  TEST_CHECK(bignum_rootn(&r, &q, &t, 3) == OK);
+  TEST_CHECK(bignum_eq(&r, &b) && bignum_is_zero(&q));
+  unsigned power;
+  TEST_CHECK(bignum_is_perfect_power(&power, &t) == OK);
+  TEST_CHECK(power);
+
+  bignum_clear(&m);
+  bignum_clear(&t);
+
+  /* Conversions. */
+  static char buf[8192];
+  TEST_CHECK(bignum_fmt_hex(&b, buf, sizeof buf) == OK);
+  TEST_CHECK(bignum_parse_str(&q, buf) == OK);
+  TEST_CHECK(bignum_eq(&q, &b));
+  TEST_CHECK(bignum_fmt_dec(&b, buf, sizeof buf) == OK);
+  TEST_CHECK(bignum_parse_str(&q, buf) == OK);
+  TEST_CHECK(bignum_eq(&q, &b));
+
+  /* Sinks format past the fixed size buffers. */
+  dstr d;
+  dstr_init(&d);
+  bignum_sink sink = { count_sink, &d };
+  bignum_neg(&b);
+  TEST_CHECK(bignum_fmt_dec(&b, buf, sizeof buf) == OK);
+  TEST_CHECK(bignum_fmt_dec_sink(&b, &sink) == OK);
+  TEST_CHECK(dstr_used(&d) == strlen(buf) && memcmp(d.start, buf, strlen(buf)) == 0);
+  dstr_free(&d);
+  dstr_init(&d);
+  TEST_CHECK(bignum_fmt_hex(&b, buf, sizeof buf) == OK);
+  TEST_CHECK(bignum_fmt_hex_sink(&b, &sink) == OK);
+  TEST_CHECK(dstr_used(&d) == strlen(buf) && memcmp(d.start, buf, strlen(buf)) == 0);
+  dstr_free(&d);
+  bignum_neg(&b);
+
+  /* Fixed size bignums still fail. */
+  BIGNUM_TMP(fixed);
+  TEST_CHECK(bignum_dup(&fixed, &b) == error_bignum_sz);
+  TEST_CHECK(bignum_mul(&fixed, &a, &bignum_base) == error_bignum_sz);
+  TEST_CHECK(bignum_reserve(&fixed, BIGNUM_MAX_WORDS) == OK);
+  TEST_CHECK(bignum_reserve(&fixed, BIGNUM_MAX_WORDS + 1) == error_bignum_sz);
+  TEST_CHECK(bignum_grow(&fixed, BIGNUM_MAX_WORDS + 1) == OK);
+  TEST_CHECK(fixed.words == BIGNUM_MAX_WORDS);
+
+  /* Growable values keep growing after a dup. */
+  TEST_CHECK(bignum_dup(&r, &fixed) == OK);
+  TEST_CHECK(r.flags & BIGNUM_F_GROWABLE);
+
+  bignum_clear(&a);
+  bignum_clear(&b);
+  bignum_clear(&r);
+  bignum_clear(&q);
+  TEST_CHECK(count.live == 0);
+}
+
+/* Fills b with words random words. */
+static void random_words(bignum *b, size_t words, uint32_t *seed)
+{
+  bignum_setu(b, 0);
+  for (size_t i = 0; i < words; i++)
+  {
+    *seed = *seed * 1103515245 + 12345;
+    TEST_CHECK(bignum_muladdw(b, 0xfffffffb, *seed) == OK);
+  }
+}
+
+/* Growable operands too big for the arena take their scratch space
+ * from their allocator instead. */
+static void growable_scratch(void)
+{
+  counting count = { 0, 0 };
+  bignum_allocator alloc = { counting_alloc, counting_free, &count };
+  size_t old_threshold = bignum_dec_dc_threshold;
+  uint32_t seed = 0xabcdef;
+  bignum a, b, q, r, g, want_q, want_r, want_g, parsed;
+  dstr want_dec, dec;
+
+  bignum *all[] = { &a, &b, &q, &r, &g, &want_q, &want_r, &want_g, &parsed };
+  for (size_t i = 0; i < ARRAYCOUNT(all); i++)
+    TEST_CHECK(bignum_init_growable(all[i], 1, &alloc) == OK);
+
+  /* A common factor, so the gcd is big too. */
+  random_words(&g, 20, &seed);
+  random_words(&q, 300, &seed);
+  random_words(&r, 150, &seed);
+  TEST_CHECK(bignum_mul(&a, &q, &g) == OK);
+  TEST_CHECK(bignum_mul(&b, &r, &g) == OK);
+
+  /* Answers with the default arena; divide and conquer for decimal. */
+  bignum_dec_dc_threshold = 2;
+  TEST_CHECK(bignum_divmod(&want_q, &want_r, &a, &b) == OK);
+  TEST_CHECK(bignum_gcd(&want_g, &a, &b) == OK);
+  dstr_init(&want_dec);
+  TEST_CHECK(bignum_fmt_dec_dstr(&a, &want_dec) == OK);
+
+  uint32_t words[100];
+  bignum_arena small;
+  bignum_arena_init(&small, words, 100);
+  bignum_arena *prev = bignum_arena_use(&small);
+  size_t allocs = count.allocs;
+
+  TEST_CHECK(bignum_divmod(&q, &r, &a, &b) == OK);
+  TEST_CHECK(bignum_eq(&q, &want_q) && bignum_eq(&r, &want_r));
+  TEST_CHECK(bignum_mod(&r, &a, &b) == OK);
+  TEST_CHECK(bignum_eq(&r, &want_r));
+  TEST_CHECK(bignum_div(&q, &a, &b) == OK);
+  TEST_CHECK(bignum_eq(&q, &want_q));
+  TEST_CHECK(bignum_gcd(&g, &a, &b) == OK);
+  TEST_CHECK(bignum_eq(&g, &want_g));
+
+  dstr_init(&dec);
+  TEST_CHECK(bignum_fmt_dec_dstr(&a, &dec) == OK);
+  TEST_CHECK(dstr_used(&dec) == dstr_used(&want_dec) &&
+             memcmp(dec.start, want_dec.start, dstr_used(&dec)) == 0);
+  TEST_CHECK(bignum_parse_strl(&parsed, dec.start, dstr_used(&dec)) == OK);
+  TEST_CHECK(bignum_eq(&parsed, &a));
+  dstr_free(&dec);
+
+  TEST_CHECK(count.allocs > allocs);
+  TEST_CHECK(small.top == words);
+  TEST_CHECK(bignum_arena_use(prev) == &small);
+
+  bignum_dec_dc_threshold = old_threshold;
+  dstr_free(&want_dec);
+  for (size_t i = 0; i < ARRAYCOUNT(all); i++)
+    bignum_clear(all[i]);
+  TEST_CHECK(count.live == 0);
+}
+
+/* Decimal streams into growable results are built as product trees.
+ * Checks them against bignum_parse_strl either side of the block
+ * sizes, and that their storage is released. */
+static void parse_stream_growable(void)
+{
+  counting count = { 0, 0 };
+  bignum_allocator alloc = { counting_alloc, counting_free, &count };
+  static const size_t lengths[] = { 1, 143, 144, 145, 288, 289, 1000, 2304, 4609, 30001 };
+  static const size_t thresholds[] = { SIZE_MAX, 1, 16, 20 };
+  static char text[30003];
+  size_t threshold = bignum_dec_dc_threshold;
+
+  bignum want, got;
+  TEST_CHECK(bignum_init_growable(&want, 1, &alloc) == OK);
+  TEST_CHECK(bignum_init_growable(&got, 1, &alloc) == OK);
+
+  /* Chunked, then product trees of various block sizes. */
+  for (size_t t = 0; t < ARRAYCOUNT(thresholds); t++)
+  {
+    uint32_t seed = 0x5eed;
+
+    for (size_t i = 0; i < ARRAYCOUNT(lengths); i++)
+    {
+      size_t len = lengths[i];
+      text[0] = '-';
+      for (size_t j = 1; j <= len; j++)
+      {
+        seed = seed * 1103515245 + 12345;
+        text[j] = '0' + (seed >> 16) % 10;
+      }
+      text[len + 1] = 0;
+
+      /* Leading zeroes, a sign or neither. */
+      const char *str = i % 3 == 0 ? text : text + 1;
+      size_t str_len = strlen(str);
+      if (i % 3 == 1)
+        text[1] = '0';
+      bignum_dec_dc_threshold = SIZE_MAX;
+      TEST_CHECK(bignum_parse_strl(&want, str, str_len) == OK);
+      bignum_dec_dc_threshold = thresholds[t];
+
+      for (size_t step = 7; step < 2000; step *= 17)
+      {
+        bignum_parser p;
+        bignum_parser_init(&p, &got);
+        for (size_t at = 0; at < str_len; at += step)
+          TEST_CHECK(bignum_parser_feed(&p, str + at, MIN(step, str_len - at)) == OK);
+        TEST_CHECK(bignum_parser_finish(&p) == OK);
+        TEST_CHECK_(bignum_eq(&want, &got) && bignum_getsign(&want) == bignum_getsign(&got),
+                    "%zu digits in steps of %zu, threshold %zu differ",
+                    len, step, thresholds[t]);
+      }
+    }
+  }
+
+  bignum_clear(&want);
+
+  /* Failing part way, or giving up, releases the parts. */
+  size_t live = count.live;
+  bignum_parser p;
+  bignum_parser_init(&p, &got);
+  TEST_CHECK(bignum_parser_feed(&p, text + 1, 10000) == OK);
+  TEST_CHECK(count.live > live);
+  TEST_CHECK(bignum_parser_feed(&p, "1x", 2) == error_invalid_string);
+  TEST_CHECK(count.live == live);
+
+  bignum_parser_init(&p, &got);
+  TEST_CHECK(bignum_parser_feed(&p, text + 1, 10000) == OK);
+  TEST_CHECK(bignum_parser_finish(&p) == OK);
+  TEST_CHECK(count.live == live);
+
+  bignum_dec_dc_threshold = threshold;
+  bignum_clear(&got);
+  TEST_CHECK(count.live == 0);
+}
+
+#define POOL_THREADS 4
+#define POOL_LIVE 100
+
+static void *pool_thread(void *arg)
+{
+  unsigned *ok = arg;
+  bignum live[POOL_LIVE];
+
+  *ok = 1;
+  for (unsigned round = 0; round < 50; round++)
+  {
+    /* Hold enough buffers that freeing them spills batches to the
+     * shared lists, for the other threads to pick up. */
+    for (unsigned i = 0; i < POOL_LIVE; i++)
+    {
+      bignum *b = &live[i];
+      if (bignum_init_growable(b, 1 + (i * 7 + round) % 40, &bignum_pool_allocator) ||
+          bignum_from_bytes(b, (const uint8_t *) "\x01\x02\x03\x04\x05\x06\x07\x08\x09",
+                            9, bignum_big_endian) ||
+          bignum_shl(b, i * 32))
+        *ok = 0;
+    }
+
+    for (unsigned i = 0; i < POOL_LIVE; i++)
+    {
+      if (bignum_len_bits(&live[i]) != 65 + i * 32)
+        *ok = 0;
+      bignum_clear(&live[i]);
+    }
+  }
+
+  return NULL;
+}
+
+static void pool(void)
+{
+  /* A freed buffer is reused by the next allocation of its size. */
+  bignum a, b;
+  TEST_CHECK(bignum_init_growable(&a, 8, &bignum_pool_allocator) == OK);
+  uint32_t *v = a.v;
+  bignum_clear(&a);
+  TEST_CHECK(bignum_init_growable(&b, 9, &bignum_pool_allocator) == OK);
+  TEST_CHECK(b.v == v);
+  bignum_clear(&b);
+
+  /* The clean allocator wipes whole buffers when they're freed, even
+   * words the bignum never used.  The pool's links then overwrite the
+   * first few words, so look past them. */
+  TEST_CHECK(bignum_init_growable(&a, 16, &bignum_pool_allocator_clean) == OK);
+  v = a.v;
+  for (size_t i = 0; i < 16; i++)
+    v[i] = 0xdeadbeef;
+  bignum_clear(&a);
+  TEST_CHECK(bignum_init_growable(&b, 16, &bignum_pool_allocator) == OK);
+  TEST_CHECK(b.v == v);
+  for (size_t i = 8; i < 16; i++)
+    TEST_CHECK(b.v[i] == 0);
+  bignum_clear(&b);
+
+  /* Big requests work too. */
+  TEST_CHECK(bignum_init_growable(&a, 100000, &bignum_pool_allocator) == OK);
+  bignum_clear(&a);
+
+  pthread_t threads[POOL_THREADS];
+  unsigned ok[POOL_THREADS];
+  for (size_t i = 0; i < POOL_THREADS; i++)
+    TEST_CHECK(pthread_create(&threads[i], NULL, pool_thread, &ok[i]) == 0);
+  for (size_t i = 0; i < POOL_THREADS; i++)
+  {
+    TEST_CHECK(pthread_join(threads[i], NULL) == 0);
+    TEST_CHECK(ok[i]);
+  }
+
+  bignum_pool_trim();
+}
+
+/* Checks divide-and-conquer decimal conversion agrees with
+ * chunked conversion. */
+static void fmt_dec_dc(void)
+{
+  static char chunked[4096], dc[4096];
+  size_t old_threshold = bignum_dec_dc_threshold;
+  uint32_t seed = 0x12345678;
+
+  bignum b = bignum_alloc();
+  bignum c = bignum_alloc();
+
+  for (size_t words = 1; words < 250; words += 7)
+  {
+    for (unsigned shape = 0; shape < 3; shape++)
+    {
+      /* Random, 10^n and 10^n - 1. */
+      bignum_setu(&b, shape == 0 ? 0 : 1);
+      for (size_t i = 0; i < words; i++)
+      {
+        seed = seed * 1103515245 + 12345;
+        TEST_CHECK(bignum_muladdw(&b, shape == 0 ? 0xfffffffb : 1000000000,
+                                  shape == 0 ? seed : 0) == OK);
+      }
+      if (shape == 2)
+        TEST_CHECK(bignum_subl(&b, &bignum_1) == OK);
+
+      bignum_dec_dc_threshold = old_threshold;
+      TEST_CHECK(bignum_fmt_dec(&b, chunked, sizeof chunked) == OK);
+
+      bignum_dec_dc_threshold = 2;
+      TEST_CHECK(bignum_fmt_dec(&b, dc, sizeof dc) == OK);
+      TEST_CHECK_(strcmp(chunked, dc) == 0, "%zu word decimal differs", words);
+
+      TEST_CHECK(bignum_parse_str(&c, dc) == OK);
+      TEST_CHECK_(bignum_eq(&b, &c), "%zu word decimal does not round trip", words);
+    }
+  }
+
+  bignum_dec_dc_threshold = old_threshold;
+  bignum_free(&b);
+  bignum_free(&c);
+
+  /* Growable values far past the cached powers round trip, by
+   * default and with divide and conquer asked for. */
+  size_t words = 4100;
+  size_t len = words * 10 + 2;
+  char *text = malloc(len);
+  TEST_CHECK(text != NULL);
+  TEST_CHECK(bignum_init_growable(&b, 1, NULL) == OK);
+  TEST_CHECK(bignum_init_growable(&c, 1, NULL) == OK);
+
+  for (size_t i = 0; i < words; i++)
+  {
+    seed = seed * 1103515245 + 12345;
+    TEST_CHECK(bignum_muladdw(&b, 0xfffffffb, seed) == OK);
+  }
+
+  for (unsigned dc = 0; dc < 2; dc++)
+  {
+    bignum_dec_dc_threshold = dc ? 2 : old_threshold;
+    TEST_CHECK(bignum_fmt_dec(&b, text, len) == OK);
+    TEST_CHECK(bignum_parse_str(&c, text) == OK);
+    TEST_CHECK_(bignum_eq(&b, &c), "%zu word decimal does not round trip", words);
+  }
+
+  bignum_dec_dc_threshold = old_threshold;
+  free(text);
+  bignum_clear(&b);
+  bignum_clear(&c);
+}
+
+static void muladd(void)
+{
+  static const char *values[] = {
+    "0", "1", "-1", "0xffffffff", "-0x100000000",
+    "0xffffffffffffffffffffffffffffffff",
+    "-0x123456789abcdef0123456789abcdef0123456789",
+    "340282366920938463463374607431768211457",
+  };
+  const size_t n = sizeof values / sizeof values[0];
+
+  BIGNUM_TMP_SZ(a, 8);
+  BIGNUM_TMP_SZ(b, 8);
+  BIGNUM_TMP_SZ(prod, 16);
+  BIGNUM_TMP_SZ(want, 16);
+  BIGNUM_TMP_SZ(got, 16);
+
+  /* Every sign and size, both ways, against a separate multiply. */
+  for (size_t i = 0; i < n; i++)
+  {
+    for (size_t j = 0; j < n; j++)
+    {
+      for (size_t k = 0; k < n; k++)
+      {
+        TEST_CHECK(bignum_parse_str(&a, values[i]) == OK);
+        TEST_CHECK(bignum_parse_str(&b, values[j]) == OK);
+        TEST_CHECK(bignum_mul(&prod, &a, &b) == OK);
+
+        TEST_CHECK(bignum_parse_str(&got, values[k]) == OK);
+        TEST_CHECK(bignum_add(&want, &got, &prod) == OK);
+        TEST_CHECK(bignum_muladd(&got, &a, &b) == OK);
+        TEST_CHECK_(bignum_eq(&got, &want), "%s + %s * %s", values[k], values[i], values[j]);
+        TEST_CHECK(bignum_check(&got) == OK);
+
+        TEST_CHECK(bignum_parse_str(&got, values[k]) == OK);
+        TEST_CHECK(bignum_sub(&want, &got, &prod) == OK);
+        TEST_CHECK(bignum_mulsub(&got, &a, &b) == OK);
+        TEST_CHECK_(bignum_eq(&got, &want), "%s - %s * %s", values[k], values[i], values[j]);
+        TEST_CHECK(bignum_check(&got) == OK);
+      }
+    }
+  }
+
+  /* x^2 - x^2 is a canonical zero. */
+  TEST_CHECK(bignum_parse_str(&a, values[6]) == OK);
+  TEST_CHECK(bignum_mul(&got, &a, &a) == OK);
+  TEST_CHECK(bignum_mulsub(&got, &a, &a) == OK);
+  TEST_CHECK(bignum_is_zero(&got) && !bignum_is_negative(&got));
+
+  /* Fixed size results still fail cleanly. */
+  BIGNUM_TMP_SZ(small, 2);
+  bignum_setu(&small, 1);
+  TEST_CHECK(bignum_muladd(&small, &a, &a) == error_bignum_sz);
+}
+
+static void modmul_rr(void)
+{
+  BIGNUM_TMP(m);
+  BIGNUM_TMP(rr);
+  BIGNUM_TMP(x);
+  BIGNUM_TMP(y);
+  BIGNUM_TMP(want);
+  BIGNUM_TMP(got);
+
+  monty_ctx monty;
+  TEST_CHECK(bignum_parse_str(&m, "0xffffffff00000001000000000000000000000000ffffffffffffffffffffffff") == OK);
+  TEST_CHECK(bignum_monty_setup(&m, &monty));
+  TEST_CHECK(bignum_monty_normalise2(&rr, &bignum_1, &m, &monty) == OK);
+
+  TEST_CHECK(bignum_parse_str(&x, "0x123456789abcdef0123456789abcdef0123456789abcdef") == OK);
+  TEST_CHECK(bignum_parse_str(&y, "0xfedcba9876543210fedcba9876543210fedcba9876543210fedcba98765432") == OK);
+
+  for (int i = 0; i < 16; i++)
+  {
+    TEST_CHECK(bignum_modmul(&want, &x, &y, &m) == OK);
+    TEST_CHECK(bignum_monty_modmul_rr(&got, &x, &y, &m, &rr, &monty) == OK);
+    TEST_CHECK(bignum_eq(&got, &want));
+
+    /* And in place. */
+    TEST_CHECK(bignum_monty_modmul_rr(&x, &x, &y, &m, &rr, &monty) == OK);
+    TEST_CHECK(bignum_eq(&x, &want));
+  }
+}
+
+static void reduce(void)
+{
+  static const struct
+  {
+    const char *m;
+    reduce_kind kind;
+  } moduli[] = {
+    { "0x7fffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffed", REDUCE_PSEUDO_MERSENNE },
+    { "0x1ffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff", REDUCE_PSEUDO_MERSENNE },
+    { "0xfffffffffffffffffffffffffffffffffffffffffffffffffffffffefffffc2f", REDUCE_MONTY },
+    { "0xfffffffffffffffffffffffffffffff1", REDUCE_PSEUDO_MERSENNE },
+    { "0xfffffffffffffffffffffffffffffffe", REDUCE_PSEUDO_MERSENNE },
+    { "0xffffffff00000001000000000000000000000000ffffffffffffffffffffffff", REDUCE_P256 },
+    { "0xfffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffeffffffff0000000000000000ffffffff", REDUCE_P384 },
+    { "0xfedcba9876543210fedcba9876543210fedcba9876543211", REDUCE_MONTY },
+    { "0xfedcba9876543210fedcba9876543210fedcba9876543210", REDUCE_GENERIC },
+  };
+
+  BIGNUM_TMP(m);
+  BIGNUM_TMP(x);
+  BIGNUM_TMP(y);
+  BIGNUM_TMP(tmp);
+  BIGNUM_TMP(want);
+  BIGNUM_TMP(got);
+
+  reduce_ctx ctx;
+  TEST_CHECK(bignum_reduce_setup(&bignum_0, &ctx) == error_invalid_bignum);
+  TEST_CHECK(bignum_reduce_setup(&bignum_neg1, &ctx) == error_invalid_bignum);
+
+  for (size_t i = 0; i < ARRAYCOUNT(moduli); i++)
+  {
+    TEST_CHECK(bignum_parse_str(&m, moduli[i].m) == OK);
+    TEST_CHECK(bignum_reduce_setup(&m, &ctx) == OK);
+    TEST_CHECK_(ctx.kind == moduli[i].kind, "kind of %s", moduli[i].m);
+    TEST_CHECK(bignum_reduce_is_special(&ctx) == (ctx.kind >= REDUCE_PSEUDO_MERSENNE));
+
+    /* Products of all sizes up to m^2, and some edge cases. */
+    bignum_setu(&x, 0x12345);
+    bignum_setu(&y, 3);
+    for (int j = 0; j < 40; j++)
+    {
+      TEST_CHECK(bignum_mul(&tmp, &x, &x) == OK);
+      TEST_CHECK(bignum_addl(&tmp, &y) == OK);
+      TEST_CHECK(bignum_trunc(&tmp, 2 * bignum_len_bits(&m)) == OK);
+      TEST_CHECK(bignum_dup(&x, &tmp) == OK);
+
+      TEST_CHECK(bignum_mod(&want, &x, &m) == OK);
+      TEST_CHECK(bignum_reduce(&got, &x, &m, &ctx) == OK);
+      TEST_CHECK_(bignum_eq(&got, &want), "reduce %zu/%d", i, j);
+
+      /* -x mod m = m - (x mod m), unless that's zero. */
+      bignum_setsign(&x, -1);
+      TEST_CHECK(bignum_reduce(&got, &x, &m, &ctx) == OK);
+      bignum_setsign(&x, 1);
+      if (!bignum_is_zero(&want))
+        TEST_CHECK(bignum_sub(&want, &m, &want) == OK);
+      TEST_CHECK_(bignum_eq(&got, &want), "reduce -x %zu/%d", i, j);
+
+      TEST_CHECK(bignum_mul(&tmp, &x, &y) == OK);
+      TEST_CHECK(bignum_mod(&want, &tmp, &m) == OK);
+      TEST_CHECK(bignum_reduce_modmul(&got, &x, &y, &m, &ctx) == OK);
+      TEST_CHECK_(bignum_eq(&got, &want), "modmul %zu/%d", i, j);
+      TEST_CHECK(bignum_dup(&y, &got) == OK);
+    }
+
+    TEST_CHECK(bignum_reduce(&got, &m, &m, &ctx) == OK);
+    TEST_CHECK(bignum_is_zero(&got));
+    TEST_CHECK(bignum_sub(&x, &m, &bignum_1) == OK);
+    TEST_CHECK(bignum_reduce(&got, &x, &m, &ctx) == OK);
+    TEST_CHECK(bignum_eq(&got, &x));
+    TEST_CHECK(bignum_reduce_modmul(&got, &x, &x, &m, &ctx) == OK);
+    TEST_CHECK(bignum_eq(&got, &bignum_1));
+
+    /* In place. */
+    TEST_CHECK(bignum_reduce_modmul(&x, &x, &x, &m, &ctx) == OK);
+    TEST_CHECK(bignum_eq(&x, &bignum_1));
+
+    /* x^e by repeated multiplication. */
+    TEST_CHECK(bignum_parse_str(&x, "0x123456789abcdef0123456789abcdef") == OK);
+    bignum_setu(&want, 1);
+    for (int e = 0; e < 12; e++)
+    {
+      bignum_setu(&tmp, e);
+      TEST_CHECK(bignum_reduce_modexp(&got, &x, &tmp, &m, &ctx) == OK);
+      TEST_CHECK_(bignum_eq(&got, &want), "modexp %zu/%d", i, e);
+      TEST_CHECK(bignum_modexp(&got, &x, &tmp, &m) == OK);
+      TEST_CHECK_(bignum_eq(&got, &want), "modexp %zu/%d", i, e);
+      TEST_CHECK(bignum_modmul(&want, &want, &x, &m) == OK);
+    }
+
+    TEST_CHECK(bignum_reduce_modexp(&got, &x, &bignum_neg1, &m, &ctx) == error_invalid_bignum);
+  }
+}
+
+static void ec(void)
+{
+  static const struct
+  {
+    error (*setup)(ec_curve *c);
+    const char *k, *x, *y;
+    const char *k1, *k2, *x2, *y2;
+  } vectors[] = {
+    {
+      bignum_ec_p256,
+      "0x719c74b8dc1afab8963f389496afcff50a3aee4966660879138dda71e3658966",
+      "0xc08819d6d99497f8ac2fa08ec2abe2f3fbe3af446b9d3219d5a98cef47e5a398",
+      "0x1cc80221e3b21de2b073786367e7a2929359d0865cc4c40635e050ae94b2acdd",
+      "0xcd6a4292f27baaf989bc15a5956f5c7126e7581a84060c46a27056f73a818b9f",
+      "0x1be1f5bd3393b0fa1d551dc51f10900c87ced6d11a64ad207c7ac10083d0a2f",
+      "0x4d56881ce9228cd5a8cb25f5e5075184ae8ac0838e3ab9b4bb862d9cc7f7f33d",
+      "0x7f714f0fd595e5302893035f5aaa55499940dfaa733cac39a4c4e9d97bd1dcc5",
+    },
+    {
+      bignum_ec_p384,
+      "0x619b84f1ef3ca884b6989668f7c8122a54644417871be4434b9a3682eb66f9888c75603722a8ff1c07e70715d7d8a6c3",
+      "0x7703c9aa708d1e5c43107e64ecdce5de6a83f3f4433f7254b1653763e7699fbf837813f131190e3d6569d5ece8833a0f",
+      "0xc7e7811ec6bb361c7fe2fe1996b4889a4e80e176f7907b2bd72718ab473433aa259b1e222094a9baf0a7f75130cbc1b1",
+      "0x75a75f2013069e53d4a4405777321e857881549127f6e6495c41c3db7a8efdebb4895688f96fe97365e12e6a17c9b326",
+      "0x16ec5774c74b7a7471a7124481aeb810562d3d5c39f2a8a76ec30d101c0072e59e8c85898b5f46afb24b5692bfb63d9e",
+      "0xd63b67cda0ccbc253e74d3b0e322a6b3c9e4e53a5d0aa27e5ff707cac7b1a1f0ad1a7f49f0080202ecb0aa26555673e5",
+      "0xe0391053a5fd1086f1d669b97388f250e1df6cb393edbf8c5f94704f47347cc0c46d43ae047b06a42b6aef357360a17d",
+    },
+    {
+      bignum_ec_secp256k1,
+      "0x4df82eb011ac0c76e06ced8c5ad023419840ede51b4ea5c2273fe1f7466af77f",
+      "0x1089f631e1f0b6a4dcdbd9e8e049a582954729a9fb5d72a28f126b7c2e4648db",
+      "0x8385ffd14d109e0bd1bf1fd088d2684ce3916f8a5364fc8fa53ae8a4d95db5e7",
+      "0x5b4c42944d3e6fc36244ba182f09e29867f0a484df312a0775dc203b55e8dc40",
+      "0x1fcf85623f8754ce95524b291d668a64d43cc23d34228470c6b54165c5efc8e6",
+      "0xba29c3197efca51e939171d0e76618663e8d3b817a40991547e6952cc0b51f55",
+      "0x343703b64d9ca866325e3f962628b89c539e3d3ece60fac9ed7609c642867b31",
+    },
+  };
+
+  BIGNUM_TMP(k);
+  BIGNUM_TMP(k2);
+  BIGNUM_TMP(x);
+  BIGNUM_TMP(y);
+  BIGNUM_TMP(wx);
+  BIGNUM_TMP(wy);
+  BIGNUM_TMP(tx);
+  BIGNUM_TMP(ty);
+
+  for (size_t i = 0; i < ARRAYCOUNT(vectors); i++)
+  {
+    ec_curve c;
+    ec_comb comb;
+    TEST_CHECK(vectors[i].setup(&c) == OK);
+    TEST_CHECK(bignum_ec_check(c.gx, c.gy, &c) == OK);
+    TEST_CHECK(bignum_ec_comb_setup(&comb, &c, &bignum_pool_allocator) == OK);
+
+    /* kG three ways. */
+    TEST_CHECK(bignum_parse_str(&k, vectors[i].k) == OK);
+    TEST_CHECK(bignum_parse_str(&wx, vectors[i].x) == OK);
+    TEST_CHECK(bignum_parse_str(&wy, vectors[i].y) == OK);
+    TEST_CHECK(bignum_ec_check(&wx, &wy, &c) == OK);
+
+    TEST_CHECK(bignum_ec_mul(&x, &y, &k, c.gx, c.gy, &c) == OK);
+    TEST_CHECK_(bignum_eq(&x, &wx) && bignum_eq(&y, &wy), "mul %zu", i);
+    TEST_CHECK(bignum_ec_mul_base(&x, &y, &k, &comb) == OK);
+    TEST_CHECK_(bignum_eq(&x, &wx) && bignum_eq(&y, &wy), "mul_base %zu", i);
+    TEST_CHECK(bignum_ec_mul2(&x, &y, &k, c.gx, c.gy, &bignum_0, c.gx, c.gy, &c) == OK);
+    TEST_CHECK_(bignum_eq(&x, &wx) && bignum_eq(&y, &wy), "mul2 %zu", i);
+
+    /* k1 G + k2 Q, with Q = kG. */
+    TEST_CHECK(bignum_parse_str(&k, vectors[i].k1) == OK);
+    TEST_CHECK(bignum_parse_str(&k2, vectors[i].k2) == OK);
+    TEST_CHECK(bignum_parse_str(&x, vectors[i].x2) == OK);
+    TEST_CHECK(bignum_parse_str(&y, vectors[i].y2) == OK);
+    TEST_CHECK(bignum_ec_mul2(&tx, &ty, &k, c.gx, c.gy, &k2, &wx, &wy, &c) == OK);
+    TEST_CHECK_(bignum_eq(&tx, &x) && bignum_eq(&ty, &y), "mul2 %zu", i);
+
+    /* And separately. */
+    TEST_CHECK(bignum_ec_mul_base(&tx, &ty, &k, &comb) == OK);
+    TEST_CHECK(bignum_ec_mul(&wx, &wy, &k2, &wx, &wy, &c) == OK);
+    TEST_CHECK(bignum_ec_add(&tx, &ty, &tx, &ty, &wx, &wy, &c) == OK);
+    TEST_CHECK_(bignum_eq(&tx, &x) && bignum_eq(&ty, &y), "add %zu", i);
+
+    /* G + G + G = 3G = (n + 3)G. */
+    TEST_CHECK(bignum_ec_add(&tx, &ty, c.gx, c.gy, c.gx, c.gy, &c) == OK);
+    TEST_CHECK(bignum_ec_add(&tx, &ty, &tx, &ty, c.gx, c.gy, &c) == OK);
+    TEST_CHECK(bignum_add(&k, c.n, &bignum_1) == OK);
+    TEST_CHECK(bignum_addl(&k, &bignum_1) == OK);
+    TEST_CHECK(bignum_addl(&k, &bignum_1) == OK);
+    TEST_CHECK(bignum_ec_mul(&x, &y, &k, c.gx, c.gy, &c) == OK);
+    TEST_CHECK_(bignum_eq(&tx, &x) && bignum_eq(&ty, &y), "3G %zu", i);
+    TEST_CHECK(bignum_ec_check(&x, &y, &c) == OK);
+
+    /* (n - 1)G = -G, and nG is at infinity. */
+    TEST_CHECK(bignum_sub(&k, c.n, &bignum_1) == OK);
+    TEST_CHECK(bignum_ec_mul_base(&x, &y, &k, &comb) == OK);
+    TEST_CHECK(bignum_eq(&x, c.gx));
+    TEST_CHECK(bignum_add(&y, &y, c.gy) == OK);
+    TEST_CHECK(bignum_eq(&y, c.p));
+    TEST_CHECK(bignum_ec_mul(&x, &y, c.n, c.gx, c.gy, &c) == error_infinity);
+    TEST_CHECK(bignum_ec_mul_base(&x, &y, &bignum_0, &comb) == error_infinity);
+    TEST_CHECK(bignum_ec_mul2(&x, &y, &bignum_1, c.gx, c.gy, &k, c.gx, c.gy, &c) == error_infinity);
+
+    /* Bad input. */
+    TEST_CHECK(bignum_ec_check(c.gx, c.gx, &c) == error_invalid_bignum);
+    TEST_CHECK(bignum_ec_check(c.p, c.gy, &c) == error_invalid_bignum);
+    TEST_CHECK(bignum_ec_mul(&x, &y, &bignum_neg1, c.gx, c.gy, &c) == error_invalid_bignum);
+
+    bignum_ec_comb_clear(&comb);
+  }
+
+  ec_curve c;
+  TEST_CHECK(bignum_ec_setup(&c, &bignum_base, &bignum_0, &bignum_1, &bignum_0, &bignum_0, &bignum_1) == error_invalid_bignum);
+}
+
+static void x25519(void)
+{
+  /* RFC 7748, section 5.2. */
+  static const struct
+  {
+    const char *k, *u, *want;
+  } vectors[] = {
+    { "a546e36bf0527c9d3b16154b82465edd62144c0ac1fc5a18506a2244ba449ac4",
+      "e6db6867583030db3594c1a424b15f7c726624ec26b3353b10a903a6d0ab1c4c",
+      "c3da55379de9c6908e94ea4df28d084f32eccf03491c71f754b4075577a28552" },
+    { "4b66e9d4d1b4673c5ad22691957d6af5c11b6421e0ea01d42ca4169e7918ba0d",
+      "e5210f12786811d3f4b7959d0538ae2c31dbe7106fc03c3efc4cd549c715a493",
+      "95cbde9476e8907d7aade45cb4b873f88b595a68799fa152e6f8f7647aac7957" },
+    { "0900000000000000000000000000000000000000000000000000000000000000",
+      "0900000000000000000000000000000000000000000000000000000000000000",
+      "422c8e7a6227d7bca1350b3e2bb7279f7897b87bb6854b783c60e80311ae3079" },
+  };
+
+  for (size_t i = 0; i < ARRAYCOUNT(vectors); i++)
+  {
+    uint8_t k[32], u[32], want[32], got[32];
+    for (size_t j = 0; j < 32; j++)
+    {
+      sscanf(vectors[i].k + 2 * j, "%2hhx", &k[j]);
+      sscanf(vectors[i].u + 2 * j, "%2hhx", &u[j]);
+      sscanf(vectors[i].want + 2 * j, "%2hhx", &want[j]);
+    }
+
+    TEST_CHECK(bignum_ec_x25519(got, k, u) == OK);
+    TEST_CHECK_(memcmp(got, want, 32) == 0, "vector %zu", i);
+  }
 }
 
 static void test_stdin(void)
@@ -559,6 +2227,10 @@ static void test_shr(void)
 static void test_trunc(void)
 {
 #include "test-trunc.inc"
+
+  /* The mask for the top word needs every bit of it. */
+  check("trunc(0xffffffffffffffff, 31) == 0x7fffffff");
+  check("trunc(0xffffffffffffffff, 63) == 0x7fffffffffffffff");
 }
 
 static void test_modmul(void)
@@ -574,6 +2246,10 @@ static void test_modexp(void)
 static void test_gcd(void)
 {
 #include "test-gcd.inc"
+
+  check("gcd(0, 5) == 5");
+  check("gcd(-12, 0) == 12");
+  check("gcd(0, 0) == 0");
 }
 
 static void test_egcd_v(void)
@@ -596,6 +2272,104 @@ static void test_modinv(void)
 #include "test-modinv.inc"
 }
 
+static void test_modsqrt(void)
+{
+#include "test-modsqrt.inc"
+
+  /* Non-squares. */
+  bignum r = bignum_alloc();
+  bignum a = bignum_alloc();
+  bignum p = bignum_alloc();
+
+  const char *cases[][2] = {
+    { "3", "7" },
+    { "2", "13" },
+    { "3", "17" },
+    { "2", "57896044618658097711785492504343953926634992332820282019728792003956564819949" },
+    { "11", "26959946667150639794667015087019630673557916260026308143510066298881" },
+  };
+
+  for (size_t i = 0; i < ARRAYCOUNT(cases); i++)
+  {
+    convert_bignum(&a, cases[i][0], strlen(cases[i][0]));
+    convert_bignum(&p, cases[i][1], strlen(cases[i][1]));
+    TEST_CHECK_(bignum_modsqrt(&r, &a, &p) == error_no_sqrt,
+                "%s should not be a square mod %s", cases[i][0], cases[i][1]);
+  }
+
+  /* Composite moduli with no non-residue to find. */
+  const char *composites[] = { "9", "25", "49", "4295098369" };
+  for (size_t i = 0; i < ARRAYCOUNT(composites); i++)
+  {
+    bignum_setu(&a, 4);
+    convert_bignum(&p, composites[i], strlen(composites[i]));
+    TEST_CHECK_(bignum_modsqrt(&r, &a, &p) == error_invalid_bignum,
+                "%s should be rejected", composites[i]);
+  }
+
+  bignum_free(&r);
+  bignum_free(&a);
+  bignum_free(&p);
+}
+
+static void test_jacobi(void)
+{
+#include "test-jacobi.inc"
+
+  check("jacobi(0, 1) == 1");
+  check("jacobi(5, 1) == 1");
+  check("jacobi(0, 3) == 0");
+  check("jacobi(-1, 3) == -1");
+  check("jacobi(-1, 5) == 1");
+  check("jacobi(30, 7) == 1");
+  check("jacobi(21, 9) == 0");
+
+  bignum j = bignum_alloc();
+  bignum_setu(&j, 4);
+  int r;
+  TEST_CHECK(bignum_jacobi(&r, &bignum_1, &j) == error_invalid_bignum);
+  bignum_free(&j);
+}
+
+static void test_sqrt(void)
+{
+#include "test-sqrt.inc"
+}
+
+static void test_rootn(void)
+{
+#include "test-rootn.inc"
+
+  check("rootn(1267650600228229401496703205376, 100) == 2");
+  check("rootn(1267650600228229401496703205375, 100) == 1");
+  check("rootn(1267650600228229401496703205375, 1000) == 1");
+}
+
+static void test_ispow(void)
+{
+  check("ispow(0) == 1");
+  check("ispow(1) == 1");
+  check("ispow(-1) == 1");
+  check("ispow(2) == 0");
+  check("ispow(4) == 1");
+  check("ispow(-4) == 0");
+  check("ispow(-8) == 1");
+  check("ispow(72) == 0");
+  check("ispow(1024) == 1");
+  check("ispow(1267650600228229401496703205376) == 1");
+  check("ispow(1267650600228229401496703205377) == 0");
+  /* 3 ** 101 */
+  check("ispow(1546132562196033993109383389296863818106322566003) == 1");
+  /* 1000003 ** 7 */
+  check("ispow(1000021000189000945002835005103005103002187) == 1");
+  /* 1000003 ** 7 + 1 */
+  check("ispow(1000021000189000945002835005103005103002188) == 0");
+  /* (2 ** 127 - 1) ** 2 */
+  check("ispow(28948022309329048855892746252171976962977213799489202546401021394546514198529) == 1");
+  /* (2 ** 127 - 1) * (2 ** 89 - 1) */
+  check("ispow(105312291668557186697918027513529248857806893649219117400977309697) == 0");
+}
+
 static void test_tmp(void)
 {
   bignum r = bignum_alloc();
@@ -627,6 +2401,26 @@ TEST_LIST = {
   { "basic_test", basic_test },
   { "inequality", inequality },
   { "addsign", addsign },
+  { "fmt_dec", fmt_dec },
+  { "fmt_dec_dc", fmt_dec_dc },
+  { "fmt_base", fmt_base },
+  { "fmt_hex_words", fmt_hex_words },
+  { "bytes", bytes },
+  { "der_integer", der_integer },
+  { "fmt_sinks", fmt_sinks },
+  { "parse_stream", parse_stream },
+  { "modstream", modstream },
+  { "scratch", scratch },
+  { "dirty", dirty },
+  { "growable", growable },
+  { "growable_scratch", growable_scratch },
+  { "parse_stream_growable", parse_stream_growable },
+  { "pool", pool },
+  { "muladd", muladd },
+  { "modmul_rr", modmul_rr },
+  { "reduce", reduce },
+  { "ec", ec },
+  { "x25519", x25519 },
   { "stdin", test_stdin },
   { "add", test_add },
   { "sub", test_sub },
@@ -640,6 +2434,11 @@ TEST_LIST = {
   { "modmul", test_modmul },
   { "modexp", test_modexp },
   { "modinv", test_modinv },
+  { "modsqrt", test_modsqrt },
+  { "jacobi", test_jacobi },
+  { "sqrt", test_sqrt },
+  { "rootn", test_rootn },
+  { "ispow", test_ispow },
   { "gcd", test_gcd },
   { "egcd-v", test_egcd_v },
   { "egcd-a", test_egcd_a },
@@ -0,0 +1,331 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "bignum.h"
+#include "bignum-str.h"
+#include "bignum-fixed.hpp"
+#include "ext/cutest.h"
+#include "testvectors.hpp"
+
+using namespace bignum_cxx;
+
+/* Constants are computed at compile time. */
+static constexpr auto p256 = fixed_bignum<256>::from_hex(
+  "ffffffff00000001000000000000000000000000ffffffffffffffffffffffff");
+static constexpr montgomery<256> p256_mont(p256);
+
+static_assert(fixed_bignum<64>(0xffffffffffffffff) + fixed_bignum<64>(1) == fixed_bignum<64>(0),
+              "add wraps");
+static_assert(fixed_bignum<64>(0) - fixed_bignum<64>(1) == fixed_bignum<64>(0xffffffffffffffff),
+              "sub wraps");
+static_assert(p256_mont.from_mont(p256_mont.one()) == fixed_bignum<256>(1),
+              "R mod m is one");
+static_assert(p256_mont.from_mont(p256_mont.mul(p256_mont.to_mont(fixed_bignum<256>(3)),
+                                                p256_mont.to_mont(p256 - fixed_bignum<256>(1))))
+              == p256 - fixed_bignum<256>(3),
+              "3 * -1 == -3");
+
+static constexpr fixed_bignum<128> square_of_max()
+{
+  fixed_bignum<128> r;
+  sqr(r, fixed_bignum<64>(0xffffffffffffffff));
+  return r;
+}
+
+static_assert(square_of_max() == fixed_bignum<128>::from_hex("fffffffffffffffe0000000000000001"),
+              "(2^64 - 1)^2");
+
+/* --- Test vectors --- */
+
+#define MAX_ARGS 3
+
+/* A vector's numbers, as C bignums. */
+typedef struct
+{
+  const char *op;
+  bignum args[MAX_ARGS];
+  size_t nargs;
+  bignum want;
+} vector;
+
+static void parse_num(bignum *b, std::string_view s)
+{
+  error err = bignum_init_growable(b, 1, NULL);
+  assert(err == OK);
+  err = bignum_parse_strl(b, s.data(), s.size());
+  assert(err == OK);
+  (void) err;
+}
+
+static void load_vector(vector *vec, const test_vector &tv)
+{
+  assert(tv.args.size() <= MAX_ARGS);
+
+  vec->op = tv.op.c_str();
+  vec->nargs = tv.args.size();
+  for (size_t i = 0; i < vec->nargs; i++)
+    parse_num(&vec->args[i], tv.args[i]);
+  parse_num(&vec->want, tv.want);
+}
+
+static void free_vector(vector *vec)
+{
+  for (size_t i = 0; i < vec->nargs; i++)
+    bignum_clear(&vec->args[i]);
+  bignum_clear(&vec->want);
+}
+
+/* Loads b mod 2^B into f.  Returns false if |b| doesn't fit. */
+template <size_t B>
+static bool load(fixed_bignum<B> &f, const bignum &b)
+{
+  bignum mag = b;
+  bignum_setsign(&mag, 1);
+  if (f.assign(mag) != OK)
+    return false;
+
+  if (bignum_is_negative(&b))
+    f = fixed_bignum<B>() - f;
+  return true;
+}
+
+static bool all_nonnegative(const vector *vec)
+{
+  for (size_t i = 0; i < vec->nargs; i++)
+  {
+    if (bignum_is_negative(&vec->args[i]))
+      return false;
+  }
+  return true;
+}
+
+/* Returns x mod m, using the C library. */
+template <size_t B>
+static fixed_bignum<B> reduce(const fixed_bignum<B> &x, const fixed_bignum<B> &m)
+{
+  bignum xv = x.view(), mv = m.view(), r;
+  error err = bignum_init_growable(&r, 1, NULL);
+  assert(err == OK);
+  err = bignum_mod(&r, &xv, &mv);
+  assert(err == OK);
+
+  fixed_bignum<B> f;
+  err = f.assign(r);
+  assert(err == OK);
+  (void) err;
+
+  bignum_clear(&r);
+  return f;
+}
+
+/* Checks vec at width B.  Returns false if it doesn't fit. */
+template <size_t B>
+static bool check_at(const vector *vec, const char *expr)
+{
+  using value = fixed_bignum<B>;
+  using wide = fixed_bignum<2 * B>;
+
+  value a[MAX_ARGS];
+  for (size_t i = 0; i < vec->nargs; i++)
+  {
+    if (!load(a[i], vec->args[i]))
+      return false;
+  }
+
+  if (!strcmp(vec->op, "add") || !strcmp(vec->op, "sub"))
+  {
+    /* Everything is modulo 2^B, so signs don't matter. */
+    value want;
+    if (!load(want, vec->want))
+      return false;
+
+    value r = a[0];
+    for (size_t i = 1; i < vec->nargs; i++)
+      r = vec->op[0] == 'a' ? r + a[i] : r - a[i];
+    TEST_CHECK_(r == want, "%s at %zu bits", expr, B);
+  } else if (!strcmp(vec->op, "mul") || !strcmp(vec->op, "sqr")) {
+    wide want, r;
+    if (!all_nonnegative(vec) || !load(want, vec->want))
+      return false;
+
+    if (vec->op[0] == 'm')
+      mul(r, a[0], a[1]);
+    else
+      sqr(r, a[0]);
+    TEST_CHECK_(r == want, "%s at %zu bits", expr, B);
+  } else if (!strcmp(vec->op, "modmul") || !strcmp(vec->op, "modexp")) {
+    const value &m = a[2];
+    value want;
+    if (!all_nonnegative(vec) || !m.is_odd() || m == value(1) ||
+        !load(want, vec->want))
+      return false;
+
+    montgomery<B> mont(m);
+    value xR = mont.to_mont(reduce(a[0], m)), rR;
+
+    if (vec->op[3] == 'm')
+    {
+      rR = mont.mul(xR, mont.to_mont(reduce(a[1], m)));
+    } else {
+      rR = mont.pow(xR, a[1]);
+    }
+
+    TEST_CHECK_(mont.from_mont(rR) == want, "%s at %zu bits", expr, B);
+  } else {
+    return false;
+  }
+
+  return true;
+}
+
+/* Checks a vector at every width it fits.  Without optimisation,
+ * modular arithmetic is slow enough that the wider ones are
+ * skipped. */
+static bool check_vector(const test_vector &tv, const char *expr)
+{
+  vector vec;
+  load_vector(&vec, tv);
+
+  bool modexp = tv.op == "modexp";
+  bool modular = modexp || tv.op == "modmul";
+
+  bool any = check_at<64>(&vec, expr);
+  any |= check_at<256>(&vec, expr);
+  any |= check_at<384>(&vec, expr);
+  if (!modexp)
+    any |= check_at<1024>(&vec, expr);
+  if (!modular)
+    any |= check_at<4096>(&vec, expr);
+
+  free_vector(&vec);
+  return any;
+}
+
+/* Checks expr at 2048 bits, which check skips for modular
+ * arithmetic, and which the generated vectors are too narrow to
+ * reach anyway. */
+static void check_wide(const char *expr)
+{
+  test_vector tv = parse_vector(expr);
+  vector vec;
+  load_vector(&vec, tv);
+  TEST_CHECK_(check_at<2048>(&vec, expr), "%s fits 2048 bits", vec.op);
+  free_vector(&vec);
+}
+
+/* RSA-sized vectors.  The exponentiation takes a while without
+ * optimisation. */
+static void wide_modular(void)
+{
+  check_wide("modmul("
+    "0x5086ad4d162a1f9a8300365e8b146ee1d388fd50a0d1212763e30fc5e8139460"
+    "808dca091309e9daa730bfe13c726f7bc14a64bc5c006d75af79f392448a07ee"
+    "6f516e0224b2c636d047c85fdc5af872cb454165bca56ac3bb11bc87f7a28141"
+    "f9132fde0df60b74a4f1bcde0cf63dd87f7f87fb893bca23f26651ad03cf6109"
+    "f09bb6c503ae3a477a5e58100ebb21e71a8c846d7b689f79ee72137e8912cf89"
+    "406d62918e0730150454133d3c66b46ce9c1d6c8aba6b5e68b64c8d3acf35d6b"
+    "a19e2adc1707b46fb1f4569122ae1e6e812f621d2253931804d2f1ba101102c8"
+    "e9c0d57d16b6fbf11b8d1460f89975b061ab22c9edf1bac12921355d9fbb371b, "
+    "0x341385b81e95100adbac0cc19afe3ab790004946616abcc41cad677de0880dab"
+    "48e1549688568098ec7128631f922bad4e9817eebbc610d380aa312e2831973e"
+    "f15869c5ad4bff356b91376f5c0479fa83204bd61eaf8c61d10e4672bcc7eedd"
+    "624c7e572c08438053f1147c53527d3c579b15b601e6a875fd16c54a5115bb5e"
+    "47787c93e725379e596257c0286c742e0dfb0dcceaba66bf95d3083f15692100"
+    "916db5d3619755091b459ff8e7cf50c40396614ab242727fa7a0e7ee88e0c53c"
+    "7acb960b79624f96d5448d2839d89257342dc05634cefead758aa66b281d9701"
+    "c3a1c38bdf64c47ac15fc75a31bf106a4953c6d0cfc1e1f148566428d875c97a, "
+    "0xb5185d113e483bf251be0aa860d9d7e550b432769c81b3f59554c672b9d6f894"
+    "9084a7ea8070b3af019c26353c68f0117759753c271c2ba61d1584a1fec833cc"
+    "1fcd84d6f8bdfebd9ea17fb170fd6323d4d6069b7073dc2e48202fe1b8504382"
+    "eff17925ad56a2e06d0977179a1529c437ed536ed62bebbd3cf8b56febf86dc8"
+    "ff89b19fd94c3e98d02e375de133a82e3575a55db256ede3a636069216ad10c6"
+    "214f06e90a156d43dda9278f9dec29391cd1a0e9e0938401cd85e3f700c2ecd4"
+    "f046cd22ea39f334d345d00c543a1fc83e4fcefebe9cae145b74943bd7aa4170"
+    "a236a09faf759682844a3b45bc53d56961c6ca3484e717bc7fdfe7e949f075f7) == "
+    "0xb413d4da3c7e4b6a9635ea44376e0542a7984db99a7572929a5718aeb91428d5"
+    "c9239ce182177abc713e1b96f1bdcc5b24f23eac5194e96fc78b17cefa57d020"
+    "b9644c7eb0229ead9903db50374b98ad187eb180f148bd5791c55fa02334952d"
+    "28989595a269510016e8d8464a2138909e178446ca61e9bf5238c40646a19e32"
+    "a0b6f648e71497b68ce44752520914426c96ceb723c4d9381e55b32cecbbeb94"
+    "4eec5cc2f514bcbc97adf9fb53036f78db36946ed4e791c76aff9e751443b6b8"
+    "5df7b6668fb7b143e1be5777a151086a246d3ab177dd36200f999966dedde462"
+    "4dc4c507e25d795f02bcb0b6fcb273087b9417fa7b61a4c806f825e63eca8812");
+
+  check_wide("modexp("
+    "0x5086ad4d162a1f9a8300365e8b146ee1d388fd50a0d1212763e30fc5e8139460"
+    "808dca091309e9daa730bfe13c726f7bc14a64bc5c006d75af79f392448a07ee"
+    "6f516e0224b2c636d047c85fdc5af872cb454165bca56ac3bb11bc87f7a28141"
+    "f9132fde0df60b74a4f1bcde0cf63dd87f7f87fb893bca23f26651ad03cf6109"
+    "f09bb6c503ae3a477a5e58100ebb21e71a8c846d7b689f79ee72137e8912cf89"
+    "406d62918e0730150454133d3c66b46ce9c1d6c8aba6b5e68b64c8d3acf35d6b"
+    "a19e2adc1707b46fb1f4569122ae1e6e812f621d2253931804d2f1ba101102c8"
+    "e9c0d57d16b6fbf11b8d1460f89975b061ab22c9edf1bac12921355d9fbb371b, "
+    "0xfc69f1ec5b341460308fd9b84fb15268a73ceb980a87a7d3be4f4c0ec253a9b1"
+    "0aae060b4777404840e2513e49866ba7f4d4a5a479d4d9556c91450e79d581f3"
+    "6d420a9b1c2906bbd9105132c294249b8490f3a330c37d815b17113d7c4ac3e6"
+    "2ed2f271c4feb1e52438b7752a527f981ed1e5c29216bf32bf291d8c32e83625"
+    "d75295cb0609cc78ff6beab0920b11687c2f0612e22c944702f1599c1c581d3e"
+    "512436d0c6695f3cf9d88f82f4ffffbe3bc76b2938fc50c19d137ae921c074b2"
+    "47da29420489d2625b0e17c523ed3c2146bd13571d8857820d9206ed71c30093"
+    "ade0ab10f01fe13890bd9cbe774d5a34e479dde75fcbed8fe7a16c4828350905, "
+    "0xb5185d113e483bf251be0aa860d9d7e550b432769c81b3f59554c672b9d6f894"
+    "9084a7ea8070b3af019c26353c68f0117759753c271c2ba61d1584a1fec833cc"
+    "1fcd84d6f8bdfebd9ea17fb170fd6323d4d6069b7073dc2e48202fe1b8504382"
+    "eff17925ad56a2e06d0977179a1529c437ed536ed62bebbd3cf8b56febf86dc8"
+    "ff89b19fd94c3e98d02e375de133a82e3575a55db256ede3a636069216ad10c6"
+    "214f06e90a156d43dda9278f9dec29391cd1a0e9e0938401cd85e3f700c2ecd4"
+    "f046cd22ea39f334d345d00c543a1fc83e4fcefebe9cae145b74943bd7aa4170"
+    "a236a09faf759682844a3b45bc53d56961c6ca3484e717bc7fdfe7e949f075f7) == "
+    "0x920a37c5c03c82b14e49b39d7294e40701cf6c352eda28903cec71e01f187375"
+    "e7a5068b7530cc42bb1f9980c6e42c8748deb585c1c6e9685a1637fc841f38c3"
+    "4cd971281b268ea73bbc4fe6d40cd63310eae26772c43df3a3523d0bc6257b87"
+    "d6364fe8b909b2d8a2d46bb4894e7ec2d704a2d18107cff166ee450ecd72b9c6"
+    "86d9d608e54fdb81e18e76d0b19194fde50c0946ac43409b5c4b5499e0e197ac"
+    "472c0c109516feae6703dd07a4e1435c637635c5302804b6f52c677142d28c64"
+    "4236c454eeec44beecded3fb17bf679d5457a381e40773afe541d85d68b1939a"
+    "79a2ea61d08d27c44d51dc59896eb0fc5541ae81695d6714e20a411c46e27817");
+}
+
+/* --- Conversions --- */
+
+static void views(void)
+{
+  auto x = fixed_bignum<256>::from_hex("123456789abcdef0");
+  bignum v = x.view();
+  TEST_CHECK(bignum_check(&v) == OK);
+  TEST_CHECK(bignum_len_words(&v) == 2);
+
+  char buf[80];
+  TEST_CHECK(bignum_fmt_hex(&v, buf, sizeof buf) == OK);
+  TEST_CHECK(strcmp(buf, "0x123456789abcdef0") == 0);
+
+  /* Results written by C functions, with the limbs above cleared. */
+  fixed_bignum<256> r = p256;
+  bignum m = p256.view();
+  TEST_CHECK(bignum_mul(r.out(), &v, &bignum_base) == OK);
+  TEST_CHECK(r == fixed_bignum<256>::from_hex("123456789abcdef000000000"));
+
+  TEST_CHECK(bignum_sub(r.out(), &v, &bignum_base) == OK);
+  TEST_CHECK(r == fixed_bignum<256>::from_hex("123456779abcdef0"));
+
+  BIGNUM_TMP(big);
+  TEST_CHECK(bignum_mul(&big, &m, &m) == OK);
+  TEST_CHECK(r.assign(big) == error_bignum_sz);
+  TEST_CHECK(r.assign(bignum_neg1) == error_invalid_bignum);
+  TEST_CHECK(r.assign(bignum_base) == OK);
+  TEST_CHECK(r == fixed_bignum<256>(0x100000000));
+}
+
+TEST_LIST = {
+  { "views", views },
+  { "add", test_add },
+  { "sub", test_sub },
+  { "mul", test_mul },
+  { "sqr", test_sqr },
+  { "modmul", test_modmul },
+  { "modexp", test_modexp },
+  { "wide-modular", wide_modular },
+  { 0, 0 }
+};
@@ -0,0 +1,305 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "bignum-integer.hpp"
+#include "ext/cutest.h"
+#include "testvectors.hpp"
+
+using namespace bignum_cxx;
+
+/* --- Test vectors --- */
+
+static bool check_vector(const test_vector &vec, const char *expr)
+{
+  std::vector<integer> a(vec.args.begin(), vec.args.end());
+  integer want(vec.want), got;
+  const std::string &op = vec.op;
+
+  if (op == "add")
+    got = a[0] + a[1];
+  else if (op == "sub")
+    got = a[0] - a[1];
+  else if (op == "mul")
+    got = a[0] * a[1];
+  else if (op == "sqr")
+    got = a[0] * a[0];
+  else if (op == "div")
+    got = a[0] / a[1];
+  else if (op == "mod")
+    got = a[0] % a[1];
+  else if (op == "shl")
+    got = a[0] << a[1].view().v[0];
+  else if (op == "shr")
+    got = a[0] >> a[1].view().v[0];
+  else if (op == "modmul")
+    got = mul_mod(a[0], a[1], a[2]);
+  else if (op == "modexp")
+    got = pow_mod(a[0], a[1], a[2]);
+  else if (op == "modinv")
+    got = inverse_mod(a[0], a[1]);
+  else if (op == "gcd")
+    got = gcd(a[0], a[1]);
+  else if (op == "sqrt")
+    got = sqrt(a[0]);
+  else
+    abort();
+
+  TEST_CHECK_(got == want, "%s gave %s", expr, got.to_string().c_str());
+  return true;
+}
+
+/* --- Storage --- */
+
+static void storage(void)
+{
+  integer small = 0xffffffffffffffffull;
+  TEST_CHECK(small.is_inline());
+  TEST_CHECK(small.words() == 2);
+
+  /* 2^128 doesn't fit in four words. */
+  integer big = small * small;
+  TEST_CHECK(big.is_inline());
+  big *= big;
+  TEST_CHECK(!big.is_inline());
+  TEST_CHECK(big.view().flags & BIGNUM_F_GROWABLE);
+  TEST_CHECK(big.to_string(16) == "0x" "fffffffffffffffc" "0000000000000005"
+                                       "fffffffffffffffc" "0000000000000001");
+
+  /* Moves steal heap storage, and leave zero behind.  Reserve
+   * first, so nothing below needs to reallocate. */
+  big.reserve(16);
+  const uint32_t *v = big.view().v;
+  integer moved = std::move(big);
+  TEST_CHECK(moved.view().v == v);
+  TEST_CHECK(big.is_zero() && big.is_inline());
+
+  /* Inline values are copied. */
+  integer also = std::move(small);
+  TEST_CHECK(also.is_inline());
+  TEST_CHECK(also == 0xffffffffffffffffull);
+  TEST_CHECK(small == 0);
+
+  /* Results reuse the storage of rvalue operands. */
+  integer sum = std::move(moved) + 1;
+  TEST_CHECK(sum.view().v == v);
+  sum = std::move(sum) - also;
+  TEST_CHECK(sum.view().v == v);
+
+  /* Copies are deep. */
+  integer copy = sum;
+  TEST_CHECK(copy.view().v != v);
+  TEST_CHECK(copy == sum);
+  copy += 1;
+  TEST_CHECK(copy != sum);
+
+  /* Assignment from a smaller value keeps the storage. */
+  copy = also;
+  TEST_CHECK(!copy.is_inline());
+  TEST_CHECK(copy == also);
+
+  /* Self assignment is harmless. */
+  integer &self = copy;
+  copy = self;
+  copy = std::move(self);
+  TEST_CHECK(copy == also);
+}
+
+static void aliasing(void)
+{
+  integer x = 12345;
+  x *= x;
+  TEST_CHECK(x == 152399025);
+  x = x * x;
+  TEST_CHECK(x == integer("23225462820950625"));
+  x += x;
+  TEST_CHECK(x == integer("46450925641901250"));
+  x -= x;
+  TEST_CHECK(x.is_zero());
+
+  /* 50! built in place. */
+  integer f = 1;
+  for (int i = 2; i <= 50; i++)
+    f *= i;
+  TEST_CHECK(f.to_string() ==
+             "30414093201713378043612608166064768844377641568960512000000000000");
+
+  integer q = f;
+  for (int i = 50; i >= 2; i--)
+    q /= i;
+  TEST_CHECK(q == 1);
+
+  auto [d, m] = divmod(f + 7, integer(1) << 100);
+  TEST_CHECK(d == f >> 100);
+  TEST_CHECK(m == (f + 7) % (integer(1) << 100));
+}
+
+static void conversions(void)
+{
+  TEST_CHECK(integer(-5).to_string() == "-5");
+  TEST_CHECK(integer(-5).sign() == -1);
+  TEST_CHECK(integer(0).sign() == 0);
+  TEST_CHECK((-integer(7)).sign() == -1);
+  TEST_CHECK(-(-integer(7)) == 7);
+  TEST_CHECK(integer(INT64_MIN).to_string() == "-9223372036854775808");
+  TEST_CHECK(integer(UINT64_MAX).to_string(16) == "0xffffffffffffffff");
+  TEST_CHECK(integer::parse("-zz", 36) == -1295);
+  TEST_CHECK(integer("0x10").to_string(2) == "10000");
+  TEST_CHECK(integer(3) < integer(4) && integer(-3) > -4 && integer(3) <= 3);
+
+  integer neg("-123456789012345678901234567890123456789");
+  TEST_CHECK(gcd(integer(0), neg) == -neg);
+  TEST_CHECK(gcd(neg, 0) == -neg);
+  TEST_CHECK(gcd(integer(0), 0) == 0);
+
+  std::ostringstream os;
+  os << integer("123456789012345678901234567890");
+  TEST_CHECK(os.str() == "123456789012345678901234567890");
+
+  /* A big parse spills to the heap. */
+  std::string digits(600, '7');
+  integer big(digits);
+  TEST_CHECK(!big.is_inline());
+  TEST_CHECK(big.to_string() == digits);
+
+  /* Results of C functions. */
+  integer r;
+  TEST_CHECK(bignum_mul(r.out(big.words() * 2), &big.view(), &big.view()) == OK);
+  TEST_CHECK(r == big * big);
+}
+
+static void expressions(void)
+{
+  integer a("0x123456789abcdef0123456789abcdef0123456789abcdef");
+  integer b("-0xfedcba9876543210fedcba9876543210fedcba98765432");
+  integer c("0x1000000000000000000000000000000000000000000000000001");
+  integer d = 12345;
+
+  /* The same, a step at a time. */
+  integer ab = a * b, cd = c * d, aa = a * a, bb = b * b;
+
+  integer r = a * b + c * d - a;
+  TEST_CHECK(r == ab + cd - a);
+  r = a * b - c;
+  TEST_CHECK(r == ab - c);
+  r = c - a * b;
+  TEST_CHECK(r == c - ab);
+  r = -(a * b) + 1;
+  TEST_CHECK(r == 1 - ab);
+  r = a * a - b * b;
+  TEST_CHECK(r == aa - bb);
+  r = a * b + c * d + a * a - b * b + d;
+  TEST_CHECK(r == ab + cd + aa - bb + d);
+  r = 2 * a + 3 * b;
+  TEST_CHECK(r == a + a + b + b + b);
+
+  /* Evaluation uses the destination's storage. */
+  r.reserve(64);
+  const uint32_t *v = r.view().v;
+  r = a * b + c;
+  TEST_CHECK(r == ab + c);
+  r += c * d;
+  TEST_CHECK(r == ab + c + cd);
+  r -= a * a + b;
+  TEST_CHECK(r == ab + c + cd - aa - b);
+  TEST_CHECK(r.view().v == v);
+
+  /* Destinations which are also operands. */
+  integer x = a;
+  x = x * b + x;
+  TEST_CHECK(x == ab + a);
+  x = a;
+  x += x * x;
+  TEST_CHECK(x == a + aa);
+  x = a;
+  x -= x * x;
+  TEST_CHECK(x == a - aa);
+  x = a;
+  x *= x;
+  TEST_CHECK(x == aa);
+
+  /* Modular products. */
+  integer m("0xffffffff00000001000000000000000000000000ffffffffffffffffffffffff");
+  integer pa = a, pb = -b;
+  TEST_CHECK(pa * pb % m == integer(pa * pb) % m);
+  TEST_CHECK((pa * pb + c) % m == integer(pa * pb + c) % m);
+
+  modulus mod(m);
+  TEST_CHECK(mod.kind() == REDUCE_P256);
+  TEST_CHECK(pa * pb % mod == integer(pa * pb) % m);
+  TEST_CHECK(c % mod == c % m);
+  TEST_CHECK(mod.pow(pa, 65537) == pow_mod(pa, 65537, m));
+
+  integer p25519 = (integer(1) << 255) - 19;
+  modulus curve25519(p25519);
+  TEST_CHECK(curve25519.kind() == REDUCE_PSEUDO_MERSENNE);
+  TEST_CHECK(pa * pb % curve25519 == integer(pa * pb) % p25519);
+  TEST_CHECK(curve25519.pow(pa, p25519 - 1) == 1);
+
+  modulus even(m + 1);
+  TEST_CHECK(even.kind() == REDUCE_GENERIC);
+  TEST_CHECK(pa * pb % even == integer(pa * pb) % (m + 1));
+  TEST_CHECK(even.pow(pa, 3) == pow_mod(pa, 3, m + 1));
+
+  try
+  {
+    modulus zero(0);
+    TEST_CHECK(!"no exception");
+  } catch (const bignum_error &e) {
+    TEST_CHECK(e.code() == error_invalid_bignum);
+  }
+}
+
+static void errors(void)
+{
+  try
+  {
+    integer x = integer(1) / 0;
+    TEST_CHECK(!"no exception");
+  } catch (const bignum_error &e) {
+    TEST_CHECK(e.code() == error_div_zero);
+  }
+
+  try
+  {
+    integer x("12z");
+    TEST_CHECK(!"no exception");
+  } catch (const bignum_error &e) {
+    TEST_CHECK(e.code() == error_invalid_string);
+  }
+
+  try
+  {
+    integer x = inverse_mod(6, 9);
+    TEST_CHECK(!"no exception");
+  } catch (const bignum_error &e) {
+    TEST_CHECK(e.code() == error_no_inverse);
+  }
+}
+
+TEST_LIST = {
+  { "storage", storage },
+  { "aliasing", aliasing },
+  { "conversions", conversions },
+  { "errors", errors },
+  { "expressions", expressions },
+  { "add", test_add },
+  { "sub", test_sub },
+  { "mul", test_mul },
+  { "sqr", test_sqr },
+  { "div", test_div },
+  { "mod", test_mod },
+  { "shl", test_shl },
+  { "shr", test_shr },
+  { "modmul", test_modmul },
+  { "modexp", test_modexp },
+  { "modinv", test_modinv },
+  { "gcd", test_gcd },
+  { "sqrt", test_sqrt },
+  { 0, 0 }
+};
@@ -107,6 +107,50 @@ static void test_dstr_basic(void)
   dstr_free(&d);
 }
 
+static void test_dstr_grow(void)
+{
+  dstr d;
+  dstr_init(&d);
+
+  /* Doubling means few reallocations. */
+  unsigned moves = 0;
+  char *last = NULL;
+  for (size_t i = 0; i < 1 << 20; i++)
+  {
+    TEST_CHECK(dstr_putc(&d, 'A') == 0);
+    if (d.start != last)
+      moves++;
+    last = d.start;
+  }
+  TEST_CHECK(dstr_used(&d) == 1 << 20);
+  TEST_CHECK(moves < 20);
+  dstr_free(&d);
+
+  /* Reserve allocates once, up front. */
+  dstr_init(&d);
+  TEST_CHECK(dstr_reserve(&d, 100000) == 0);
+  TEST_CHECK(dstr_allocated(&d) >= 100000);
+  last = d.start;
+  for (size_t i = 0; i < 100000; i++)
+    dstr_putc(&d, 'B');
+  TEST_CHECK(d.start == last);
+  TEST_CHECK(dstr_reserve(&d, 10) == 0);
+  TEST_CHECK(dstr_used(&d) == 100000);
+  dstr_free(&d);
+
+  /* A format longer than the space left. */
+  dstr_init(&d);
+  char big[2000];
+  memset(big, 'c', sizeof big - 1);
+  big[sizeof big - 1] = 0;
+  TEST_CHECK(dstr_puts(&d, "x") == 0);
+  TEST_CHECK(dstr_putf(&d, "%s!", big) == 0);
+  TEST_CHECK(dstr_put0(&d) == 0);
+  TEST_CHECK(strlen(d.start) == 1 + strlen(big) + 1);
+  TEST_CHECK(d.start[sizeof big] == '!');
+  dstr_free(&d);
+}
+
 static void test_dstr_hex(void)
 {
   dstr d;
@@ -121,6 +165,7 @@ TEST_LIST = {
   { "sstr-take", test_sstr_take },
   { "sstr-peek", test_sstr_peek },
   { "dstr-basic", test_dstr_basic },
+  { "dstr-grow", test_dstr_grow },
   { "dstr-hex", test_dstr_hex },
   { 0 }
 };
@@ -0,0 +1,163 @@
+#ifndef TESTVECTORS_HPP
+#define TESTVECTORS_HPP
+
+/*
+ * Runs the generated test-*.inc vectors in the C++ tests.
+ *
+ * Each vector is a string "op(a, b, ...) == want".  The including
+ * file defines check_vector, which checks one vector and returns
+ * false if it can't (an operation or size it doesn't support);
+ * the test_* functions here run each file of vectors through it.
+ * Put the ones you support in your TEST_LIST.
+ *
+ * Include this after ext/cutest.h, which can only be included once.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+struct test_vector
+{
+  std::string op;
+  std::vector<std::string_view> args;
+  std::string_view want;
+};
+
+static bool check_vector(const test_vector &vec, const char *expr);
+
+static std::string_view trim(const char *start, const char *end)
+{
+  while (start < end && *start == ' ')
+    start++;
+  while (end > start && end[-1] == ' ')
+    end--;
+  return std::string_view(start, end - start);
+}
+
+/* Splits "op(a, b, ...) == want" into op, arguments and want. */
+static test_vector parse_vector(const char *expr)
+{
+  const char *open = strchr(expr, '(');
+  const char *close = strstr(expr, ") == ");
+  assert(open && close);
+
+  test_vector vec;
+  vec.op.assign(expr, open - expr);
+
+  for (const char *start = open + 1; start < close; )
+  {
+    const char *comma = strchr(start, ',');
+    const char *end = comma && comma < close ? comma : close;
+    vec.args.push_back(trim(start, end));
+    start = end + 1;
+  }
+
+  vec.want = trim(close + 5, close + 5 + strlen(close + 5));
+  return vec;
+}
+
+static size_t checked, skipped;
+
+static void check(const char *expr)
+{
+  if (check_vector(parse_vector(expr), expr))
+    checked++;
+  else
+    skipped++;
+}
+
+static void report(const char *op)
+{
+  printf("%s: %zu vectors checked, %zu skipped\n", op, checked, skipped);
+  TEST_CHECK(checked > 0);
+  checked = skipped = 0;
+}
+
+#define VECTOR_TEST [[maybe_unused]] static void
+
+VECTOR_TEST test_add(void)
+{
+#include "test-add.inc"
+  report("add");
+}
+
+VECTOR_TEST test_sub(void)
+{
+#include "test-sub.inc"
+  report("sub");
+}
+
+VECTOR_TEST test_mul(void)
+{
+#include "test-mul.inc"
+  report("mul");
+}
+
+VECTOR_TEST test_sqr(void)
+{
+#include "test-sqr.inc"
+  report("sqr");
+}
+
+VECTOR_TEST test_div(void)
+{
+#include "test-div.inc"
+  report("div");
+}
+
+VECTOR_TEST test_mod(void)
+{
+#include "test-mod.inc"
+  report("mod");
+}
+
+VECTOR_TEST test_shl(void)
+{
+#include "test-shl.inc"
+  report("shl");
+}
+
+VECTOR_TEST test_shr(void)
+{
+#include "test-shr.inc"
+  report("shr");
+}
+
+VECTOR_TEST test_modmul(void)
+{
+#include "test-modmul.inc"
+  report("modmul");
+}
+
+VECTOR_TEST test_modexp(void)
+{
+#include "test-modexp.inc"
+  report("modexp");
+}
+
+VECTOR_TEST test_modinv(void)
+{
+#include "test-modinv.inc"
+  report("modinv");
+}
+
+VECTOR_TEST test_gcd(void)
+{
+#include "test-gcd.inc"
+  report("gcd");
+}
+
+VECTOR_TEST test_sqrt(void)
+{
+#include "test-sqrt.inc"
+  report("sqrt");
+}
+
+#undef VECTOR_TEST
+
+#endif
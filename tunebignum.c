@@ -0,0 +1,240 @@
+/*
+ * Finds the bignum library's algorithm crossovers on this machine,
+ * and writes them as a header to stdout.
+ *
+ * Each crossover is a threshold size in words, at and above which
+ * a function switches to an asymptotically faster algorithm.  For
+ * each size n, in steps of about an eighth, the tuner times the
+ * function with the threshold just above n (the simple algorithm)
+ * and at n (one step of the fast algorithm, which then falls back
+ * to the simple one for its smaller parts).  The crossover is the
+ * first n where the fast algorithm wins at n and the next two sizes
+ * too, so that one lucky timing doesn't decide it.
+ *
+ * make tune writes bignum-tune.h, and the library is built with it
+ * from then on.  Remove it and make clean to go back to the
+ * defaults.  Tune an optimised build, or the thresholds will suit
+ * -O0.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "bignum.h"
+#include "bignum-str.h"
+#include "handy.h"
+
+/* --- Timing --- */
+
+/* Timed batches per measurement.  The fastest is used. */
+#define SAMPLES 5
+
+/* Least duration of a batch, in ns. */
+#define SAMPLE_NS 1e6
+
+/* Wins in a row which make a crossover. */
+#define WINS 3
+
+static double now_ns(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static uint64_t rng_state = 0x9e3779b97f4a7c15ull;
+
+static uint32_t rng(void)
+{
+  rng_state ^= rng_state >> 12;
+  rng_state ^= rng_state << 25;
+  rng_state ^= rng_state >> 27;
+  return (uint32_t) ((rng_state * 0x2545f4914f6cdd1dull) >> 32);
+}
+
+/* --- Crossovers --- */
+
+typedef struct
+{
+  bignum a, r;
+  char *text;
+  size_t text_len;
+} operands;
+
+static char text_buf[BIGNUM_MAX_WORDS * 10 + 8];
+static char fmt_buf[BIGNUM_MAX_WORDS * 10 + 8];
+
+static error setup_dec(operands *o, size_t words)
+{
+  ER(bignum_cleartop(&o->a, words));
+  for (size_t i = 0; i < words; i++)
+    o->a.v[i] = rng();
+  o->a.v[words - 1] |= 0x80000000;
+  bignum_canon(&o->a);
+
+  ER(bignum_fmt_dec(&o->a, text_buf, sizeof text_buf));
+  o->text = text_buf;
+  o->text_len = strlen(text_buf);
+  return OK;
+}
+
+/* One threshold covers both directions. */
+static error run_dec(operands *o)
+{
+  ER(bignum_fmt_dec(&o->a, fmt_buf, sizeof fmt_buf));
+  return bignum_parse_strl(&o->r, o->text, o->text_len);
+}
+
+typedef struct
+{
+  /* Macro the library's default is overridden by. */
+  const char *macro;
+  const char *desc;
+
+  /* The threshold, which the library reads at run time. */
+  size_t *threshold;
+
+  /* Least size worth trying. */
+  size_t min_words;
+
+  error (*setup)(operands *o, size_t words);
+  error (*run)(operands *o);
+} crossover;
+
+static const crossover crossovers[] = {
+  { "BIGNUM_DEC_DC_THRESHOLD", "Decimal conversion by divide and conquer",
+    &bignum_dec_dc_threshold, 2, setup_dec, run_dec },
+};
+
+/* Sets *ns to the fastest time for one run of x, with the threshold
+ * at threshold. */
+static error time_run(const crossover *x, operands *o, size_t threshold, double *ns)
+{
+  *x->threshold = threshold;
+
+  /* Calibrate, which also warms up. */
+  size_t iterations = 1;
+  double t;
+  for (;;)
+  {
+    double start = now_ns();
+    for (size_t i = 0; i < iterations; i++)
+      ER(x->run(o));
+    t = now_ns() - start;
+    if (t >= SAMPLE_NS)
+      break;
+    iterations *= 2;
+  }
+
+  double best = t;
+  for (unsigned s = 0; s < SAMPLES; s++)
+  {
+    double start = now_ns();
+    for (size_t i = 0; i < iterations; i++)
+      ER(x->run(o));
+    best = MIN(best, now_ns() - start);
+  }
+
+  *ns = best / iterations;
+  return OK;
+}
+
+/* Sets *found to x's crossover, or 0 if the fast algorithm never
+ * wins up to BIGNUM_MAX_WORDS. */
+static error tune(const crossover *x, size_t *found)
+{
+  size_t saved = *x->threshold;
+  size_t start = 0;
+  unsigned wins = 0;
+  error err = OK;
+
+  operands o;
+  ER(bignum_init_growable(&o.a, BIGNUM_MAX_WORDS, NULL));
+  err = bignum_init_growable(&o.r, BIGNUM_MAX_WORDS, NULL);
+  if (err)
+  {
+    bignum_clear(&o.a);
+    return err;
+  }
+
+  *found = 0;
+  for (size_t n = x->min_words; n <= BIGNUM_MAX_WORDS && wins < WINS; n += MAX(n / 8, (size_t) 1))
+  {
+    double simple, fast;
+
+    EG(x->setup(&o, n));
+    EG(time_run(x, &o, n + 1, &simple));
+    EG(time_run(x, &o, n, &fast));
+
+    fprintf(stderr, "%s: %4zu words: %12.1f ns, split %12.1f ns%s\n",
+            x->macro, n, simple, fast, fast < simple ? "  *" : "");
+
+    if (fast < simple)
+    {
+      if (wins++ == 0)
+        start = n;
+    } else {
+      wins = 0;
+    }
+  }
+
+  if (wins == WINS)
+    *found = start;
+
+x_err:
+  *x->threshold = saved;
+  bignum_clear(&o.a);
+  bignum_clear(&o.r);
+  return err;
+}
+
+int main(int argc, char **argv)
+{
+  if (argc > 1)
+  {
+    fprintf(stderr, "usage: tunebignum > bignum-tune.h\n");
+    return 2;
+  }
+
+  printf("#ifndef BIGNUM_TUNE_H\n"
+         "#define BIGNUM_TUNE_H\n"
+         "\n"
+         "/*\n"
+         " * Algorithm crossovers for this machine, written by tunebignum.\n"
+         " */\n");
+
+  for (size_t i = 0; i < ARRAYCOUNT(crossovers); i++)
+  {
+    const crossover *x = &crossovers[i];
+    size_t found;
+
+    error err = tune(x, &found);
+    if (err)
+    {
+      fprintf(stderr, "tuning %s failed: error %d\n", x->macro, err);
+      return 1;
+    }
+
+    printf("\n/* %s: ", x->desc);
+    if (found)
+      printf("from %zu words. */\n", found);
+    else
+      printf("never faster up to %d words. */\n", BIGNUM_MAX_WORDS);
+
+    /* Never faster: keep it off. */
+    printf("#ifndef %s\n", x->macro);
+    if (found)
+      printf("# define %s %zu\n", x->macro, found);
+    else
+      printf("# define %s SIZE_MAX\n", x->macro);
+    printf("#endif\n");
+  }
+
+  printf("\n#endif\n");
+  return 0;
+}